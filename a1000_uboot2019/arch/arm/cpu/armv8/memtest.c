@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Fast zero fill for the memory test, using DC ZVA
+ */
+
+#include <common.h>
+#include <memtest.h>
+#include <asm/system.h>
+
+#define DCZID_DZP		(1 << 4)	/* DC ZVA prohibited */
+#define DCZID_BS_MASK		0xf		/* log2 of the block size in words */
+
+void arch_memtest_zero(void *buf, ulong size)
+{
+	ulong dczid, block, start, end, addr;
+
+	asm volatile("mrs %0, dczid_el0" : "=r" (dczid));
+	/* DC ZVA faults on Device memory, which all memory is with the MMU off */
+	if ((dczid & DCZID_DZP) || !(get_sctlr() & CR_M)) {
+		memset(buf, '\0', size);
+		return;
+	}
+
+	block = 4UL << (dczid & DCZID_BS_MASK);
+	start = (ulong)buf;
+	end = start + size;
+	addr = min(ALIGN(start, block), end);
+	memset(buf, '\0', addr - start);
+	for (; addr + block <= end; addr += block)
+		asm volatile("dc zva, %0" : : "r" (addr) : "memory");
+	memset((void *)addr, '\0', end - addr);
+}
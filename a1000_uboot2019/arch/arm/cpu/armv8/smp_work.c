@@ -0,0 +1,243 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Starting and parking the secondary CPUs for parallel work
+ *
+ * The CPUs listed in the device tree are started with the enable-method
+ * the OS would use: with "spin-table" they are released from the spin table
+ * they wait in and go back there, with "psci" they are turned on and off by
+ * the PSCI firmware.
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <malloc.h>
+#include <smp_work.h>
+#include <asm/cache.h>
+#include <asm/spin_table.h>
+#include <asm/system.h>
+#include <asm/armv8/mmu.h>
+#include <asm/armv8/smp_work.h>
+#include <linux/sizes.h>
+#ifdef CONFIG_ARM_PSCI_FW
+#include <linux/psci.h>
+#endif
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define SMP_WORK_STACK_SIZE	SZ_16K
+/* How long the CPUs have to arrive in smp_work_entry() and to park */
+#define SMP_WORK_TIMEOUT_MS	100
+
+struct smp_work_arch smp_work_arch __aligned(SMP_WORK_CPU_SIZE);
+static void *smp_work_stacks;
+
+static void smp_work_flush(void *start, size_t size)
+{
+	flush_dcache_range((ulong)start, (ulong)start + size);
+}
+
+/* Read the state a CPU wrote with its MMU and caches off */
+static u32 smp_work_cpu_state(struct smp_work_cpu *wc)
+{
+	invalidate_dcache_range((ulong)wc, (ulong)(wc + 1));
+
+	return READ_ONCE(wc->state);
+}
+
+/* Wait for @count CPUs to reach @state */
+static int smp_work_wait_state(uint count, u32 state)
+{
+	ulong start = get_timer(0);
+	uint i;
+
+	for (i = 0; i < count; i++) {
+		while (smp_work_cpu_state(&smp_work_arch.cpu[i]) < state) {
+			if (get_timer(start) > SMP_WORK_TIMEOUT_MS)
+				return -ETIMEDOUT;
+			udelay(10);
+		}
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_ARM_PSCI_FW
+static int smp_work_psci_park(uint *parkp)
+{
+	struct udevice *dev;
+	const char *method;
+	int ret;
+
+	/* probing the driver sets up invoke_psci_fn() */
+	ret = uclass_get_device_by_driver(UCLASS_FIRMWARE,
+					  DM_GET_DRIVER(psci), &dev);
+	if (ret)
+		return ret;
+	method = dev_read_string(dev, "method");
+	if (!method)
+		return -EINVAL;
+	*parkp = strcmp(method, "smc") ? SMP_WORK_PARK_PSCI_HVC :
+					 SMP_WORK_PARK_PSCI_SMC;
+
+	return 0;
+}
+
+static int smp_work_psci_start(struct smp_work_arch *swa)
+{
+	int i, ret;
+
+	for (i = 0; i < swa->ncpus; i++) {
+		ret = invoke_psci_fn(PSCI_0_2_FN64_CPU_ON, swa->cpu[i].mpidr,
+				     (ulong)smp_work_entry, 0);
+		if (ret) {
+			/* the CPUs after this one are not ours any more */
+			swa->ncpus = i;
+			smp_work_flush(swa, sizeof(*swa));
+			break;
+		}
+	}
+	if (!i)
+		return -EIO;
+	ret = smp_work_wait_state(i, SMP_WORK_CPU_ENTERED);
+
+	return ret ? ret : i;
+}
+#endif
+
+int arch_smp_work_start(uint max_cpus)
+{
+	struct smp_work_arch *swa = &smp_work_arch;
+	u64 self = read_mpidr() & SMP_WORK_MPIDR_MASK;
+	const char *method = NULL;
+	ofnode cpus, node;
+	uint ncpus = 0;
+	int i, ret;
+
+	BUILD_BUG_ON(offsetof(struct smp_work_arch, tcr) != SMP_WORK_TCR);
+	BUILD_BUG_ON(offsetof(struct smp_work_arch, park) != SMP_WORK_PARK);
+	BUILD_BUG_ON(offsetof(struct smp_work_arch, ncpus) != SMP_WORK_NCPUS);
+	BUILD_BUG_ON(offsetof(struct smp_work_arch, cpu) != SMP_WORK_CPU);
+	BUILD_BUG_ON(offsetof(struct smp_work_cpu, state) !=
+		     SMP_WORK_CPU_STATE);
+	BUILD_BUG_ON(offsetof(struct smp_work_cpu, cpu) != SMP_WORK_CPU_NUM);
+
+	/* the CPUs share this CPU's translation tables and caches */
+	if (!dcache_status())
+		return -EPERM;
+	cpus = ofnode_path("/cpus");
+	if (!ofnode_valid(cpus))
+		return -ENODEV;
+	if (!smp_work_stacks) {
+		smp_work_stacks = memalign(ARCH_DMA_MINALIGN,
+					   (CONFIG_SMP_WORK_MAX_CPUS - 1) *
+					   SMP_WORK_STACK_SIZE);
+		if (!smp_work_stacks)
+			return -ENOMEM;
+	}
+
+	ofnode_for_each_subnode(node, cpus) {
+		struct smp_work_cpu *wc = &swa->cpu[ncpus];
+		const char *str;
+		const fdt32_t *reg;
+		u64 mpidr;
+		int len;
+
+		str = ofnode_read_string(node, "device_type");
+		if (!str || strcmp(str, "cpu"))
+			continue;
+		reg = ofnode_get_property(node, "reg", &len);
+		if (!reg || (len != 4 && len != 8))
+			continue;
+		mpidr = len == 8 ? fdt64_to_cpu(*(const fdt64_t *)reg) :
+				   fdt32_to_cpu(*reg);
+		if (mpidr == self)
+			continue;
+		str = ofnode_read_string(node, "enable-method");
+		if (!str || (method && strcmp(str, method)))
+			return -ENOSYS;
+		method = str;
+		if (ncpus == max_cpus)
+			break;
+
+		wc->mpidr = mpidr;
+		wc->stack = (ulong)smp_work_stacks +
+			    (ncpus + 1) * SMP_WORK_STACK_SIZE;
+		wc->state = 0;
+		wc->cpu = ++ncpus;
+	}
+	if (!ncpus)
+		return 0;
+
+	if (!strcmp(method, "spin-table") &&
+	    IS_ENABLED(CONFIG_ARMV8_SPIN_TABLE)) {
+		swa->park = SMP_WORK_PARK_SPIN_TABLE;
+#ifdef CONFIG_ARM_PSCI_FW
+	} else if (!strcmp(method, "psci")) {
+		ret = smp_work_psci_park(&swa->park);
+		if (ret)
+			return ret;
+#endif
+	} else {
+		return -ENOSYS;
+	}
+
+	swa->ttbr = gd->arch.tlb_addr;
+	swa->mair = MEMORY_ATTRIBUTES;
+	for (i = 1; i <= 3; i++)
+		swa->tcr[i] = get_tcr(i, NULL, NULL);
+	swa->ncpus = ncpus;
+	smp_work_flush(swa, sizeof(*swa));
+
+#ifdef CONFIG_ARMV8_SPIN_TABLE
+	if (swa->park == SMP_WORK_PARK_SPIN_TABLE) {
+		/*
+		 * With ARMV8_MULTIENTRY the CPUs may still wait for the SGI
+		 * that lets them into the spin table.
+		 */
+		smp_kick_all_cpus();
+		spin_table_cpu_release_addr = (ulong)smp_work_entry;
+		smp_work_flush(&spin_table_cpu_release_addr, sizeof(u64));
+		asm volatile("sev");
+		ret = smp_work_wait_state(ncpus, SMP_WORK_CPU_ENTERED);
+		/* the next release is the OS's */
+		spin_table_cpu_release_addr = 0;
+		smp_work_flush(&spin_table_cpu_release_addr, sizeof(u64));
+
+		return ret ? ret : ncpus;
+	}
+#endif
+#ifdef CONFIG_ARM_PSCI_FW
+	return smp_work_psci_start(swa);
+#else
+	return -ENOSYS;
+#endif
+}
+
+void arch_smp_work_stop(void)
+{
+	struct smp_work_arch *swa = &smp_work_arch;
+	ulong start = get_timer(0);
+	int i;
+
+	for (i = 0; i < swa->ncpus; i++) {
+		struct smp_work_cpu *wc = &swa->cpu[i];
+
+		while (smp_work_cpu_state(wc) == SMP_WORK_CPU_ENTERED) {
+			if (get_timer(start) > SMP_WORK_TIMEOUT_MS) {
+				printf("CPU %llx did not park\n", wc->mpidr);
+				break;
+			}
+			udelay(10);
+		}
+	}
+}
+
+void arch_smp_work_wait(void)
+{
+	asm volatile("wfe");
+}
+
+void arch_smp_work_wake(void)
+{
+	asm volatile("dsb sy\n\tsev" : : : "memory");
+}
@@ -0,0 +1,58 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * State shared with the secondary CPUs started for parallel work
+ */
+
+#ifndef _ASM_ARMV8_SMP_WORK_H_
+#define _ASM_ARMV8_SMP_WORK_H_
+
+/* Offsets in struct smp_work_arch, used by smp_work_entry.S */
+#define SMP_WORK_TTBR		0x00
+#define SMP_WORK_MAIR		0x08
+#define SMP_WORK_TCR		0x10	/* one for each exception level */
+#define SMP_WORK_PARK		0x30
+#define SMP_WORK_NCPUS		0x34
+#define SMP_WORK_CPU		0x40
+
+/* Offsets in struct smp_work_cpu, which is one cache line */
+#define SMP_WORK_CPU_MPIDR	0x00
+#define SMP_WORK_CPU_STACK	0x08
+#define SMP_WORK_CPU_STATE	0x10
+#define SMP_WORK_CPU_NUM	0x14
+#define SMP_WORK_CPU_SIZE	0x40
+
+/* MPIDR_EL1 affinity fields */
+#define SMP_WORK_MPIDR_MASK	0xff00ffffff
+
+/* How a CPU is parked: back to the spin table, or PSCI CPU_OFF */
+#define SMP_WORK_PARK_SPIN_TABLE	0
+#define SMP_WORK_PARK_PSCI_HVC		1
+#define SMP_WORK_PARK_PSCI_SMC		2
+
+/* CPU state, written by the CPU with its MMU off */
+#define SMP_WORK_CPU_ENTERED	1
+#define SMP_WORK_CPU_PARKED	2
+
+#ifndef __ASSEMBLY__
+
+struct smp_work_cpu {
+	u64 mpidr;
+	u64 stack;
+	u32 state;
+	u32 cpu;	/* number passed to smp_work_secondary() */
+} __aligned(SMP_WORK_CPU_SIZE);
+
+struct smp_work_arch {
+	u64 ttbr;
+	u64 mair;
+	u64 tcr[4];
+	u32 park;
+	u32 ncpus;
+	struct smp_work_cpu cpu[CONFIG_SMP_WORK_MAX_CPUS - 1];
+};
+
+void smp_work_entry(void);
+
+#endif /* __ASSEMBLY__ */
+
+#endif /* _ASM_ARMV8_SMP_WORK_H_ */
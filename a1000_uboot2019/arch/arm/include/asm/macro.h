@@ -77,6 +77,24 @@ lr	.req	x30
 	b.eq	\el1_label
 .endm
 
+/*
+ * Branch if the MMU is off at the current exception level. All memory
+ * is Device memory then, which faults on unaligned accesses.
+ */
+.macro	branch_if_mmu_off, xreg, label
+	switch_el \xreg, .Lmmu_el3\@, .Lmmu_el2\@, .Lmmu_el1\@
+.Lmmu_el3\@:
+	mrs	\xreg, sctlr_el3
+	b	.Lmmu_check\@
+.Lmmu_el2\@:
+	mrs	\xreg, sctlr_el2
+	b	.Lmmu_check\@
+.Lmmu_el1\@:
+	mrs	\xreg, sctlr_el1
+.Lmmu_check\@:
+	tbz	\xreg, #0, \label
+.endm
+
 /*
  * Branch if current processor is a Cortex-A57 core.
  */
@@ -176,6 +176,22 @@ static inline unsigned long read_mpidr(void)
 	return val;
 }
 
+/*
+ * ID_AA64ISAR0_EL1 fields, non-zero if the instructions are implemented
+ */
+#define ID_AA64ISAR0_SHA1_SHIFT		8
+#define ID_AA64ISAR0_SHA2_SHIFT		12
+#define ID_AA64ISAR0_CRC32_SHIFT	16
+
+static inline unsigned int id_aa64isar0_field(int shift)
+{
+	unsigned long val;
+
+	asm volatile("mrs %0, id_aa64isar0_el1" : "=r" (val));
+
+	return (val >> shift) & 0xf;
+}
+
 #define BSP_COREID	0
 
 void __asm_flush_dcache_all(void);
@@ -25,6 +25,7 @@
 #include <asm/secure.h>
 #include <linux/compiler.h>
 #include <bootm.h>
+#include <smp_work.h>
 #include <vxworks.h>
 
 #ifdef CONFIG_ARMV7_NONSEC
@@ -101,6 +102,8 @@ static void announce_and_cleanup(int fake)
 #endif
 
 	board_quiesce_devices();
+	/* The secondary CPUs go back to where the OS expects them */
+	smp_work_stop();
 
 	printf("\nStarting kernel ...%s\n\n", fake ?
 		"(fake run for tracing)" : "");
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Simulated RAM faults for testing the memory test engine
+ */
+
+#include <common.h>
+#include <mapmem.h>
+#include <memtest.h>
+#include <asm/test.h>
+
+#define SANDBOX_MEMTEST_MAX_FAULTS	4
+
+/* A word with stuck-at bits */
+struct sandbox_memtest_fault {
+	ulong addr;
+	u64 mask;
+	u64 value;
+};
+
+static struct sandbox_memtest_fault faults[SANDBOX_MEMTEST_MAX_FAULTS];
+static uint num_faults;
+
+int sandbox_memtest_add_fault(ulong addr, u64 mask, u64 value)
+{
+	struct sandbox_memtest_fault *fault;
+
+	if (addr & (sizeof(u64) - 1))
+		return -EINVAL;
+	if (num_faults == SANDBOX_MEMTEST_MAX_FAULTS)
+		return -ENOSPC;
+	fault = &faults[num_faults++];
+	fault->addr = addr;
+	fault->mask = mask;
+	fault->value = value & mask;
+
+	return 0;
+}
+
+void sandbox_memtest_clear_faults(void)
+{
+	num_faults = 0;
+}
+
+void arch_memtest_inject(ulong start, ulong size)
+{
+	struct sandbox_memtest_fault *fault;
+	u64 *word;
+
+	for (fault = faults; fault < faults + num_faults; fault++) {
+		if (fault->addr < start || fault->addr - start >= size)
+			continue;
+		word = map_sysmem(fault->addr, sizeof(*word));
+		*word = (*word & ~fault->mask) | fault->value;
+		unmap_sysmem(word);
+	}
+}
@@ -7,6 +7,8 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
 #include <setjmp.h>
 #include <stdio.h>
 #include <stdint.h>
@@ -786,3 +788,26 @@ int os_mprotect_allow(void *start, size_t len)
 
 	return mprotect(start, len, PROT_READ | PROT_WRITE);
 }
+
+int os_thread_create(void **threadp, void *(*fn)(void *arg), void *arg)
+{
+	pthread_t thread;
+	int ret;
+
+	ret = pthread_create(&thread, NULL, fn, arg);
+	if (ret)
+		return -ret;
+	*threadp = (void *)thread;
+
+	return 0;
+}
+
+void os_thread_join(void *thread)
+{
+	pthread_join((pthread_t)thread, NULL);
+}
+
+void os_thread_yield(void)
+{
+	sched_yield();
+}
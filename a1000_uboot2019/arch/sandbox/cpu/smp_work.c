@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Parallel work on sandbox, with a host thread for each secondary CPU
+ */
+
+#include <common.h>
+#include <os.h>
+#include <smp_work.h>
+
+static void *smp_work_threads[CONFIG_SMP_WORK_MAX_CPUS];
+static uint smp_work_nthreads;
+
+static void *smp_work_thread(void *arg)
+{
+	smp_work_secondary((ulong)arg);
+
+	return NULL;
+}
+
+int arch_smp_work_start(uint max_cpus)
+{
+	int ret = 0;
+
+	for (smp_work_nthreads = 0; smp_work_nthreads < max_cpus;
+	     smp_work_nthreads++) {
+		ret = os_thread_create(&smp_work_threads[smp_work_nthreads],
+				       smp_work_thread,
+				       (void *)(ulong)(smp_work_nthreads + 1));
+		if (ret)
+			break;
+	}
+
+	return smp_work_nthreads ? smp_work_nthreads : ret;
+}
+
+void arch_smp_work_stop(void)
+{
+	uint i;
+
+	for (i = 0; i < smp_work_nthreads; i++)
+		os_thread_join(smp_work_threads[i]);
+	smp_work_nthreads = 0;
+}
+
+void arch_smp_work_wait(void)
+{
+	os_thread_yield();
+}
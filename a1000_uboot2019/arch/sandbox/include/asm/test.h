@@ -30,6 +30,9 @@
 
 #define SANDBOX_CLK_RATE		32768
 
+/* Number of sampling phases the sandbox MMC controller tunes over */
+#define SANDBOX_MMC_TUNING_PHASES	32
+
 /* System controller driver data */
 enum {
 	SYSCON0		= 32,
@@ -185,4 +188,49 @@ int sandbox_get_beep_frequency(struct udevice *dev);
  */
 int sandbox_get_pch_spi_protect(struct udevice *dev);
 
+/**
+ * sandbox_serial_get_writes() - Get the number of writes to the terminal
+ *
+ * @dev: Device to check
+ * @return number of times the device has written output
+ */
+unsigned int sandbox_serial_get_writes(struct udevice *dev);
+
+/**
+ * sandbox_mmc_set_tuning_errors() - Make tuning fail at some sampling phases
+ *
+ * Tuning blocks read at these phases get a CRC error.
+ *
+ * @dev: MMC device to update
+ * @phase_mask: Bit mask of the failing phases, bit 0 for phase 0
+ */
+void sandbox_mmc_set_tuning_errors(struct udevice *dev, u32 phase_mask);
+
+/**
+ * sandbox_mmc_get_tuning_phase() - Get the sampling phase currently in use
+ *
+ * @dev: MMC device to check
+ * @return the phase selected by the last tuning
+ */
+uint sandbox_mmc_get_tuning_phase(struct udevice *dev);
+
+/**
+ * sandbox_memtest_add_fault() - Make bits of a RAM word stuck for memtest
+ *
+ * The bits are forced to their stuck value each time the memory test has
+ * written to the word, see arch_memtest_inject().
+ *
+ * @addr: Address of the 64-bit word
+ * @mask: Bits which are stuck
+ * @value: Values the bits are stuck at
+ * @return 0 if OK, -EINVAL if @addr is not aligned, -ENOSPC if there are
+ *	too many faults
+ */
+int sandbox_memtest_add_fault(ulong addr, u64 mask, u64 value);
+
+/**
+ * sandbox_memtest_clear_faults() - Remove all simulated RAM faults
+ */
+void sandbox_memtest_clear_faults(void);
+
 #endif
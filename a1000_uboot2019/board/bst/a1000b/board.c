@@ -3,6 +3,8 @@
  * (C) Copyright 2020 BlackSesame Tec Ltd.
  */
 #include <common.h>
+#include <dm.h>
+#include <malloc.h>
 #include <asm/system.h>
 #include <asm/types.h>
 #include <asm/io.h>
@@ -188,6 +190,30 @@ int board_early_init_r(void)
 }
 #endif
 
+/*
+ * The boot SPI flash, which holds the environment, the DDR parameters and
+ * the USB config block. It is only probed the first time, or again after
+ * 'sf probe' removed it.
+ */
+struct spi_flash *bst_spi_flash(void)
+{
+	static struct udevice *dev;
+	int ret;
+
+	if (!dev || !device_active(dev)) {
+		ret = spi_flash_probe_bus_cs(CONFIG_SF_DEFAULT_BUS,
+					     CONFIG_SF_DEFAULT_CS,
+					     CONFIG_SF_DEFAULT_SPEED,
+					     CONFIG_SF_DEFAULT_MODE, &dev);
+		if (ret) {
+			dev = NULL;
+			return NULL;
+		}
+	}
+
+	return dev_get_uclass_priv(dev);
+}
+
 /*1:open; 0:close*/
 int sync_enable_ecc(unsigned int ecc_status)
 {
@@ -234,7 +260,6 @@ int misc_init_r(void)
 {
 	const char *ptr;
 	int flag = 0;
-	struct spi_flash *flash;
 
 	ptr = env_get("ddrc_interleave");
 	if (ptr) {
@@ -264,15 +289,12 @@ int misc_init_r(void)
 	if (!ptr) {
 		T_CFG_DDR ddrInfo_tmp;
 
-		flash = spi_flash_probe(CONFIG_SF_DEFAULT_BUS,
-							CONFIG_SF_DEFAULT_CS,
-							CONFIG_SF_DEFAULT_SPEED,
-							CONFIG_SF_DEFAULT_MODE);
-		do_get_ddr_info(flash, &ddrInfo_tmp);
-		if (ddrInfo_tmp.ddrECC == 0)
-			sync_enable_ecc(1);
-		else
-			sync_enable_ecc(0);
+		if (!do_get_ddr_info(&ddrInfo_tmp)) {
+			if (ddrInfo_tmp.ddrECC == 0)
+				sync_enable_ecc(1);
+			else
+				sync_enable_ecc(0);
+		}
 	}
 
 
@@ -292,83 +314,126 @@ int dram_init(void)
 
 	return 0;
 }
+
+/* Whether @new can be programmed over @old without erasing first */
+static bool nvram_programmable(const u8 *old, const u8 *new, size_t len)
+{
+	while (len--)
+		if (*new++ & ~*old++)
+			return false;
+
+	return true;
+}
+
+/*
+ * The source may be the flash XIP window, which is mapped as device memory
+ * where unaligned accesses fault: copy a word at a time when both buffers
+ * are aligned, and bytewise otherwise.
+ */
 void *nvram_read(void *dest, const long src, size_t count)
 {
-	uchar *d = (uchar *)dest;
-	uchar *s = (uchar *)src;
+	u32 *dw = (u32 *)dest;
+	const u32 *sw = (const u32 *)src;
+	uchar *d;
+	const uchar *s;
+
+	if (!(((ulong)dest | (ulong)src) & 3)) {
+		for (; count >= 4; count -= 4)
+			*dw++ = *sw++;
+	}
 
+	d = (uchar *)dw;
+	s = (const uchar *)sw;
 	while (count--)
 		*d++ = *s++;
 
 	return dest;
 }
+
+/*
+ * Write the environment, only touching the flash where it changed. Each
+ * erase block is compared with what the flash holds: identical blocks are
+ * skipped, blocks where the new data only clears bits are programmed
+ * without an erase, and only the pages which differ are programmed. A save
+ * which does not change anything costs a single read.
+ */
 void nvram_write(long dest, const void *src, size_t count)
 {
-	int ret = 0;
 	struct spi_flash *env_flash;
+	const u8 *new = src;
+	u32 esize, page, off, len, pos, n;
+	u8 *old;
+	int ret = 0;
 
-	env_flash = spi_flash_probe(CONFIG_SF_DEFAULT_BUS, CONFIG_SF_DEFAULT_CS,
-				    CONFIG_SF_DEFAULT_SPEED,
-				    CONFIG_SF_DEFAULT_MODE);
+	env_flash = bst_spi_flash();
 	if (!env_flash) {
 		puts("SPI probe failed.\n");
-		goto done;
+		return;
 	}
 
-	debug("Erasing SPI flash...");
-	ret = spi_flash_erase(env_flash, dest, count);
-	if (ret) {
-		printf("Erasing SPI flash error:%d\n", ret);
+	esize = env_flash->erase_size;
+	page = env_flash->page_size;
+	old = malloc(esize);
 
-		goto done;
-	}
+	for (off = 0; off < count; off += len) {
+		len = min_t(u32, esize, count - off);
 
-	debug("Writing to SPI flash...");
+		if (old) {
+			ret = spi_flash_read(env_flash, dest + off, len, old);
+			if (ret) {
+				printf("Reading SPI flash error:%d\n", ret);
+				goto done;
+			}
+		}
 
-	ret = spi_flash_write(env_flash, dest, count, src);
-	if (ret) {
-		printf("Writing to SPI flash error:%d\n", ret);
+		if (old && !memcmp(old, new + off, len)) {
+			debug("%lx: unchanged\n", dest + off);
+			continue;
+		}
 
-		goto done;
+		/* programming can only clear bits */
+		if (!old || !nvram_programmable(old, new + off, len)) {
+			debug("Erasing SPI flash at %lx...", dest + off);
+			ret = spi_flash_erase(env_flash, dest + off, len);
+			if (ret) {
+				printf("Erasing SPI flash error:%d\n", ret);
+				goto done;
+			}
+			if (!old) {
+				ret = spi_flash_write(env_flash, dest + off,
+						      len, new + off);
+				if (ret)
+					goto write_err;
+				continue;
+			}
+			memset(old, 0xff, len);
+		}
+
+		debug("Writing to SPI flash at %lx...", dest + off);
+		for (pos = 0; pos < len; pos += n) {
+			n = min_t(u32, page, len - pos);
+			if (!memcmp(old + pos, new + off + pos, n))
+				continue;
+			ret = spi_flash_write(env_flash, dest + off + pos, n,
+					      new + off + pos);
+			if (ret)
+				goto write_err;
+		}
 	}
 
 	debug("done\n");
+	goto done;
+
+write_err:
+	printf("Writing to SPI flash error:%d\n", ret);
 done:
-	return;
+	free(old);
 }
 
 
 
 #ifdef BST_DDR_INFO_ADDR
 
-#define BIG_TO_LITTLE_ENDIAN(value) \
-		 (((value&0x000000ff)<<24) | ((value&0x0000ff00)<<8) | \
-		 ((value&0x00ff0000)>>8) | ((value&0xff000000)>>24))
-
-int do_ddr_fdt_check(struct spi_flash *flash)
-{
-	int ret = 0;
-	struct fdt_header s_fdt_header;
-
-	memset(&s_fdt_header, 0, sizeof(struct fdt_header));
-	ret = spi_flash_read(flash, (u32)(0x200000), sizeof(struct fdt_header),
-				&s_fdt_header);
-	if (ret) {
-		printf("read SPI flash error:%d\n", ret);
-		goto done;
-	}
-	s_fdt_header.totalsize = BIG_TO_LITTLE_ENDIAN(s_fdt_header.totalsize);
-	if (s_fdt_header.totalsize <= 0 ||
-		s_fdt_header.totalsize > DTB_DDR_INFO_SIZE) {
-		ret = -1;
-		goto done;
-	}
-
-done:
-	return ret;
-}
-
-
 #if 0
 static int do_get_ddr_support_freq(struct spi_flash *flash,
 				   s_ddr_config *ddr_config)
@@ -399,93 +464,84 @@ done:
 }
 #endif
 
-u8 *ddr_dtb_buf;
 #define FDT_DDRC_DTB_ADDR  0x200000
 
+/* Enough for the header and, usually, the whole DDR device tree */
+#define DDR_DTB_FIRST_READ	SZ_4K
+
+/*
+ * The DDR parameters, read from the flash once and then served from here.
+ * In dtb mode they live in /ddrc/ddr_info of a device tree at
+ * FDT_DDRC_DTB_ADDR, which is kept in ddr_dtb_buf for 'ddrinfoset';
+ * otherwise the flash holds a raw T_CFG_DDR at BST_DDR_INFO_ADDR.
+ */
+static struct {
+	bool loaded;
+	bool dtb_mode;
+	T_CFG_DDR info;
+} ddr_meta;
+
+u8 *ddr_dtb_buf;
+
+/*
+ * Properties of /ddrc/ddr_info. Those marked 'invert' hold 1 for open in
+ * the tree but 0 for open in T_CFG_DDR.
+ */
+static const struct {
+	const char *name;
+	size_t offset;
+	bool invert;
+} ddr_info_props[] = {
+	{ "vender", offsetof(T_CFG_DDR, ddrVender) },
+	{ "freq", offsetof(T_CFG_DDR, ddrFre) },
+	{ "interleave", offsetof(T_CFG_DDR, ddrInterleave), true },
+	{ "ecc", offsetof(T_CFG_DDR, ddrECC), true },
+	{ "parity", offsetof(T_CFG_DDR, ddrOTHERS), true },
+	{ "clksscg", offsetof(T_CFG_DDR, clksscg) },
+	{ "init_count", offsetof(T_CFG_DDR, ddr_init_count) },
+	{ "rank_count", offsetof(T_CFG_DDR, rank_count) },
+	{ "ecc_range", offsetof(T_CFG_DDR, ecc_range) },
+	{ "zone", offsetof(T_CFG_DDR, zone) },
+	{ "adapt", offsetof(T_CFG_DDR, adapte) },
+	{ "debug", offsetof(T_CFG_DDR, debug), true },
+};
+
+static u32 ddr_info_invert(u32 val, bool invert)
+{
+	if (invert && val <= 1)
+		return !val;
+
+	return val;
+}
 
 static int get_dtb_ddr_info(void *ddrc_dtb_addr, T_CFG_DDR *ddrInfo)
 {
-	int ddr_info_node, len;
-	const int *cell;
+	int ddr_info_node, len, i;
+	const fdt32_t *cell;
 
 	if (ddrc_dtb_addr == NULL || ddrInfo == NULL)
 		return -1;
 	ddr_info_node = fdt_path_offset(ddrc_dtb_addr, "/ddrc/ddr_info");
 	if (ddr_info_node < 0)
 		return -1;
-	cell = fdt_getprop(ddrc_dtb_addr, ddr_info_node, "vender", &len);
-	if (!cell)
-		return -1;
-	ddrInfo->ddrVender = fdt32_to_cpu(cell[0]);
-	cell = fdt_getprop(ddrc_dtb_addr, ddr_info_node, "freq", &len);
-	if (!cell)
-		return -1;
-	ddrInfo->ddrFre = fdt32_to_cpu(cell[0]);
-	cell = fdt_getprop(ddrc_dtb_addr, ddr_info_node, "interleave", &len);
-	if (!cell)
-		return -1;
-	ddrInfo->ddrInterleave = fdt32_to_cpu(cell[0]);
-	if (ddrInfo->ddrInterleave == 0)
-		ddrInfo->ddrInterleave = 1;
-	else if (ddrInfo->ddrInterleave == 1)
-		ddrInfo->ddrInterleave = 0;
-	cell = fdt_getprop(ddrc_dtb_addr, ddr_info_node, "ecc", &len);
-	if (!cell)
-		return -1;
-	ddrInfo->ddrECC = fdt32_to_cpu(cell[0]);
-	if (ddrInfo->ddrECC == 0)
-		ddrInfo->ddrECC = 1;
-	else if (ddrInfo->ddrECC == 1)
-		ddrInfo->ddrECC = 0;
-	cell = fdt_getprop(ddrc_dtb_addr, ddr_info_node, "parity", &len);
-	if (!cell)
-		return -1;
-	ddrInfo->ddrOTHERS = fdt32_to_cpu(cell[0]);
-	if (ddrInfo->ddrOTHERS == 0)
-		ddrInfo->ddrOTHERS = 1;
-	else if (ddrInfo->ddrOTHERS == 1)
-		ddrInfo->ddrOTHERS = 0;
-	cell = fdt_getprop(ddrc_dtb_addr, ddr_info_node, "clksscg", &len);
-	if (!cell)
-		return -1;
-	ddrInfo->clksscg = fdt32_to_cpu(cell[0]);
-	cell = fdt_getprop(ddrc_dtb_addr, ddr_info_node, "init_count", &len);
-	if (!cell)
-		return -1;
-	ddrInfo->ddr_init_count = fdt32_to_cpu(cell[0]);
-	cell = fdt_getprop(ddrc_dtb_addr, ddr_info_node, "rank_count", &len);
-	if (!cell)
-		return -1;
-	ddrInfo->rank_count = fdt32_to_cpu(cell[0]);
-	cell = fdt_getprop(ddrc_dtb_addr, ddr_info_node, "ecc_range", &len);
-	if (!cell)
-		return -1;
-	ddrInfo->ecc_range = fdt32_to_cpu(cell[0]);
-	cell = fdt_getprop(ddrc_dtb_addr, ddr_info_node, "zone", &len);
-	if (!cell)
-		return -1;
-	ddrInfo->zone = fdt32_to_cpu(cell[0]);
 
-	cell = fdt_getprop(ddrc_dtb_addr, ddr_info_node, "adapt", &len);
-	if (!cell)
-		return -1;
-	ddrInfo->adapte = fdt32_to_cpu(cell[0]);
-	cell = fdt_getprop(ddrc_dtb_addr, ddr_info_node, "debug", &len);
-	if (!cell)
-		return -1;
-	ddrInfo->debug = fdt32_to_cpu(cell[0]);
-	if (ddrInfo->debug == 0)
-		ddrInfo->debug = 1;
-	else if (ddrInfo->debug == 1)
-		ddrInfo->debug = 0;
-	return 0;
+	for (i = 0; i < ARRAY_SIZE(ddr_info_props); i++) {
+		cell = fdt_getprop(ddrc_dtb_addr, ddr_info_node,
+				   ddr_info_props[i].name, &len);
+		if (!cell)
+			return -1;
+		*(u32 *)((void *)ddrInfo + ddr_info_props[i].offset) =
+			ddr_info_invert(fdt32_to_cpu(cell[0]),
+					ddr_info_props[i].invert);
+	}
 
+	return 0;
 }
 
 static int set_dtb_ddr_info(void *ddrc_dtb_addr, T_CFG_DDR *ddrInfo)
 {
-	int ddr_info_node, ret = 0;
-	u32 temp[1];
+	int ddr_info_node, ret, i;
+	u32 val;
 
 	if (ddrc_dtb_addr == NULL || ddrInfo == NULL)
 		return -1;
@@ -494,258 +550,151 @@ static int set_dtb_ddr_info(void *ddrc_dtb_addr, T_CFG_DDR *ddrInfo)
 	if (ddr_info_node < 0)
 		return -1;
 
-	temp[0] = cpu_to_fdt32(ddrInfo->ddrVender);
-	fdt_delprop(ddrc_dtb_addr, ddr_info_node, "vender");
-	ret = fdt_setprop(ddrc_dtb_addr, ddr_info_node, "vender", temp,
-				sizeof(u32));
-	if (ret) {
-		printf("fdt set prop error\n");
-		goto done;
-	}
-
-	temp[0] = cpu_to_fdt32(ddrInfo->ddrFre);
-	fdt_delprop(ddrc_dtb_addr, ddr_info_node, "freq");
-	ret = fdt_setprop(ddrc_dtb_addr, ddr_info_node, "freq", temp,
-				sizeof(u32));
-	if (ret) {
-		printf("fdt set prop error\n");
-		goto done;
-	}
-
-	if (ddrInfo->ddrInterleave == 0)
-		ddrInfo->ddrInterleave = 1;
-	else if (ddrInfo->ddrInterleave == 1)
-		ddrInfo->ddrInterleave = 0;
-
-	temp[0] = cpu_to_fdt32(ddrInfo->ddrInterleave);
-	fdt_delprop(ddrc_dtb_addr, ddr_info_node, "interleave");
-	ret = fdt_setprop(ddrc_dtb_addr, ddr_info_node, "interleave", temp,
-				sizeof(u32));
-	if (ret) {
-		printf("fdt set prop error\n");
-		goto done;
-	}
-
-	if (ddrInfo->ddrECC == 0)
-		ddrInfo->ddrECC = 1;
-	else if (ddrInfo->ddrECC == 1)
-		ddrInfo->ddrECC = 0;
-
-	temp[0] = cpu_to_fdt32(ddrInfo->ddrECC);
-	fdt_delprop(ddrc_dtb_addr, ddr_info_node, "ecc");
-	ret = fdt_setprop(ddrc_dtb_addr, ddr_info_node, "ecc", temp,
-				sizeof(u32));
-
-	if (ret) {
-		printf("fdt set prop error\n");
-		goto done;
-	}
-
-	if (ddrInfo->ddrOTHERS == 0)
-		ddrInfo->ddrOTHERS = 1;
-	else if (ddrInfo->ddrOTHERS == 1)
-		ddrInfo->ddrOTHERS = 0;
-
-	temp[0] = cpu_to_fdt32(ddrInfo->ddrOTHERS);
-	fdt_delprop(ddrc_dtb_addr, ddr_info_node, "parity");
-	ret = fdt_setprop(ddrc_dtb_addr, ddr_info_node, "parity", temp,
-				sizeof(u32));
-	if (ret) {
-		printf("fdt set prop error\n");
-		goto done;
-	}
-
-	temp[0] = cpu_to_fdt32(ddrInfo->clksscg);
-	fdt_delprop(ddrc_dtb_addr, ddr_info_node, "clksscg");
-	ret = fdt_setprop(ddrc_dtb_addr, ddr_info_node, "clksscg", temp,
-				sizeof(u32));
-	if (ret) {
-		printf("fdt set prop error\n");
-		goto done;
-	}
-
-	temp[0] = cpu_to_fdt32(ddrInfo->ddr_init_count);
-	fdt_delprop(ddrc_dtb_addr, ddr_info_node, "init_count");
-	ret = fdt_setprop(ddrc_dtb_addr, ddr_info_node, "init_count", temp,
-				sizeof(u32));
-	if (ret) {
-		printf("fdt set prop error\n");
-		goto done;
-	}
-
-	temp[0] = cpu_to_fdt32(ddrInfo->rank_count);
-	fdt_delprop(ddrc_dtb_addr, ddr_info_node, "rank_count");
-	ret = fdt_setprop(ddrc_dtb_addr, ddr_info_node, "rank_count", temp,
-				sizeof(u32));
-	if (ret) {
-		printf("fdt set prop error\n");
-		goto done;
+	for (i = 0; i < ARRAY_SIZE(ddr_info_props); i++) {
+		val = *(u32 *)((void *)ddrInfo + ddr_info_props[i].offset);
+		ret = fdt_setprop_u32(ddrc_dtb_addr, ddr_info_node,
+				      ddr_info_props[i].name,
+				      ddr_info_invert(val,
+						      ddr_info_props[i].invert));
+		if (ret) {
+			printf("fdt set prop error\n");
+			return ret;
+		}
 	}
 
+	return 0;
+}
 
-	temp[0] = cpu_to_fdt32(ddrInfo->ecc_range);
-	fdt_delprop(ddrc_dtb_addr, ddr_info_node, "ecc_range");
-	ret = fdt_setprop(ddrc_dtb_addr, ddr_info_node, "ecc_range", temp,
-				sizeof(u32));
-	if (ret) {
-		printf("fdt set prop error\n");
-		goto done;
-	}
-
-	temp[0] = cpu_to_fdt32(ddrInfo->zone);
-	fdt_delprop(ddrc_dtb_addr, ddr_info_node, "zone");
-	ret = fdt_setprop(ddrc_dtb_addr, ddr_info_node, "zone", temp,
-				sizeof(u32));
-	if (ret) {
-		printf("fdt set prop error\n");
-		goto done;
+/*
+ * Read the DDR device tree with a single flash read where it fits in
+ * DDR_DTB_FIRST_READ. The buffer covers the whole DTB_DDR_INFO_SIZE area,
+ * padded as erased flash, since 'ddrinfoset' writes all of it back.
+ */
+static int ddr_meta_read_dtb(struct spi_flash *flash)
+{
+	u32 totalsize;
+	int ret;
+
+	if (!ddr_dtb_buf) {
+		ddr_dtb_buf = malloc(DTB_DDR_INFO_SIZE);
+		if (!ddr_dtb_buf) {
+			printf("malloc DTB DDR buffer fail\n");
+			return -ENOMEM;
+		}
 	}
 
-
-	temp[0] = cpu_to_fdt32(ddrInfo->adapte);
-	fdt_delprop(ddrc_dtb_addr, ddr_info_node, "adapt");
-	ret = fdt_setprop(ddrc_dtb_addr, ddr_info_node, "adapt", temp,
-				sizeof(u32));
+	ret = spi_flash_read(flash, FDT_DDRC_DTB_ADDR, DDR_DTB_FIRST_READ,
+			     ddr_dtb_buf);
 	if (ret) {
-		printf("fdt set prop error\n");
-		goto done;
+		printf("read SPI flash error:%d\n", ret);
+		return ret;
 	}
 
+	totalsize = fdt_totalsize(ddr_dtb_buf);
+	if (!totalsize || totalsize > DTB_DDR_INFO_SIZE)
+		return -ENOENT;
 
-	if (ddrInfo->debug == 0)
-		ddrInfo->debug = 1;
-	else if (ddrInfo->debug == 1)
-		ddrInfo->debug = 0;
-	temp[0] = cpu_to_fdt32(ddrInfo->debug);
-	fdt_delprop(ddrc_dtb_addr, ddr_info_node, "debug");
-	ret = fdt_setprop(ddrc_dtb_addr, ddr_info_node, "debug", temp,
-				sizeof(u32));
-	if (ret) {
-		printf("fdt set prop error\n");
-		goto done;
+	if (totalsize > DDR_DTB_FIRST_READ) {
+		ret = spi_flash_read(flash,
+				     FDT_DDRC_DTB_ADDR + DDR_DTB_FIRST_READ,
+				     totalsize - DDR_DTB_FIRST_READ,
+				     ddr_dtb_buf + DDR_DTB_FIRST_READ);
+		if (ret) {
+			printf("read SPI flash error:%d\n", ret);
+			return ret;
+		}
+	} else {
+		totalsize = DDR_DTB_FIRST_READ;
 	}
+	memset(ddr_dtb_buf + totalsize, 0xff, DTB_DDR_INFO_SIZE - totalsize);
 
-done:
-	return ret;
-
+	return 0;
 }
 
-
-static int do_get_ddr_fdt_totalsize(struct spi_flash *flash, u32 *totalsize)
+static int ddr_meta_load(void)
 {
-	int ret = 0;
-	struct fdt_header s_fdt_header;
-
-	memset(&s_fdt_header, 0, sizeof(struct fdt_header));
-	ret = spi_flash_read(flash, (u32)(0x200000), sizeof(struct fdt_header),
-				&s_fdt_header);
-	if (ret) {
-		printf("read SPI flash error:%d\n", ret);
-		goto done;
-	}
-	s_fdt_header.totalsize = BIG_TO_LITTLE_ENDIAN(s_fdt_header.totalsize);
-	*totalsize = s_fdt_header.totalsize;
-
-done:
-	return ret;
-}
+	struct spi_flash *flash;
+	T_CFG_DDR *ddrInfo = &ddr_meta.info;
+	int ret;
 
-static int do_get_ddr_info(struct spi_flash *flash, T_CFG_DDR *ddrInfo)
-{
-	int ret = 0;
-	u32 totalsize = 0;
+	if (ddr_meta.loaded)
+		return 0;
 
+	flash = bst_spi_flash();
 	if (!flash) {
 		puts("SPI flash error.\n");
-		ret = -1;
-		goto done;
+		return -1;
 	}
 
-	ret = do_ddr_fdt_check(flash);
-
-	if (ret == 0) {
-		printf("====== it is dtb mode ======\n");
-		ret = do_get_ddr_fdt_totalsize(flash, &totalsize);
-		if (ret) {
-			printf("get ddr fdt totalsize fail\n");
-			goto done;
-		}
-		if (ddr_dtb_buf == NULL) {
-			ddr_dtb_buf = (u8 *)malloc(totalsize);
-			if (ddr_dtb_buf == NULL) {
-				printf("malloc DTB DDR buffer fail\n");
-				ret = -1;
-				goto done;
-			}
-		}
-
-		ret = spi_flash_read(flash, (u32)(FDT_DDRC_DTB_ADDR), totalsize,
-						ddr_dtb_buf);
+	ret = ddr_meta_read_dtb(flash);
+	if (ret == -ENOENT) {
+		printf("====== it is other mode ======\n");
+		free(ddr_dtb_buf);
+		ddr_dtb_buf = NULL;
+		ddr_meta.dtb_mode = false;
+		ret = spi_flash_read(flash, (u32)(BST_DDR_INFO_ADDR),
+					sizeof(T_CFG_DDR), ddrInfo);
 		if (ret) {
 			printf("read SPI flash error:%d\n", ret);
-			goto done;
+			return ret;
 		}
-
+	} else if (ret) {
+		return ret;
+	} else {
+		printf("====== it is dtb mode ======\n");
+		ddr_meta.dtb_mode = true;
 		ret = get_dtb_ddr_info(ddr_dtb_buf, ddrInfo);
 		if (ret) {
 			printf("read DTB DDR INFO error:%d\n", ret);
-			goto done;
+			return ret;
 		}
-
-	} else {
-		printf("====== it is other mode ======\n");
-		ret = spi_flash_read(flash, (u32)(BST_DDR_INFO_ADDR),
-					sizeof(T_CFG_DDR), ddrInfo);
-		if (ret) {
-			printf("read SPI flash error:%d\n", ret);
-			goto done;
-		}
-
 	}
 
 	if (ddrInfo->ddrECC >= DDR_ECC_END || ddrInfo->ddrFre >= DDR_FREQ_END ||
 	    ddrInfo->ddrInterleave >= DDR_INTERLEAVE_END ||
 	    ddrInfo->ddrVender >= DDR_VENDER_NAME_END) {
 		printf("ddr information data error.\n");
-		ret = -1;
-		goto done;
+		return -1;
 	}
 
-done:
-	return ret;
+	ddr_meta.loaded = true;
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "ddr_info");
+
+	return 0;
 }
 
-static int do_set_ddr_info(struct spi_flash *flash, T_CFG_DDR *ddrInfo)
+static int do_get_ddr_info(T_CFG_DDR *ddrInfo)
 {
+	int ret;
+
+	ret = ddr_meta_load();
+	if (ret)
+		return ret;
+
+	memcpy(ddrInfo, &ddr_meta.info, sizeof(*ddrInfo));
+
+	return 0;
+}
+
+static int do_set_ddr_info(T_CFG_DDR *ddrInfo)
+{
+	struct spi_flash *flash;
 	int ret = 0;
-	u32 totalsize = 0;
 
-	if (!flash) {
+	flash = bst_spi_flash();
+	if (!flash || !ddr_meta.loaded) {
 		puts("SPI flash error.\n");
 		ret = -1;
 		goto done;
 	}
 
-	ret = do_ddr_fdt_check(flash);
-
-	if (ret == 0) {
-		if (ddr_dtb_buf == NULL) {
-			printf("DDR DTB buffer error\n");
-			ret = -1;
-			goto done;
-		}
+	if (ddr_meta.dtb_mode) {
 		ret = set_dtb_ddr_info(ddr_dtb_buf, ddrInfo);
 		if (ret) {
 			printf("set DTB DDR INFO error:%d\n", ret);
 			goto done;
 		}
 
-		ret = do_get_ddr_fdt_totalsize(flash, &totalsize);
-		if (ret) {
-			printf("get ddr fdt totalsize fail\n");
-			goto done;
-		}
-
 		debug("Erasing SPI flash...");
 		ret = spi_flash_erase(flash, (u32)(FDT_DDRC_DTB_ADDR),
 					DTB_DDR_INFO_SIZE);
@@ -788,6 +737,8 @@ static int do_set_ddr_info(struct spi_flash *flash, T_CFG_DDR *ddrInfo)
 		}
 	}
 
+	memcpy(&ddr_meta.info, ddrInfo, sizeof(ddr_meta.info));
+
 done:
 	return ret;
 }
@@ -795,7 +746,6 @@ done:
 static int do_ddr_info(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 {
 	const char *cmd;
-	struct spi_flash *flash;
 	T_CFG_DDR ddrInfo;
 	int ret = 0;
 	unsigned long ddrFre;
@@ -814,21 +764,13 @@ static int do_ddr_info(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 
 	cmd = argv[0];
 
-	flash = spi_flash_probe(CONFIG_SF_DEFAULT_BUS, CONFIG_SF_DEFAULT_CS,
-				CONFIG_SF_DEFAULT_SPEED,
-				CONFIG_SF_DEFAULT_MODE);
-	if (!flash) {
-		puts("SPI probe failed.\n");
-		goto usage;
-	}
-
 	memset(ddr_config, 0, 2 * sizeof(s_ddr_config));
 	ddr_config[0].ddr_fre = 0x1; //3200_2D
 	ddr_config[1].ddr_fre = 0xb; //4000_2D
 	ddr_config[2].ddr_fre = 0x9; //3733_2D
 
 	if (strcmp(cmd, "ddrinfoget") == 0) {
-		ret = do_get_ddr_info(flash, &ddrInfo);
+		ret = do_get_ddr_info(&ddrInfo);
 		if (ret != 0)
 			goto done;
 		//printf("vender:\t\t%s\n", bst_ddr_vender[ddrInfo.ddrVender]);
@@ -837,8 +779,7 @@ static int do_ddr_info(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 		printf("interleave:\t%s\n",
 		       ddrInfo.ddrInterleave ? "close" : "open");
 		printf("parity:\t\t%s\n", ddrInfo.ddrOTHERS ? "close" : "open");
-		ret = do_ddr_fdt_check(flash);
-		if (ret == 0) {
+		if (ddr_meta.dtb_mode) {
 			printf("debug:\t\t%s\n",
 				ddrInfo.debug ? "close" : "open");
 		}
@@ -849,7 +790,7 @@ static int do_ddr_info(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 
 		goto done;
 	} else if (strcmp(cmd, "ddrinfoset") == 0 && (argc == 6 || argc == 5)) {
-		ret = do_get_ddr_info(flash, &ddrInfo);
+		ret = do_get_ddr_info(&ddrInfo);
 		if (ret != 0)
 			goto done;
 
@@ -861,8 +802,7 @@ static int do_ddr_info(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 			goto dataerr;
 		if (kstrtoul(argv[4], 10, &ddrOTHERS) != 0)
 			goto dataerr;
-		ret = do_ddr_fdt_check(flash);
-		if (ret == 0) {
+		if (ddr_meta.dtb_mode) {
 			if (kstrtoul(argv[5], 10, &debug) != 0)
 				goto dataerr;
 		}
@@ -880,8 +820,7 @@ static int do_ddr_info(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 		ddrInfo.ddrInterleave = ddrInterleave;
 		ddrInfo.ddrECC = ddrECC;
 		ddrInfo.ddrOTHERS = ddrOTHERS;
-		ret = do_ddr_fdt_check(flash);
-		if (ret == 0)
+		if (ddr_meta.dtb_mode)
 			ddrInfo.debug = debug;
 
 		if (ddrInfo.ddrECC >= DDR_ECC_END ||
@@ -896,7 +835,7 @@ static int do_ddr_info(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 		else
 			sync_enable_ecc(0);
 
-		ret = do_set_ddr_info(flash, &ddrInfo);
+		ret = do_set_ddr_info(&ddrInfo);
 		goto done;
 
 	} else {
@@ -1011,7 +950,6 @@ int ft_verify_fdt(void *fdt)
 	u32 memory_change[256];
 	u32 data = 0;
 	T_CFG_DDR s_ddr_info;
-	struct spi_flash *flash;
 	int ret = 0;
 	const char *ptr;
 	int ddr_szauto = -1;
@@ -1088,15 +1026,7 @@ int ft_verify_fdt(void *fdt)
 
 	if (ddr_szauto == 1) {
 		memset(&s_ddr_info, 0, sizeof(s_ddr_info));
-		flash = spi_flash_probe(CONFIG_SF_DEFAULT_BUS,
-						CONFIG_SF_DEFAULT_CS,
-						CONFIG_SF_DEFAULT_SPEED,
-						CONFIG_SF_DEFAULT_MODE);
-		if (!flash) {
-			puts("AUTO ADAPTE 4G/8G SPI probe failed.\n");
-			goto FT_VERIFY_FDT_ERR;
-		}
-		ret = do_get_ddr_info(flash, &s_ddr_info);
+		ret = do_get_ddr_info(&s_ddr_info);
 		if (ret != 0) {
 			puts("AUTO ADAPTE 4G/8G do_get_ddr_info failed.\n");
 			goto FT_VERIFY_FDT_ERR;
@@ -186,5 +186,6 @@ int board_init(void);
 void *nvram_read(void *dest, const long src, size_t count);
 void nvram_write(long dest, const void *src, size_t count);
 static int do_ddr_info(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[]);
-static int do_get_ddr_info(struct spi_flash *flash, T_CFG_DDR *ddrInfo);
+static int do_get_ddr_info(T_CFG_DDR *ddrInfo);
+struct spi_flash *bst_spi_flash(void);
 #endif
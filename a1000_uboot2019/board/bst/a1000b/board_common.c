@@ -6,6 +6,7 @@
 #include <asm/system.h>
 #include <asm/types.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
 #include <fdtdec.h>
 #include <asm/sections.h>
 #include <malloc.h>
@@ -14,11 +15,13 @@
 #include <errno.h>
 #include <image.h>
 #include <linux/libfdt.h>
+#include <lmb.h>
 #include <environment.h>
 #include <dm.h>
 #include <dm/device-internal.h>
 #include <mmc.h>
 #include <ext4fs.h>
+#include <serial.h>
 #include <spi_flash.h>
 #include <linux/arm-smccc.h>
 #include <u-boot/sha256.h>
@@ -104,6 +107,18 @@ static void reset_qspi(void)
 }
 #endif
 
+/* Called by do_reset(), which is also how panic() ends */
+void reset_misc(void)
+{
+	/* Send the last messages before the UART is reset */
+	if (CONFIG_IS_ENABLED(DM_SERIAL))
+		serial_flush();
+
+	/* Data still in the eMMC write cache is lost on reset */
+	if (CONFIG_IS_ENABLED(MMC_WRITE))
+		mmc_flush_all_caches();
+}
+
 void reset_cpu(ulong addr)
 {
 	reset_qspi();
@@ -188,6 +203,24 @@ int board_fit_config_name_match(const char *name)
 	return 0;
 }
 #ifdef SPI_SPEC_BOARD_GET_FLASH
+/*
+ * The XIP window is mapped as device memory, which faults on unaligned
+ * accesses, so read it a byte at a time up to the first 64-bit boundary
+ * and then with aligned 64-bit loads. memcpy() is free to do neither.
+ */
+static void xip_memcpy(void *buf, const void *addr, size_t len)
+{
+	const u8 *src = addr;
+	u8 *dst = buf;
+
+	for (; len && ((ulong)src & 7); len--)
+		*dst++ = __raw_readb(src++);
+	for (; len >= 8; len -= 8, src += 8, dst += 8)
+		put_unaligned(__raw_readq(src), (u64 *)dst);
+	while (len--)
+		*dst++ = __raw_readb(src++);
+}
+
 /*
  * Qspi0 get data from spi flash.
  */
@@ -200,18 +233,18 @@ int spi_flash_get_board(u32 offset, size_t len, void *buf, u32 size)
 
 	//memcpy
 	if (offset >= SZ_16M) {
-		memcpy(buf, addr, len);
+		xip_memcpy(buf, addr, len);
 	} else {
 		//offset < 16M and offset+len > 16M,
 		//first copy >= 16M, after copy < 16M
 		if ((offset + len) > SZ_16M) {
 			u32 sizetmp = SZ_16M - (u32)offset;
 
-			memcpy(buf + sizetmp, (void *)SZ_16M,
-			       (offset + len) - SZ_16M);
-			memcpy(buf, addr, sizetmp);
+			xip_memcpy(buf + sizetmp, (void *)SZ_16M,
+				   (offset + len) - SZ_16M);
+			xip_memcpy(buf, addr, sizetmp);
 		} else {
-			memcpy(buf, addr, len);
+			xip_memcpy(buf, addr, len);
 		}
 	}
 
@@ -219,6 +252,23 @@ int spi_flash_get_board(u32 offset, size_t len, void *buf, u32 size)
 
 	return 0;
 }
+
+#ifdef CONFIG_SPI_FLASH_DIRMAP
+/*
+ * Serve sf reads of the qspi0 flash from its XIP window; other
+ * buses fall back to FIFO reads.
+ */
+int spi_flash_dirmap_read(struct spi_flash *flash, u32 offset, size_t len,
+			  void *buf)
+{
+	struct udevice *bus = dev_get_parent(flash->dev);
+
+	if (bus->seq != 0 || offset + len > flash->size)
+		return -ENOTSUPP;
+
+	return spi_flash_get_board(offset, len, buf, flash->size);
+}
+#endif
 #endif
 
 void *board_fdt_blob_setup(void)
@@ -233,6 +283,16 @@ void *board_fdt_blob_setup(void)
 	return fdt_blob;
 }
 
+/*
+ * The ATF runtime image stays resident below the load address. Keep image
+ * relocation and mtest2 away from it.
+ */
+void board_lmb_reserve(struct lmb *lmb)
+{
+	lmb_reserve(lmb, BST_ATF_IMAGE_ENTRY_BASE,
+		    CONFIG_SYS_LOAD_ADDR - BST_ATF_IMAGE_ENTRY_BASE);
+}
+
 void board_quiesce_devices(void)
 {
 	//close qspi0 XIP
@@ -240,6 +300,14 @@ void board_quiesce_devices(void)
 
 	//close qspi1 XIP
 	bst_close_xip(1, 0);
+
+	/* Console output may still be buffered in the UART driver */
+	if (CONFIG_IS_ENABLED(DM_SERIAL))
+		serial_flush();
+
+	/* The OS does not know about data left in the eMMC write cache */
+	if (CONFIG_IS_ENABLED(MMC_WRITE))
+		mmc_flush_all_caches();
 }
 
 #ifdef CONFIG_CMD_ELF
@@ -172,14 +172,19 @@ static int write_usb_cfg_block_to_nor(unsigned char *config_block)
 #endif
 
 #ifdef CONFIG_USB_CFG_BLOCK_IS_IN_QSPI
+/* Boards which keep the boot flash probed can share it through this */
+__weak struct spi_flash *bst_spi_flash(void)
+{
+	return spi_flash_probe(CONFIG_SF_DEFAULT_BUS, CONFIG_SF_DEFAULT_CS,
+			       CONFIG_SF_DEFAULT_SPEED, CONFIG_SF_DEFAULT_MODE);
+}
+
 int qspi_write(long dest, const void *src, size_t count)
 {
 	int ret = -1;
 	struct spi_flash *env_flash;
 
-	env_flash = spi_flash_probe(CONFIG_SF_DEFAULT_BUS, CONFIG_SF_DEFAULT_CS,
-				    CONFIG_SF_DEFAULT_SPEED,
-				    CONFIG_SF_DEFAULT_MODE);
+	env_flash = bst_spi_flash();
 	if (!env_flash) {
 		puts("SPI probe failed.\n");
 		goto done;
@@ -212,9 +217,7 @@ int qspi_read(void *dest, long src, size_t count)
 	int ret = -1;
 	struct spi_flash *env_flash;
 
-	env_flash = spi_flash_probe(CONFIG_SF_DEFAULT_BUS, CONFIG_SF_DEFAULT_CS,
-				    CONFIG_SF_DEFAULT_SPEED,
-				    CONFIG_SF_DEFAULT_MODE);
+	env_flash = bst_spi_flash();
 	if (!env_flash) {
 		puts("SPI probe failed.\n");
 		goto done;
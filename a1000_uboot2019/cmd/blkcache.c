@@ -13,30 +13,38 @@ static int blkc_show(cmd_tbl_t *cmdtp, int flag,
 		     int argc, char * const argv[])
 {
 	struct block_cache_stats stats;
+	unsigned lookups;
+
 	blkcache_stats(&stats);
+	lookups = stats.hits + stats.misses;
 
 	printf("hits: %u\n"
 	       "misses: %u\n"
+	       "hit ratio: %u%%\n"
+	       "bytes saved: %llu\n"
+	       "read-aheads: %u\n"
 	       "entries: %u\n"
-	       "max blocks/entry: %u\n"
-	       "max cache entries: %u\n",
-	       stats.hits, stats.misses, stats.entries,
-	       stats.max_blocks_per_entry, stats.max_entries);
+	       "size: %lu KiB of %lu KiB\n"
+	       "max blocks/read: %u\n",
+	       stats.hits, stats.misses,
+	       lookups ? (unsigned)((u64)stats.hits * 100 / lookups) : 0,
+	       stats.bytes_saved, stats.readaheads, stats.entries,
+	       stats.bytes >> 10, stats.max_bytes >> 10, stats.max_blocks);
 	return 0;
 }
 
 static int blkc_configure(cmd_tbl_t *cmdtp, int flag,
 			  int argc, char * const argv[])
 {
-	unsigned blocks_per_entry, max_entries;
+	unsigned blocks, size_mb;
 	if (argc != 3)
 		return CMD_RET_USAGE;
 
-	blocks_per_entry = simple_strtoul(argv[1], 0, 0);
-	max_entries = simple_strtoul(argv[2], 0, 0);
-	blkcache_configure(blocks_per_entry, max_entries);
-	printf("changed to max of %u entries of %u blocks each\n",
-	       max_entries, blocks_per_entry);
+	blocks = simple_strtoul(argv[1], 0, 0);
+	size_mb = simple_strtoul(argv[2], 0, 0);
+	blkcache_configure(blocks, (unsigned long)size_mb << 20);
+	printf("changed to max of %u MiB, reads of up to %u blocks cached\n",
+	       size_mb, blocks);
 	return 0;
 }
 
@@ -82,5 +90,6 @@ U_BOOT_CMD(
 	blkcache, 4, 0, do_blkcache,
 	"block cache diagnostics and control",
 	"show - show and reset statistics\n"
-	"blkcache configure blocks entries\n"
+	"blkcache configure blocks size_mb - cache reads of up to 'blocks'\n"
+	"    blocks in at most 'size_mb' MiB of memory\n"
 );
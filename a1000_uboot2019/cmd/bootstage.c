@@ -8,7 +8,14 @@
 static int do_bootstage_report(cmd_tbl_t *cmdtp, int flag, int argc,
 			       char * const argv[])
 {
-	bootstage_report();
+	if (argc < 2)
+		bootstage_report();
+	else if (!strcmp(argv[1], "csv"))
+		bootstage_export(BOOTSTAGE_EXPORT_CSV);
+	else if (!strcmp(argv[1], "json"))
+		bootstage_export(BOOTSTAGE_EXPORT_JSON);
+	else
+		return CMD_RET_USAGE;
 
 	return 0;
 }
@@ -88,7 +95,8 @@ static int do_boostage(cmd_tbl_t *cmdtp, int flag, int argc,
 U_BOOT_CMD(bootstage, 4, 1, do_boostage,
 	"Boot stage command",
 	" - check boot progress and timing\n"
-	"report                      - Print a report\n"
+	"report [csv|json]           - Print a report, or all records as\n"
+	"                              CSV or JSON\n"
 	"stash [<start> [<size>]]    - Stash data into memory\n"
 	"unstash [<start> [<size>]]  - Unstash data from memory"
 );
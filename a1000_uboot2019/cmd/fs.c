@@ -27,14 +27,17 @@ static int do_load_wrapper(cmd_tbl_t *cmdtp, int flag, int argc,
 				char * const argv[])
 {
 #ifdef CONFIG_CMD_BOOTEFI
-	efi_set_bootdev(argv[1], (argc > 2) ? argv[2] : "",
-			(argc > 4) ? argv[4] : "");
+	/* skip -d */
+	int d = argc > 1 && !strcmp(argv[1], "-d");
+
+	efi_set_bootdev(argv[1 + d], (argc > 2 + d) ? argv[2 + d] : "",
+			(argc > 4 + d) ? argv[4 + d] : "");
 #endif
 	return do_load(cmdtp, flag, argc, argv, FS_TYPE_ANY);
 }
 
 U_BOOT_CMD(
-	load,	7,	0,	do_load_wrapper,
+	load,	8,	0,	do_load_wrapper,
 	"load binary file from a filesystem",
 	"<interface> [<dev[:part]> [<addr> [<filename> [bytes [pos]]]]]\n"
 	"    - Load binary file 'filename' from partition 'part' on device\n"
@@ -43,6 +46,11 @@ U_BOOT_CMD(
 	"      If 'bytes' is 0 or omitted, the file is read until the end.\n"
 	"      'pos' gives the file byte position to start reading from.\n"
 	"      If 'pos' is 0 or omitted, the file is read from the start."
+#if CONFIG_IS_ENABLED(DECOMP_STREAM)
+	"\nload -d <interface> [<dev[:part]> [<addr> [<filename> [bytes [pos]]]]]\n"
+	"    - Same, but decompress the gzip, LZ4 or LZMA compressed file\n"
+	"      while it is read. 'bytes' then limits the decompressed size."
+#endif
 )
 
 static int do_save_wrapper(cmd_tbl_t *cmdtp, int flag, int argc,
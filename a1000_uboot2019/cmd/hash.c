@@ -13,12 +13,27 @@
 #include <command.h>
 #include <hash.h>
 #include <linux/ctype.h>
+#include <linux/sizes.h>
 
 static int do_hash(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	char *s;
 	int flags = HASH_FLAG_ENV;
 
+	if (argc >= 2 && !strcmp(argv[1], "bench")) {
+		ulong len = SZ_1M;
+
+		if (argc > 2)
+			len = simple_strtoul(argv[2], NULL, 16);
+		if (!len)
+			return CMD_RET_USAGE;
+		if (hash_bench(len)) {
+			printf("Cannot allocate %lx bytes\n", len);
+			return CMD_RET_FAILURE;
+		}
+		return CMD_RET_SUCCESS;
+	}
+
 #ifdef CONFIG_HASH_VERIFY
 	if (argc < 4)
 		return CMD_RET_USAGE;
@@ -52,4 +67,6 @@ U_BOOT_CMD(
 		"    - verify message digest of memory area to immediate value, \n"
 		"      env var or *address"
 #endif
+	"\nhash bench [size]\n"
+		"    - print the throughput of each algorithm hashing size bytes"
 );
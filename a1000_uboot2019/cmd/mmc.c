@@ -10,6 +10,8 @@
 #include <mmc.h>
 #include <sparse_format.h>
 #include <image-sparse.h>
+#include <div64.h>
+#include <mapmem.h>
 
 static int curr_device = -1;
 
@@ -103,6 +105,8 @@ static struct mmc *init_mmc_device(int dev, bool force_init)
 
 	if (!mmc_getcd(mmc))
 		force_init = true;
+	else if (force_init && CONFIG_IS_ENABLED(MMC_WRITE))
+		mmc_flush_cache(mmc);
 
 	if (force_init)
 		mmc->has_init = 0;
@@ -372,6 +376,7 @@ static int do_mmc_sparse_write(cmd_tbl_t *cmdtp, int flag,
 	sparse.size = dev_desc->lba - blk;
 	sparse.write = mmc_sparse_write;
 	sparse.reserve = mmc_sparse_reserve;
+	sparse.erase = NULL;
 	sparse.mssg = NULL;
 	sprintf(dest, "0x" LBAF, sparse.start * sparse.blksz);
 
@@ -441,6 +446,115 @@ static int do_mmc_erase(cmd_tbl_t *cmdtp, int flag,
 
 	return (n == cnt) ? CMD_RET_SUCCESS : CMD_RET_FAILURE;
 }
+
+static int do_mmc_cache(cmd_tbl_t *cmdtp, int flag,
+			int argc, char * const argv[])
+{
+	struct mmc *mmc;
+	int ret;
+
+	if (argc > 2)
+		return CMD_RET_USAGE;
+
+	mmc = init_mmc_device(curr_device, false);
+	if (!mmc)
+		return CMD_RET_FAILURE;
+
+	if (!mmc_cache_size(mmc)) {
+		puts("No write cache on device\n");
+		return CMD_RET_FAILURE;
+	}
+
+	if (argc == 1) {
+		printf("Write cache: %u KiB, %s\n", mmc_cache_size(mmc),
+		       mmc_cache_enabled(mmc) ? "on" : "off");
+		return CMD_RET_SUCCESS;
+	}
+
+	if (!strcmp(argv[1], "on"))
+		ret = mmc_cache_ctrl(mmc, true);
+	else if (!strcmp(argv[1], "off"))
+		ret = mmc_cache_ctrl(mmc, false);
+	else if (!strcmp(argv[1], "flush"))
+		ret = mmc_flush_cache(mmc);
+	else
+		return CMD_RET_USAGE;
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(CMD_MMC_BENCH)
+static void mmc_bench_report(const char *op, u32 cnt, u32 blksz, ulong us)
+{
+	u64 bytes = (u64)cnt * blksz;
+	u64 kib_s;
+
+	if (!us)
+		us = 1;
+	kib_s = lldiv(bytes * 1000000 / 1024, us);
+	printf("%d blocks %s in %lu.%06lu s: %llu.%02llu MiB/s\n", cnt, op,
+	       us / 1000000, us % 1000000, kib_s / 1024,
+	       (kib_s % 1024) * 100 / 1024);
+}
+
+static int do_mmc_bench(cmd_tbl_t *cmdtp, int flag,
+			int argc, char * const argv[])
+{
+	struct blk_desc *bd;
+	struct mmc *mmc;
+	u32 blk, cnt, n;
+	ulong start;
+	void *addr;
+	bool write;
+
+	if (argc != 5)
+		return CMD_RET_USAGE;
+	if (!strcmp(argv[1], "read"))
+		write = false;
+	else if (CONFIG_IS_ENABLED(MMC_WRITE) && !strcmp(argv[1], "write"))
+		write = true;
+	else
+		return CMD_RET_USAGE;
+
+	blk = simple_strtoul(argv[3], NULL, 16);
+	cnt = simple_strtoul(argv[4], NULL, 16);
+
+	mmc = init_mmc_device(curr_device, false);
+	if (!mmc)
+		return CMD_RET_FAILURE;
+	bd = mmc_get_blk_desc(mmc);
+
+	printf("MMC bench: dev # %d, block # %d, count %d\n",
+	       curr_device, blk, cnt);
+
+	if (write && mmc_getwp(mmc) == 1) {
+		printf("Error: card is write protected!\n");
+		return CMD_RET_FAILURE;
+	}
+
+	addr = map_sysmem(simple_strtoul(argv[2], NULL, 16),
+			  (ulong)cnt * bd->blksz);
+	start = timer_get_us();
+	if (write) {
+		n = blk_dwrite(bd, blk, cnt, addr);
+		/* The data is only safe once it has left the device cache */
+		if (CONFIG_IS_ENABLED(MMC_WRITE) && n == cnt &&
+		    mmc_flush_cache(mmc))
+			n = 0;
+	} else {
+		n = blk_dread(bd, blk, cnt, addr);
+	}
+	unmap_sysmem(addr);
+	if (n != cnt) {
+		printf("%d blocks %s: ERROR\n", n, argv[1]);
+		return CMD_RET_FAILURE;
+	}
+	mmc_bench_report(write ? "written" : "read", cnt, bd->blksz,
+			 timer_get_us() - start);
+
+	return CMD_RET_SUCCESS;
+}
 #endif
 
 static int do_mmc_rescan(cmd_tbl_t *cmdtp, int flag,
@@ -495,6 +609,13 @@ static int do_mmc_dev(cmd_tbl_t *cmdtp, int flag,
 		return CMD_RET_USAGE;
 	}
 
+	/* Don't leave data behind in the cache of the device we move away from */
+	if (CONFIG_IS_ENABLED(MMC_WRITE) && dev != curr_device) {
+		mmc = find_mmc_device(curr_device);
+		if (mmc)
+			mmc_flush_cache(mmc);
+	}
+
 	mmc = init_mmc_device(dev, true);
 	if (!mmc)
 		return CMD_RET_FAILURE;
@@ -878,9 +999,13 @@ static cmd_tbl_t cmd_mmc[] = {
 #if CONFIG_IS_ENABLED(MMC_WRITE)
 	U_BOOT_CMD_MKENT(write, 4, 0, do_mmc_write, "", ""),
 	U_BOOT_CMD_MKENT(erase, 3, 0, do_mmc_erase, "", ""),
+	U_BOOT_CMD_MKENT(cache, 2, 0, do_mmc_cache, "", ""),
 #endif
 #if CONFIG_IS_ENABLED(CMD_MMC_SWRITE)
 	U_BOOT_CMD_MKENT(swrite, 3, 0, do_mmc_sparse_write, "", ""),
+#endif
+#if CONFIG_IS_ENABLED(CMD_MMC_BENCH)
+	U_BOOT_CMD_MKENT(bench, 5, 0, do_mmc_bench, "", ""),
 #endif
 	U_BOOT_CMD_MKENT(rescan, 1, 1, do_mmc_rescan, "", ""),
 	U_BOOT_CMD_MKENT(part, 1, 1, do_mmc_part, "", ""),
@@ -940,6 +1065,11 @@ U_BOOT_CMD(
 	"mmc swrite addr blk#\n"
 #endif
 	"mmc erase blk# cnt\n"
+	"mmc cache [on|off|flush] - show or control the eMMC write cache\n"
+#if CONFIG_IS_ENABLED(CMD_MMC_BENCH)
+	"mmc bench read addr blk# cnt - measure read throughput\n"
+	"mmc bench write addr blk# cnt - measure write throughput\n"
+#endif
 	"mmc rescan\n"
 	"mmc part - lists available partition on current mmc device\n"
 	"mmc dev [dev] [part] - show or set current mmc device [partition]\n"
@@ -0,0 +1,230 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * High-bandwidth memory test of all DRAM banks
+ *
+ * Each bank is tested except for the memory used by U-Boot and the regions
+ * reserved in the device tree, which lmb knows about.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <div64.h>
+#include <lmb.h>
+#include <memtest.h>
+#include <linux/sizes.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Room left for the stack to grow below its start while testing */
+#define MTEST2_STACK_MARGIN	SZ_1M
+
+#define MTEST2_MAX_RANGES	(MAX_LMB_REGIONS + 2)
+
+struct mtest2_range {
+	ulong start;
+	ulong size;
+};
+
+/* Remove [base, base + size) from the ranges, which may split one of them */
+static int mtest2_cut(struct mtest2_range *r, int count, ulong base,
+		      ulong size)
+{
+	ulong end = base + size, rend;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		rend = r[i].start + r[i].size;
+		if (base >= rend || end <= r[i].start)
+			continue;
+		if (base > r[i].start && end < rend) {
+			if (count == MTEST2_MAX_RANGES)
+				return -ENOSPC;
+			memmove(&r[i + 2], &r[i + 1],
+				(count - i - 1) * sizeof(*r));
+			r[i + 1].start = end;
+			r[i + 1].size = rend - end;
+			r[i].size = base - r[i].start;
+			count++;
+			i++;
+		} else if (base > r[i].start) {
+			r[i].size = base - r[i].start;
+		} else if (end < rend) {
+			r[i].start = end;
+			r[i].size = rend - end;
+		} else {
+			memmove(&r[i], &r[i + 1], (count - i - 1) * sizeof(*r));
+			count--;
+			i--;
+		}
+	}
+
+	return count;
+}
+
+/* Find the parts of [start, start + size) which are free to test */
+static int mtest2_get_ranges(struct lmb *lmb, ulong start, ulong size,
+			     struct mtest2_range *r)
+{
+	ulong end;
+	int count = 1;
+	int i;
+
+	r[0].start = start;
+	r[0].size = size;
+	for (i = 0; count > 0 && i < lmb->reserved.cnt; i++)
+		count = mtest2_cut(r, count, lmb->reserved.region[i].base,
+				   lmb->reserved.region[i].size);
+	if (count > 0 && gd->ram_top > gd->start_addr_sp - MTEST2_STACK_MARGIN)
+		count = mtest2_cut(r, count,
+				   gd->start_addr_sp - MTEST2_STACK_MARGIN,
+				   gd->ram_top - gd->start_addr_sp +
+				   MTEST2_STACK_MARGIN);
+
+	for (i = 0; i < count; i++) {
+		end = ALIGN_DOWN(r[i].start + r[i].size, MEMTEST_LINE_SIZE);
+		r[i].start = ALIGN(r[i].start, MEMTEST_LINE_SIZE);
+		r[i].size = end > r[i].start ? end - r[i].start : 0;
+	}
+
+	return count;
+}
+
+static int mtest2_bank(struct lmb *lmb, int bank, ulong start, ulong size,
+		       uint flags)
+{
+	struct mtest2_range ranges[MTEST2_MAX_RANGES];
+	struct memtest_result res;
+	ulong errors = 0, us = 0, tested = 0, mb_s;
+	u64 bytes = 0;
+	int count, cpus = 1;
+	int ret = 0;
+	int i, j;
+
+	count = mtest2_get_ranges(lmb, start, size, ranges);
+	if (count < 0) {
+		printf("Bank %d: too many reserved regions\n", bank);
+		return count;
+	}
+
+	for (i = 0; i < count && !ret; i++) {
+		if (!ranges[i].size)
+			continue;
+		ret = memtest_run(ranges[i].start, ranges[i].size, flags, &res);
+		errors += res.errors;
+		bytes += res.bytes;
+		us += res.us;
+		tested += ranges[i].size;
+		cpus = res.cpus;
+		for (j = 0; j < res.nfails; j++)
+			printf("  %#010lx: expected %016llx, got %016llx\n",
+			       res.fail[j].addr, res.fail[j].expect,
+			       res.fail[j].actual);
+	}
+
+	if (ret && ret != -EINTR)
+		printf("Bank %d: test failed (err=%d)\n", bank, ret);
+
+	mb_s = us ? lldiv(bytes, us) : 0;
+	printf("Bank %d: %#010lx-%#010lx, %lu MiB at %lu.%03lu GB/s on %d CPU(s), %lu errors\n",
+	       bank, start, start + size - 1, tested >> 20, mb_s / 1000,
+	       mb_s % 1000, cpus, errors);
+	if (ret)
+		return ret;
+
+	return errors ? -EIO : 0;
+}
+
+static int do_mtest2(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	uint flags = 0, iterations = 1, iteration;
+	ulong start = 0, size = 0;
+	struct lmb lmb;
+	const char *p;
+	int bank, ret = 0, failed = 0;
+
+	for (; argc > 1 && argv[1][0] == '-'; argc--, argv++) {
+		switch (argv[1][1]) {
+		case 'a':
+			if (argc < 3)
+				return CMD_RET_USAGE;
+			for (p = argv[2]; *p; p++) {
+				if (*p == 'w')
+					flags |= MEMTEST_WALK;
+				else if (*p == 'm')
+					flags |= MEMTEST_MATS;
+				else if (*p == 'a')
+					flags |= MEMTEST_ADDR;
+				else
+					return CMD_RET_USAGE;
+			}
+			argc--;
+			argv++;
+			break;
+		case 'n':
+			if (argc < 3)
+				return CMD_RET_USAGE;
+			iterations = simple_strtoul(argv[2], NULL, 10);
+			argc--;
+			argv++;
+			break;
+		case 'z':
+			flags |= MEMTEST_ZVA;
+			break;
+		default:
+			return CMD_RET_USAGE;
+		}
+	}
+	if (argc == 3) {
+		start = simple_strtoul(argv[1], NULL, 16);
+		size = simple_strtoul(argv[2], NULL, 16);
+		if (!size)
+			return CMD_RET_USAGE;
+	} else if (argc != 1) {
+		return CMD_RET_USAGE;
+	}
+	if (!(flags & MEMTEST_ALL))
+		flags |= MEMTEST_ALL;
+
+	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
+
+	for (iteration = 0; !iterations || iteration < iterations;
+	     iteration++) {
+		printf("Iteration %u:\n", iteration + 1);
+		if (size) {
+			ret = mtest2_bank(&lmb, 0, start, size, flags);
+		} else {
+			for (bank = 0; bank < CONFIG_NR_DRAM_BANKS; bank++) {
+				if (!gd->bd->bi_dram[bank].size)
+					continue;
+				ret = mtest2_bank(&lmb, bank,
+						  gd->bd->bi_dram[bank].start,
+						  gd->bd->bi_dram[bank].size,
+						  flags);
+				if (ret == -EINTR)
+					break;
+				if (ret)
+					failed = 1;
+			}
+		}
+		if (ret == -EINTR) {
+			puts("Interrupted\n");
+			return CMD_RET_FAILURE;
+		}
+		if (ret)
+			failed = 1;
+	}
+
+	return failed ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	mtest2,	8,	0,	do_mtest2,
+	"high-bandwidth RAM test",
+	"[-a algs] [-n count] [-z] [start size]\n"
+	"    - test all DRAM banks, or the given range, except the memory\n"
+	"      used by U-Boot and the regions reserved in the device tree\n"
+	"  -a algs: any of w (walking bits on data and address bus),\n"
+	"           m (MATS+ march), a (address in address); default wma\n"
+	"  -n count: number of iterations, 0 to run until Ctrl-C; default 1\n"
+	"  -z: zero memory with the fastest fill available (DC ZVA on ARMv8)"
+);
@@ -391,6 +391,51 @@ static int do_spi_protect(int argc, char * const argv[])
 	return ret == 0 ? 0 : 1;
 }
 
+#ifdef CONFIG_SPI_FLASH_DIRMAP
+static const char * const read_path_name[SPI_NOR_READ_PATHS] = {
+	"dirmap",
+	"fifo",
+};
+
+static int do_spi_flash_dirmap(int argc, char * const argv[])
+{
+	struct spi_nor_read_stats *stats;
+	uint64_t speed;	/* KiB/s */
+	int i;
+
+	if (argc > 2)
+		return -1;
+
+	if (argc == 2) {
+		if (strcmp(argv[1], "on") == 0)
+			flash->dirmap_disabled = false;
+		else if (strcmp(argv[1], "off") == 0)
+			flash->dirmap_disabled = true;
+		else if (strcmp(argv[1], "reset") == 0)
+			memset(flash->read_stats, 0, sizeof(flash->read_stats));
+		else
+			return -1;
+		return 0;
+	}
+
+	printf("SF: memory-mapped reads %s\n",
+	       flash->dirmap_disabled ? "disabled" : "enabled");
+	for (i = 0; i < SPI_NOR_READ_PATHS; i++) {
+		stats = &flash->read_stats[i];
+		speed = 0;
+		if (stats->us) {
+			speed = stats->bytes * 1000000;
+			do_div(speed, stats->us);
+			speed >>= 10;
+		}
+		printf("%-6s: %llu bytes in %llu us, %llu KiB/s\n",
+		       read_path_name[i], stats->bytes, stats->us, speed);
+	}
+
+	return 0;
+}
+#endif
+
 #ifdef CONFIG_CMD_SF_TEST
 enum {
 	STAGE_ERASE,
@@ -587,6 +632,10 @@ static int do_spi_flash(cmd_tbl_t *cmdtp, int flag, int argc,
 		ret = do_spi_flash_erase(argc, argv);
 	else if (strcmp(cmd, "protect") == 0)
 		ret = do_spi_protect(argc, argv);
+#ifdef CONFIG_SPI_FLASH_DIRMAP
+	else if (strcmp(cmd, "dirmap") == 0)
+		ret = do_spi_flash_dirmap(argc, argv);
+#endif
 #ifdef CONFIG_CMD_SF_TEST
 	else if (!strcmp(cmd, "test"))
 		ret = do_spi_flash_test(argc, argv);
@@ -602,6 +651,14 @@ usage:
 	return CMD_RET_USAGE;
 }
 
+#ifdef CONFIG_SPI_FLASH_DIRMAP
+#define SF_DIRMAP_HELP "sf dirmap [on|off|reset]		" \
+		"- show per-path read throughput, enable/disable\n" \
+		"					  memory-mapped reads or reset the counters\n"
+#else
+#define SF_DIRMAP_HELP
+#endif
+
 #ifdef CONFIG_CMD_SF_TEST
 #define SF_TEST_HELP "\nsf test offset len		" \
 		"- run a very basic destructive test"
@@ -630,5 +687,6 @@ U_BOOT_CMD(
 	"					  or to start of mtd `partition'\n"
 	"sf protect lock/unlock sector len	- protect/unprotect 'len' bytes starting\n"
 	"					  at address 'sector'\n"
+	SF_DIRMAP_HELP
 	SF_TEST_HELP
 );
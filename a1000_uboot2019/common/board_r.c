@@ -294,6 +294,9 @@ static int initr_dm(void)
 	if (ret)
 		return ret;
 #endif
+	ret = dm_probe_early();
+	if (ret)
+		return ret;
 
 	return 0;
 }
@@ -366,8 +366,9 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 	 * this, image_len will be set to the number of uncompressed bytes
 	 * loaded, ret will be non-zero on error.
 	 */
-	 printf("load_buf:%p,  image_buf:%p\n\rimage_len:%lx comp:%d\n\r",
-				load_buf, image_buf, image_len, comp);
+	debug("load_buf:%p, image_buf:%p, image_len:%lx comp:%d\n",
+	      load_buf, image_buf, image_len, comp);
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DECOMP, "decompress");
 	switch (comp) {
 	case IH_COMP_NONE:
 		if (load == image_start)
@@ -429,8 +430,10 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 #endif /* CONFIG_LZ4 */
 	default:
 		printf("Unimplemented compression type %d\n", comp);
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_DECOMP);
 		return BOOTM_ERR_UNIMPLEMENTED;
 	}
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DECOMP);
 
 	if (ret)
 		return handle_decomp_error(comp, image_len, unc_len, ret);
@@ -195,6 +195,38 @@ uint32_t bootstage_accum(enum bootstage_id id)
 	return duration;
 }
 
+int bootstage_add_span(const char *name, ulong start_us)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_record *rec;
+
+	if (data->rec_count == RECORD_COUNT)
+		return -ENOSPC;
+	rec = &data->record[data->rec_count++];
+	rec->id = data->next_id++;
+	rec->start_us = start_us;
+	rec->time_us = timer_get_boot_us() - start_us;
+	rec->name = name;
+	rec->flags = BOOTSTAGEF_SPAN;
+
+	return 0;
+}
+
+void bootstage_initcall(ulong addr, ulong start_us)
+{
+	/* "initcall " and up to 16 hex digits */
+	const int len = 9 + 2 + 16 + 1;
+	char *name;
+
+	if (gd->bootstage->rec_count == RECORD_COUNT)
+		return;
+	name = malloc(len);
+	if (!name)
+		return;
+	snprintf(name, len, "initcall %#lx", addr);
+	bootstage_add_span(name, start_us);
+}
+
 /**
  * Get a record name as a printable string
  *
@@ -232,11 +264,17 @@ static uint32_t print_time_record(struct bootstage_record *rec, uint32_t prev)
 	return rec->time_us;
 }
 
+/* Time at which a mark was made or a step started */
+static ulong record_time(const struct bootstage_record *rec)
+{
+	return rec->flags & BOOTSTAGEF_SPAN ? rec->start_us : rec->time_us;
+}
+
 static int h_compare_record(const void *r1, const void *r2)
 {
 	const struct bootstage_record *rec1 = r1, *rec2 = r2;
 
-	return rec1->time_us > rec2->time_us ? 1 : -1;
+	return record_time(rec1) > record_time(rec2) ? 1 : -1;
 }
 
 #ifdef CONFIG_OF_LIBFDT
@@ -290,7 +328,13 @@ static int add_bootstages_devicetree(struct fdt_header *blob)
 				rec->start_us ? "accum" : "mark",
 				rec->time_us))
 			return -EINVAL;
+		if ((rec->flags & BOOTSTAGEF_SPAN) &&
+		    fdt_setprop_cell(blob, node, "start", rec->start_us))
+			return -EINVAL;
 	}
+	if (recnum >= 0)
+		printf("bootstage: No space in device tree for %d records\n",
+		       recnum + 1);
 
 	return 0;
 }
@@ -309,6 +353,7 @@ void bootstage_report(void)
 	struct bootstage_data *data = gd->bootstage;
 	struct bootstage_record *rec = data->record;
 	uint32_t prev;
+	int steps = 0;
 	int i;
 
 	printf("Timer summary in microseconds (%d records):\n",
@@ -331,9 +376,91 @@ void bootstage_report(void)
 
 	puts("\nAccumulated time:\n");
 	for (i = 0, rec = data->record; i < data->rec_count; i++, rec++) {
-		if (rec->start_us)
+		if (rec->start_us && !(rec->flags & BOOTSTAGEF_SPAN))
 			prev = print_time_record(rec, -1);
 	}
+
+	for (i = 0, rec = data->record; i < data->rec_count; i++, rec++) {
+		char buf[20];
+
+		if (!(rec->flags & BOOTSTAGEF_SPAN))
+			continue;
+		if (!steps++)
+			printf("\nSteps:\n%11s%11s  %s\n", "Start", "Duration",
+			       "Step");
+		print_grouped_ull(rec->start_us, BOOTSTAGE_DIGITS);
+		print_grouped_ull(rec->time_us, BOOTSTAGE_DIGITS);
+		printf("  %s\n", get_record_name(buf, sizeof(buf), rec));
+	}
+}
+
+/* Print a record name as a CSV field or JSON string */
+static void export_name(const char *name, bool json)
+{
+	const char *p;
+
+	putc('"');
+	for (p = name; *p; p++) {
+		if (*p == '"')
+			putc(json ? '\\' : '"');
+		else if (json && *p == '\\')
+			putc('\\');
+		putc(*p);
+	}
+	putc('"');
+}
+
+void bootstage_export(enum bootstage_export_fmt fmt)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_record *rec;
+	bool json = fmt == BOOTSTAGE_EXPORT_JSON;
+	ulong prev = 0;
+	char buf[20];
+	int i;
+
+	qsort(data->record, data->rec_count, sizeof(*rec), h_compare_record);
+
+	if (json)
+		puts("{\"records\": [\n");
+	else
+		puts("type,id,name,time_us,duration_us\n");
+	for (i = 0, rec = data->record; i < data->rec_count; i++, rec++) {
+		const char *type;
+		ulong time, duration;
+
+		if (rec->flags & BOOTSTAGEF_SPAN) {
+			type = "span";
+			time = rec->start_us;
+			duration = rec->time_us;
+		} else if (rec->start_us) {
+			type = "accum";
+			time = rec->start_us;
+			duration = rec->time_us;
+		} else {
+			type = "mark";
+			time = rec->time_us;
+			duration = time - prev;
+			prev = time;
+		}
+
+		if (json) {
+			printf("  {\"type\": \"%s\", \"id\": %d, \"name\": ",
+			       type, rec->id);
+			export_name(get_record_name(buf, sizeof(buf), rec),
+				    true);
+			printf(", \"time_us\": %lu, \"duration_us\": %lu}%s\n",
+			       time, duration,
+			       i < data->rec_count - 1 ? "," : "");
+		} else {
+			printf("%s,%d,", type, rec->id);
+			export_name(get_record_name(buf, sizeof(buf), rec),
+				    false);
+			printf(",%lu,%lu\n", time, duration);
+		}
+	}
+	if (json)
+		puts("]}\n");
 }
 
 /**
@@ -14,6 +14,7 @@
 #include <command.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <div64.h>
 #include <hw_sha.h>
 #include <asm/io.h>
 #include <linux/errno.h>
@@ -123,7 +124,8 @@ static int hash_init_crc32(struct hash_algo *algo, void **ctxp)
 static int hash_update_crc32(struct hash_algo *algo, void *ctx,
 			     const void *buf, unsigned int size, int is_last)
 {
-	*((uint32_t *)ctx) = crc32(*((uint32_t *)ctx), buf, size);
+	*((uint32_t *)ctx) = crc32_wd(*((uint32_t *)ctx), buf, size,
+				      CHUNKSZ_CRC32);
 	return 0;
 }
 
@@ -501,4 +503,43 @@ int hash_command(const char *algo_name, int flags, cmd_tbl_t *cmdtp, int flag,
 	return 0;
 }
 #endif /* CONFIG_CMD_HASH || CONFIG_CMD_SHA1SUM || CONFIG_CMD_CRC32) */
+
+#ifdef CONFIG_CMD_HASH
+/* Each algorithm hashes the buffer repeatedly for at least this long */
+#define HASH_BENCH_US	200000
+
+int hash_bench(unsigned int len)
+{
+	uint8_t output[HASH_MAX_DIGEST_SIZE];
+	struct hash_algo *algo;
+	unsigned long start, elapsed;
+	unsigned int loops, i;
+	u8 *buf;
+
+	buf = malloc(len);
+	if (!buf)
+		return -ENOMEM;
+	for (i = 0; i < len; i++)
+		buf[i] = i * 7 + (i >> 8);
+
+	printf("Hashing %u bytes\n", len);
+	for (i = 0; i < ARRAY_SIZE(hash_algo); i++) {
+		algo = &hash_algo[i];
+		loops = 0;
+		start = timer_get_us();
+		do {
+			algo->hash_func_ws(buf, len, output, algo->chunk_size);
+			loops++;
+			elapsed = timer_get_us() - start;
+		} while (elapsed < HASH_BENCH_US);
+
+		/* bytes per microsecond are MB/s */
+		printf("%-14s %8lu MB/s\n", algo->name,
+		       (unsigned long)lldiv((u64)len * loops, elapsed));
+	}
+	free(buf);
+
+	return 0;
+}
+#endif /* CONFIG_CMD_HASH */
 #endif /* !USE_HOSTCC */
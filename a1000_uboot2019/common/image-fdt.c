@@ -528,6 +528,7 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 	int ret = -EPERM;
 	int fdt_ret;
 
+	bootstage_start(BOOTSTAGE_ID_ACCUM_FDT, "fdt_fixup");
 	if (fdt_root(blob) < 0) {
 		printf("ERROR: root node setup failed\n");
 		goto err;
@@ -585,10 +586,12 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 	if (IMAGE_OF_BOARD_SETUP)
 		ft_board_setup_ex(blob, gd->bd);
 #endif
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_FDT);
 
 	return 0;
 err:
 	printf(" - must RESET the board to recover.\n\n");
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_FDT);
 
 	return ret;
 }
@@ -1167,6 +1167,7 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 	uint8_t *fit_value;
 	int fit_value_len;
 	int ignore;
+	int ret;
 
 	*err_msgp = NULL;
 
@@ -1190,7 +1191,10 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 		return -1;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+	bootstage_start(BOOTSTAGE_ID_ACCUM_HASH, "hash");
+	ret = calculate_hash(data, size, algo, value, &value_len);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_HASH);
+	if (ret) {
 		*err_msgp = "Unsupported hash algorithm";
 		return -1;
 	}
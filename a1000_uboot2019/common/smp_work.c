@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Running CPU-bound work on the secondary CPUs
+ *
+ * The boot CPU publishes a job by bumping smp_work.job, and each CPU runs
+ * every n-th item of it, n being the number of CPUs. No atomic operations
+ * are needed: each field is written by a single CPU, and barriers order the
+ * job against its number and the results against the done flags.
+ */
+
+#include <common.h>
+#include <smp_work.h>
+#include <linux/compiler.h>
+
+/* How long the secondary CPUs have to report for work */
+#define SMP_WORK_TIMEOUT_MS	100
+
+static struct smp_work {
+	smp_work_fn fn;
+	void *priv;
+	uint count;
+	uint cpus;	/* CPUs running jobs, including this one */
+	int status;	/* 0 if not started, 1 if running, -ve on error */
+	uint job;	/* incremented for each job */
+	bool stop;
+	bool online[CONFIG_SMP_WORK_MAX_CPUS];
+	uint done[CONFIG_SMP_WORK_MAX_CPUS];	/* last job each CPU finished */
+} smp_work;
+
+/* Full barrier between the CPUs */
+#define smp_work_mb()	__sync_synchronize()
+
+__weak int arch_smp_work_start(uint max_cpus)
+{
+	return -ENOSYS;
+}
+
+__weak void arch_smp_work_stop(void)
+{
+}
+
+__weak void arch_smp_work_wait(void)
+{
+}
+
+__weak void arch_smp_work_wake(void)
+{
+}
+
+void smp_work_secondary(uint cpu)
+{
+	struct smp_work *sw = &smp_work;
+	uint job = READ_ONCE(sw->job);
+	uint item;
+
+	WRITE_ONCE(sw->online[cpu], true);
+	arch_smp_work_wake();
+	while (1) {
+		while (READ_ONCE(sw->job) == job && !READ_ONCE(sw->stop))
+			arch_smp_work_wait();
+		if (READ_ONCE(sw->stop))
+			break;
+
+		/* read the job only after its number */
+		smp_work_mb();
+		job = sw->job;
+		for (item = cpu; item < sw->count; item += sw->cpus)
+			sw->fn(sw->priv, item);
+		smp_work_mb();
+		WRITE_ONCE(sw->done[cpu], job);
+		arch_smp_work_wake();
+	}
+}
+
+static void smp_work_park(struct smp_work *sw)
+{
+	smp_work_mb();
+	WRITE_ONCE(sw->stop, true);
+	arch_smp_work_wake();
+	arch_smp_work_stop();
+}
+
+static int smp_work_start(struct smp_work *sw)
+{
+	ulong start;
+	int cpu, ret;
+
+	memset(sw->online, '\0', sizeof(sw->online));
+	memset(sw->done, '\0', sizeof(sw->done));
+	sw->job = 0;
+	sw->stop = false;
+	smp_work_mb();
+
+	ret = arch_smp_work_start(CONFIG_SMP_WORK_MAX_CPUS - 1);
+	if (ret <= 0) {
+		if (ret)
+			smp_work_park(sw);
+		debug("%s: no secondary CPUs (err=%d)\n", __func__, ret);
+		return ret ? ret : -ENODEV;
+	}
+	sw->cpus = ret + 1;
+
+	start = get_timer(0);
+	for (cpu = 1; cpu < sw->cpus; cpu++) {
+		while (!READ_ONCE(sw->online[cpu])) {
+			if (get_timer(start) > SMP_WORK_TIMEOUT_MS) {
+				smp_work_park(sw);
+				return -ETIMEDOUT;
+			}
+			udelay(10);
+		}
+	}
+	debug("%s: %u CPUs\n", __func__, sw->cpus);
+
+	return 1;
+}
+
+int smp_work_run(smp_work_fn fn, void *priv, uint count)
+{
+	struct smp_work *sw = &smp_work;
+	uint item, cpu;
+
+	if (!sw->status)
+		sw->status = smp_work_start(sw);
+	if (sw->status < 0 || count < 2) {
+		for (item = 0; item < count; item++)
+			fn(priv, item);
+		return 1;
+	}
+
+	sw->fn = fn;
+	sw->priv = priv;
+	sw->count = count;
+	/* publish the job before its number */
+	smp_work_mb();
+	WRITE_ONCE(sw->job, sw->job + 1);
+	arch_smp_work_wake();
+
+	for (item = 0; item < count; item += sw->cpus)
+		fn(priv, item);
+	for (cpu = 1; cpu < sw->cpus; cpu++) {
+		while (READ_ONCE(sw->done[cpu]) != sw->job)
+			arch_smp_work_wait();
+	}
+	/* see what the other CPUs wrote */
+	smp_work_mb();
+
+	return sw->cpus;
+}
+
+void smp_work_stop(void)
+{
+	struct smp_work *sw = &smp_work;
+
+	/* after an error the CPUs are not tried again */
+	if (sw->status <= 0)
+		return;
+	smp_work_park(sw);
+	sw->status = 0;
+}
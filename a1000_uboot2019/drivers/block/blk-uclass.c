@@ -10,6 +10,7 @@
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/uclass-internal.h>
+#include <malloc.h>
 
 static const char *if_typename_str[IF_TYPE_COUNT] = {
 	[IF_TYPE_IDE]		= "ide",
@@ -426,23 +427,69 @@ int blk_get_device(int if_type, int devnum, struct udevice **devp)
 	return device_probe(*devp);
 }
 
+/*
+ * Read @racnt blocks into a bounce buffer, cache them and hand the first
+ * @blkcnt to the caller. Returns -ENOMEM or 0 if that did not work, in
+ * which case the caller reads the blocks it needs by itself.
+ */
+static long blk_read_ahead(struct blk_desc *block_dev, lbaint_t start,
+			   lbaint_t blkcnt, lbaint_t racnt, void *buffer)
+{
+	struct udevice *dev = block_dev->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong blks_read;
+	void *buf;
+
+	buf = memalign(ARCH_DMA_MINALIGN, racnt * block_dev->blksz);
+	if (!buf)
+		return -ENOMEM;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_BLK, "blk");
+	blks_read = ops->read(dev, start, racnt, buf);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_BLK);
+	if (blks_read == racnt) {
+		blkcache_fill(block_dev->if_type, block_dev->devnum,
+			      block_dev->hwpart, start, racnt,
+			      block_dev->blksz, buf);
+		memcpy(buffer, buf, blkcnt * block_dev->blksz);
+	}
+	free(buf);
+
+	return blks_read == racnt ? blkcnt : 0;
+}
+
 unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			lbaint_t blkcnt, void *buffer)
 {
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
+	lbaint_t racnt;
 	ulong blks_read;
 
 	if (!ops->read)
 		return -ENOSYS;
 
 	if (blkcache_read(block_dev->if_type, block_dev->devnum,
-			  start, blkcnt, block_dev->blksz, buffer))
+			  block_dev->hwpart, start, blkcnt, block_dev->blksz,
+			  buffer))
+		return blkcnt;
+
+	racnt = blkcache_readahead(block_dev->if_type, block_dev->devnum,
+				   start, blkcnt, block_dev->blksz);
+	if (start + racnt > block_dev->lba)
+		racnt = block_dev->lba > start + blkcnt ?
+			block_dev->lba - start : blkcnt;
+	if (racnt > blkcnt &&
+	    blk_read_ahead(block_dev, start, blkcnt, racnt, buffer) == blkcnt)
 		return blkcnt;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_BLK, "blk");
 	blks_read = ops->read(dev, start, blkcnt, buffer);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_BLK);
 	if (blks_read == blkcnt)
 		blkcache_fill(block_dev->if_type, block_dev->devnum,
-			      start, blkcnt, block_dev->blksz, buffer);
+			      block_dev->hwpart, start, blkcnt,
+			      block_dev->blksz, buffer);
 
 	return blks_read;
 }
@@ -453,11 +500,24 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
 
+	ulong blks_written;
+
 	if (!ops->write)
 		return -ENOSYS;
 
-	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
-	return ops->write(dev, start, blkcnt, buffer);
+	bootstage_start(BOOTSTAGE_ID_ACCUM_BLK, "blk");
+	blks_written = ops->write(dev, start, blkcnt, buffer);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_BLK);
+	if (blks_written == blkcnt)
+		blkcache_write(block_dev->if_type, block_dev->devnum,
+			       block_dev->hwpart, start, blkcnt,
+			       block_dev->blksz, buffer);
+	else
+		blkcache_invalidate_range(block_dev->if_type,
+					  block_dev->devnum, block_dev->hwpart,
+					  start, blkcnt, block_dev->blksz);
+
+	return blks_written;
 }
 
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
@@ -465,12 +525,19 @@ unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 {
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong ret;
 
 	if (!ops->erase)
 		return -ENOSYS;
 
-	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
-	return ops->erase(dev, start, blkcnt);
+	blkcache_invalidate_range(block_dev->if_type, block_dev->devnum,
+				  block_dev->hwpart, start, blkcnt,
+				  block_dev->blksz);
+	bootstage_start(BOOTSTAGE_ID_ACCUM_BLK, "blk");
+	ret = ops->erase(dev, start, blkcnt);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_BLK);
+
+	return ret;
 }
 
 int blk_get_from_parent(struct udevice *parent, struct udevice **devp)
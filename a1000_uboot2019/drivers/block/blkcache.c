@@ -11,157 +11,377 @@
 #include <linux/ctype.h>
 #include <linux/list.h>
 
+/*
+ * The cache is made of pages of BLKCACHE_PAGE_BLOCKS aligned blocks. Pages
+ * are looked up through a hash of (interface, device, hardware partition,
+ * page number) and kept on an LRU list; the least recently used ones are
+ * dropped once the byte budget is used up. Each page tracks which of its
+ * blocks hold valid data, so that reads and writes of any alignment can fill
+ * or update it.
+ */
+#define BLKCACHE_PAGE_SHIFT	3
+#define BLKCACHE_PAGE_BLOCKS	(1 << BLKCACHE_PAGE_SHIFT)
+#define BLKCACHE_HASH_BITS	8
+#define BLKCACHE_HASH_SIZE	(1 << BLKCACHE_HASH_BITS)
+
 struct block_cache_node {
-	struct list_head lh;
+	struct list_head lh;	/* LRU list, most recent first */
+	struct hlist_node hn;	/* hash chain */
 	int iftype;
 	int devnum;
-	lbaint_t start;
-	lbaint_t blkcnt;
+	int hwpart;
+	lbaint_t page;
 	unsigned long blksz;
+	u8 valid;		/* one bit per block of the page */
 	char *cache;
 };
 
 static LIST_HEAD(block_cache);
+static struct hlist_head block_cache_hash[BLKCACHE_HASH_SIZE];
+
+/* Where the last read ended, to spot sequential access */
+static struct {
+	int iftype;
+	int devnum;
+	int hwpart;
+	lbaint_t next;
+	bool sequential;
+} last_read = {
+	.iftype = -1,
+};
 
 static struct block_cache_stats _stats = {
-	.max_blocks_per_entry = 8,
-	.max_entries = 32
+	.max_blocks = 32,
+	.max_bytes = CONFIG_BLOCK_CACHE_SIZE << 20,
 };
 
-static struct block_cache_node *cache_find(int iftype, int devnum,
-					   lbaint_t start, lbaint_t blkcnt,
-					   unsigned long blksz)
+static unsigned int cache_hash(int iftype, int devnum, int hwpart,
+			       lbaint_t page)
+{
+	u32 key = (u32)page ^ (u32)((u64)page >> 32) ^
+		  ((u32)iftype << 24) ^ ((u32)devnum << 16) ^
+		  ((u32)hwpart << 8);
+
+	return (key * 0x9e3779b1) >> (32 - BLKCACHE_HASH_BITS);
+}
+
+static struct block_cache_node *cache_find(int iftype, int devnum, int hwpart,
+					   lbaint_t page, unsigned long blksz)
 {
 	struct block_cache_node *node;
+	struct hlist_node *pos;
+	unsigned int hash = cache_hash(iftype, devnum, hwpart, page);
 
-	list_for_each_entry(node, &block_cache, lh)
-		if ((node->iftype == iftype) &&
+	hlist_for_each_entry(node, pos, &block_cache_hash[hash], hn)
+		if ((node->page == page) &&
+		    (node->iftype == iftype) &&
 		    (node->devnum == devnum) &&
-		    (node->blksz == blksz) &&
-		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
-			if (block_cache.next != &node->lh) {
-				/* maintain MRU ordering */
-				list_del(&node->lh);
-				list_add(&node->lh, &block_cache);
-			}
+		    (node->hwpart == hwpart) &&
+		    (node->blksz == blksz))
 			return node;
-		}
-	return 0;
+
+	return NULL;
+}
+
+static void cache_touch(struct block_cache_node *node)
+{
+	if (block_cache.next != &node->lh) {
+		/* maintain LRU ordering */
+		list_del(&node->lh);
+		list_add(&node->lh, &block_cache);
+	}
 }
 
-int blkcache_read(int iftype, int devnum,
+static void cache_drop(struct block_cache_node *node)
+{
+	list_del(&node->lh);
+	hlist_del(&node->hn);
+	_stats.bytes -= node->blksz * BLKCACHE_PAGE_BLOCKS;
+	_stats.entries--;
+	free(node->cache);
+	free(node);
+}
+
+static struct block_cache_node *cache_alloc(int iftype, int devnum,
+					    int hwpart, lbaint_t page,
+					    unsigned long blksz)
+{
+	unsigned long bytes = blksz * BLKCACHE_PAGE_BLOCKS;
+	struct block_cache_node *node;
+
+	if (bytes > _stats.max_bytes)
+		return NULL;
+
+	/* pop LRU */
+	while (_stats.bytes + bytes > _stats.max_bytes) {
+		node = list_entry(block_cache.prev, struct block_cache_node,
+				  lh);
+		debug("drop: page " LBAF "\n", node->page);
+		cache_drop(node);
+	}
+
+	node = malloc(sizeof(*node));
+	if (!node)
+		return NULL;
+	node->cache = malloc(bytes);
+	if (!node->cache) {
+		free(node);
+		return NULL;
+	}
+
+	node->iftype = iftype;
+	node->devnum = devnum;
+	node->hwpart = hwpart;
+	node->page = page;
+	node->blksz = blksz;
+	node->valid = 0;
+	list_add(&node->lh, &block_cache);
+	hlist_add_head(&node->hn,
+		       &block_cache_hash[cache_hash(iftype, devnum, hwpart,
+						    page)]);
+	_stats.bytes += bytes;
+	_stats.entries++;
+
+	return node;
+}
+
+/* Bits of the page holding @start and the number of blocks covered */
+static u8 cache_mask(lbaint_t start, lbaint_t end, lbaint_t *count)
+{
+	lbaint_t first = start & (BLKCACHE_PAGE_BLOCKS - 1);
+	lbaint_t n = min((lbaint_t)(BLKCACHE_PAGE_BLOCKS - first),
+			 end - start);
+
+	*count = n;
+
+	return ((1 << n) - 1) << first;
+}
+
+int blkcache_read(int iftype, int devnum, int hwpart,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer)
 {
-	struct block_cache_node *node = cache_find(iftype, devnum, start,
-						   blkcnt, blksz);
-	if (node) {
-		const char *src = node->cache + (start - node->start) * blksz;
-		memcpy(buffer, src, blksz * blkcnt);
-		debug("hit: start " LBAF ", count " LBAFU "\n",
-		      start, blkcnt);
-		++_stats.hits;
-		return 1;
+	struct block_cache_node *node;
+	lbaint_t end = start + blkcnt;
+	lbaint_t blk, n;
+	u8 mask;
+
+	last_read.sequential = (last_read.iftype == iftype) &&
+			       (last_read.devnum == devnum) &&
+			       (last_read.hwpart == hwpart) &&
+			       (last_read.next == start);
+	last_read.iftype = iftype;
+	last_read.devnum = devnum;
+	last_read.hwpart = hwpart;
+	last_read.next = end;
+
+	/* don't cache big stuff */
+	if (blkcnt > _stats.max_blocks || !_stats.max_bytes)
+		return 0;
+
+	for (blk = start; blk < end; blk += n) {
+		mask = cache_mask(blk, end, &n);
+		node = cache_find(iftype, devnum, hwpart,
+				  blk >> BLKCACHE_PAGE_SHIFT, blksz);
+		if (!node || (node->valid & mask) != mask) {
+			debug("miss: start " LBAF ", count " LBAFU "\n",
+			      start, blkcnt);
+			++_stats.misses;
+			return 0;
+		}
+	}
+
+	for (blk = start; blk < end; blk += n) {
+		cache_mask(blk, end, &n);
+		node = cache_find(iftype, devnum, hwpart,
+				  blk >> BLKCACHE_PAGE_SHIFT, blksz);
+		memcpy(buffer,
+		       node->cache + (blk & (BLKCACHE_PAGE_BLOCKS - 1)) * blksz,
+		       n * blksz);
+		buffer += n * blksz;
+		cache_touch(node);
 	}
 
-	debug("miss: start " LBAF ", count " LBAFU "\n",
+	debug("hit: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
-	++_stats.misses;
-	return 0;
+	++_stats.hits;
+	_stats.bytes_saved += blkcnt * blksz;
+	return 1;
 }
 
-void blkcache_fill(int iftype, int devnum,
+lbaint_t blkcache_readahead(int iftype, int devnum,
+			    lbaint_t start, lbaint_t blkcnt,
+			    unsigned long blksz)
+{
+	lbaint_t ra = CONFIG_BLOCK_CACHE_READAHEAD;
+
+	if (!last_read.sequential || blkcnt >= ra || !_stats.max_bytes)
+		return blkcnt;
+
+	/* end the read ahead on a page boundary */
+	ra = ((start + ra) & ~(lbaint_t)(BLKCACHE_PAGE_BLOCKS - 1)) - start;
+	if (ra <= blkcnt)
+		return blkcnt;
+	if (ra > _stats.max_blocks)
+		ra = _stats.max_blocks;
+
+	debug("read ahead: start " LBAF ", count " LBAFU "\n", start, ra);
+	++_stats.readaheads;
+	return ra;
+}
+
+void blkcache_fill(int iftype, int devnum, int hwpart,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer)
 {
-	lbaint_t bytes;
 	struct block_cache_node *node;
+	lbaint_t end = start + blkcnt;
+	lbaint_t blk, n;
+	u8 mask;
 
 	/* don't cache big stuff */
-	if (blkcnt > _stats.max_blocks_per_entry)
+	if (blkcnt > _stats.max_blocks)
 		return;
 
-	if (_stats.max_entries == 0)
-		return;
+	debug("fill: start " LBAF ", count " LBAFU "\n",
+	      start, blkcnt);
 
-	bytes = blksz * blkcnt;
-	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
-		if (node->blkcnt * node->blksz < bytes) {
-			free(node->cache);
-			node->cache = 0;
+	for (blk = start; blk < end; blk += n) {
+		mask = cache_mask(blk, end, &n);
+		node = cache_find(iftype, devnum, hwpart,
+				  blk >> BLKCACHE_PAGE_SHIFT, blksz);
+		if (!node) {
+			node = cache_alloc(iftype, devnum, hwpart,
+					   blk >> BLKCACHE_PAGE_SHIFT, blksz);
+			if (!node)
+				return;
 		}
-	} else {
-		node = malloc(sizeof(*node));
-		if (!node)
-			return;
-		node->cache = 0;
+		memcpy(node->cache + (blk & (BLKCACHE_PAGE_BLOCKS - 1)) * blksz,
+		       buffer, n * blksz);
+		node->valid |= mask;
+		buffer += n * blksz;
+		cache_touch(node);
 	}
+}
 
-	if (!node->cache) {
-		node->cache = malloc(bytes);
-		if (!node->cache) {
-			free(node);
-			return;
-		}
+/*
+ * Apply @fn to the cached pages of a block range, walking the LRU list
+ * instead of looking up every page when the range is larger than the
+ * cache itself.
+ */
+static void cache_for_range(int iftype, int devnum, int hwpart,
+			    lbaint_t start, lbaint_t blkcnt,
+			    unsigned long blksz,
+			    void (*fn)(struct block_cache_node *node,
+				       lbaint_t start, lbaint_t end,
+				       const void *buffer),
+			    const void *buffer)
+{
+	struct block_cache_node *node, *n;
+	lbaint_t end = start + blkcnt;
+	lbaint_t first = start >> BLKCACHE_PAGE_SHIFT;
+	lbaint_t last = (end - 1) >> BLKCACHE_PAGE_SHIFT;
+	lbaint_t page;
+
+	if (!blkcnt || !_stats.entries)
+		return;
+
+	if (last - first >= _stats.entries) {
+		list_for_each_entry_safe(node, n, &block_cache, lh)
+			if ((node->iftype == iftype) &&
+			    (node->devnum == devnum) &&
+			    (node->hwpart == hwpart) &&
+			    (node->blksz == blksz) &&
+			    (node->page >= first) && (node->page <= last))
+				fn(node, start, end, buffer);
+		return;
 	}
 
-	debug("fill: start " LBAF ", count " LBAFU "\n",
-	      start, blkcnt);
+	for (page = first; page <= last; page++) {
+		node = cache_find(iftype, devnum, hwpart, page, blksz);
+		if (node)
+			fn(node, start, end, buffer);
+	}
+}
 
-	node->iftype = iftype;
-	node->devnum = devnum;
-	node->start = start;
-	node->blkcnt = blkcnt;
-	node->blksz = blksz;
-	memcpy(node->cache, buffer, bytes);
-	list_add(&node->lh, &block_cache);
-	_stats.entries++;
+static void cache_write_page(struct block_cache_node *node, lbaint_t start,
+			     lbaint_t end, const void *buffer)
+{
+	lbaint_t base = node->page << BLKCACHE_PAGE_SHIFT;
+	lbaint_t blk = max(start, base);
+	lbaint_t n;
+	u8 mask;
+
+	mask = cache_mask(blk, end, &n);
+	memcpy(node->cache + (blk - base) * node->blksz,
+	       buffer + (blk - start) * node->blksz, n * node->blksz);
+	node->valid |= mask;
+}
+
+static void cache_invalidate_page(struct block_cache_node *node,
+				  lbaint_t start, lbaint_t end,
+				  const void *buffer)
+{
+	lbaint_t base = node->page << BLKCACHE_PAGE_SHIFT;
+	lbaint_t n;
+
+	node->valid &= ~cache_mask(max(start, base), end, &n);
+	if (!node->valid)
+		cache_drop(node);
+}
+
+void blkcache_write(int iftype, int devnum, int hwpart,
+		    lbaint_t start, lbaint_t blkcnt,
+		    unsigned long blksz, void const *buffer)
+{
+	debug("write: start " LBAF ", count " LBAFU "\n", start, blkcnt);
+	cache_for_range(iftype, devnum, hwpart, start, blkcnt, blksz,
+			cache_write_page, buffer);
+}
+
+void blkcache_invalidate_range(int iftype, int devnum, int hwpart,
+			       lbaint_t start, lbaint_t blkcnt,
+			       unsigned long blksz)
+{
+	debug("invalidate: start " LBAF ", count " LBAFU "\n", start, blkcnt);
+	cache_for_range(iftype, devnum, hwpart, start, blkcnt, blksz,
+			cache_invalidate_page, NULL);
 }
 
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
-	struct block_cache_node *node;
+	struct block_cache_node *node, *n;
 
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
+	list_for_each_entry_safe(node, n, &block_cache, lh)
 		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum)) {
-			list_del(entry);
-			free(node->cache);
-			free(node);
-			--_stats.entries;
-		}
-	}
+		    (node->devnum == devnum))
+			cache_drop(node);
+
+	if ((last_read.iftype == iftype) && (last_read.devnum == devnum))
+		last_read.iftype = -1;
 }
 
-void blkcache_configure(unsigned blocks, unsigned entries)
+void blkcache_configure(unsigned blocks, unsigned long bytes)
 {
 	struct block_cache_node *node;
-	if ((blocks != _stats.max_blocks_per_entry) ||
-	    (entries != _stats.max_entries)) {
+
+	if ((blocks != _stats.max_blocks) ||
+	    (bytes != _stats.max_bytes)) {
 		/* invalidate cache */
 		while (!list_empty(&block_cache)) {
-			node = (struct block_cache_node *)block_cache.next;
-			list_del(&node->lh);
-			free(node->cache);
-			free(node);
+			node = list_first_entry(&block_cache,
+						struct block_cache_node, lh);
+			cache_drop(node);
 		}
-		_stats.entries = 0;
 	}
 
-	_stats.max_blocks_per_entry = blocks;
-	_stats.max_entries = entries;
+	_stats.max_blocks = blocks;
+	_stats.max_bytes = bytes;
 
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.readaheads = 0;
+	_stats.bytes_saved = 0;
 }
 
 void blkcache_stats(struct block_cache_stats *stats)
@@ -169,4 +389,6 @@ void blkcache_stats(struct block_cache_stats *stats)
 	memcpy(stats, &_stats, sizeof(*stats));
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.readaheads = 0;
+	_stats.bytes_saved = 0;
 }
@@ -305,6 +305,21 @@ static void *alloc_priv(int size, uint flags)
 	return priv;
 }
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_TIMELINE)
+static void device_probe_timed(struct udevice *dev, ulong start_us)
+{
+	const char *name = dev->name;
+
+	/* the record outlives devices which are unbound again, like USB */
+	if (dev->flags & DM_FLAG_NAME_ALLOCED) {
+		name = strdup(name);
+		if (!name)
+			return;
+	}
+	bootstage_add_span(name, start_us);
+}
+#endif
+
 int device_probe(struct udevice *dev)
 {
 	struct power_domain pd;
@@ -312,6 +327,9 @@ int device_probe(struct udevice *dev)
 	int size = 0;
 	int ret;
 	int seq;
+#if CONFIG_IS_ENABLED(BOOTSTAGE_TIMELINE)
+	ulong start_us = 0;
+#endif
 
 	if (!dev)
 		return -EINVAL;
@@ -370,12 +388,16 @@ int device_probe(struct udevice *dev)
 			return 0;
 	}
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_TIMELINE)
+	if (gd->bootstage)
+		start_us = timer_get_boot_us();
+#endif
 	seq = uclass_resolve_seq(dev);
 	if (seq < 0) {
 		ret = seq;
 		goto fail;
 	}
-	dev->seq = seq;
+	uclass_set_seq(dev, seq);
 
 	dev->flags |= DM_FLAG_ACTIVATED;
 
@@ -429,6 +451,11 @@ int device_probe(struct udevice *dev)
 	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
 		pinctrl_select_state(dev, "default");
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_TIMELINE)
+	if (start_us)
+		device_probe_timed(dev, start_us);
+#endif
+
 	return 0;
 fail_uclass:
 	if (device_remove(dev, DM_REMOVE_NORMAL)) {
@@ -438,12 +465,21 @@ fail_uclass:
 fail:
 	dev->flags &= ~DM_FLAG_ACTIVATED;
 
-	dev->seq = -1;
+	uclass_set_seq(dev, -1);
 	device_free(dev);
 
 	return ret;
 }
 
+#if CONFIG_IS_ENABLED(DM_LOOKUP_INDEX)
+void dev_set_ofnode(struct udevice *dev, ofnode node)
+{
+	uclass_node_index_del(dev);
+	dev->node = node;
+	uclass_node_index_add(dev);
+}
+#endif
+
 void *dev_get_platdata(const struct udevice *dev)
 {
 	if (!dev) {
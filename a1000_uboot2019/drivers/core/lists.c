@@ -15,7 +15,11 @@
 #include <dm/uclass.h>
 #include <dm/util.h>
 #include <fdtdec.h>
+#include <malloc.h>
 #include <linux/compiler.h>
+#include <linux/log2.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 struct driver *lists_driver_lookup_name(const char *name)
 {
@@ -122,11 +126,111 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
-int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
-		   bool pre_reloc_only)
+#if CONFIG_IS_ENABLED(DM_LOOKUP_INDEX)
+struct compat_entry {
+	const struct udevice_id *id;	/* NULL if this slot is free */
+	struct driver *drv;
+};
+
+/*
+ * Open-addressed hash table from compatible string to driver. It is built on
+ * first use after relocation, when BSS is available and the driver table
+ * has its final addresses.
+ */
+static struct compat_entry *compat_index;
+static uint compat_index_mask;
+
+static uint compat_hash(const char *compat)
+{
+	uint hash = 2166136261U;
+
+	while (*compat)
+		hash = (hash ^ (u8)*compat++) * 16777619;
+
+	return hash;
+}
+
+static struct compat_entry *compat_index_slot(const char *compat)
+{
+	struct compat_entry *entry;
+	uint i;
+
+	for (i = compat_hash(compat); ; i++) {
+		entry = &compat_index[i & compat_index_mask];
+		if (!entry->id || !strcmp(entry->id->compatible, compat))
+			return entry;
+	}
+}
+
+static int compat_index_build(void)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *id;
+	struct compat_entry *slot;
+	struct driver *entry;
+	uint count = 0;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++)
+			count++;
+	}
+
+	/* Keep the table at most half full */
+	compat_index_mask = roundup_pow_of_two(count * 2 + 1) - 1;
+	compat_index = calloc(compat_index_mask + 1, sizeof(*compat_index));
+	if (!compat_index)
+		return -ENOMEM;
+
+	/* The first driver to list a string wins, as in a linear search */
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++) {
+			slot = compat_index_slot(id->compatible);
+			if (!slot->id) {
+				slot->id = id;
+				slot->drv = entry;
+			}
+		}
+	}
+
+	return 0;
+}
+#endif
+
+/**
+ * lists_driver_lookup_compat() - Find the driver for a compatible string
+ *
+ * @compat:	The compatible string to search for
+ * @of_idp:	Returns the match that was found
+ * @return the first driver in the driver list which matches, or NULL
+ */
+static struct driver *lists_driver_lookup_compat(const char *compat,
+					const struct udevice_id **of_idp)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
+	struct driver *entry;
+
+#if CONFIG_IS_ENABLED(DM_LOOKUP_INDEX)
+	if ((gd->flags & GD_FLG_RELOC) &&
+	    (compat_index || !compat_index_build())) {
+		struct compat_entry *slot = compat_index_slot(compat);
+
+		*of_idp = slot->id;
+		return slot->drv;
+	}
+#endif
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		if (!driver_check_compatible(entry->of_match, of_idp, compat))
+			return entry;
+	}
+
+	return NULL;
+}
+
+int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
+		   bool pre_reloc_only)
+{
 	const struct udevice_id *id;
 	struct driver *entry;
 	struct udevice *dev;
@@ -163,13 +267,8 @@ int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 		pr_debug("   - attempt to match compatible string '%s'\n",
 			 compat);
 
-		for (entry = driver; entry != driver + n_ents; entry++) {
-			ret = driver_check_compatible(entry->of_match, &id,
-						      compat);
-			if (!ret)
-				break;
-		}
-		if (entry == driver + n_ents)
+		entry = lists_driver_lookup_compat(compat, &id);
+		if (!entry)
 			continue;
 
 		if (pre_reloc_only) {
@@ -171,10 +171,10 @@ int dm_init(bool of_live)
 #if CONFIG_IS_ENABLED(OF_CONTROL)
 # if CONFIG_IS_ENABLED(OF_LIVE)
 	if (of_live)
-		DM_ROOT_NON_CONST->node = np_to_ofnode(gd->of_root);
+		dev_set_ofnode(DM_ROOT_NON_CONST, np_to_ofnode(gd->of_root));
 	else
 #endif
-		DM_ROOT_NON_CONST->node = offset_to_ofnode(0);
+		dev_set_ofnode(DM_ROOT_NON_CONST, offset_to_ofnode(0));
 #endif
 	ret = device_probe(DM_ROOT_NON_CONST);
 	if (ret)
@@ -416,6 +416,73 @@ int dm_init_and_scan(bool pre_reloc_only)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(DM_LAZY_PROBE)
+/**
+ * dm_probe_next_early() - Get the next uclass from DM_LAZY_PROBE_EARLY
+ *
+ * @listp: Current position in the list, updated to point after the name
+ * @return uclass ID, UCLASS_INVALID if the name is unknown, or -ENOENT at
+ * the end of the list
+ */
+static int dm_probe_next_early(const char **listp)
+{
+	const char *start = *listp;
+	const char *end;
+	char name[32];
+
+	while (*start == ' ')
+		start++;
+	if (!*start)
+		return -ENOENT;
+	end = strchrnul(start, ' ');
+	*listp = end;
+	if (end - start >= sizeof(name))
+		return UCLASS_INVALID;
+	strlcpy(name, start, end - start + 1);
+
+	return uclass_get_by_name(name);
+}
+
+bool dm_probe_deferred(enum uclass_id id)
+{
+	const char *list = CONFIG_DM_LAZY_PROBE_EARLY;
+	int early;
+
+	while ((early = dm_probe_next_early(&list)) != -ENOENT) {
+		if (early == id)
+			return false;
+	}
+
+	return true;
+}
+
+int dm_probe_early(void)
+{
+	const char *list = CONFIG_DM_LAZY_PROBE_EARLY;
+	struct udevice *dev;
+	struct uclass *uc;
+	int id, ret;
+
+	while ((id = dm_probe_next_early(&list)) != -ENOENT) {
+		if (id == UCLASS_INVALID) {
+			dm_warn("Unknown uclass in DM_LAZY_PROBE_EARLY\n");
+			continue;
+		}
+		ret = uclass_get(id, &uc);
+		if (ret)
+			return ret;
+		uclass_foreach_dev(dev, uc) {
+			ret = device_probe(dev);
+			if (ret)
+				dm_warn("%s - probe failed: %d\n", dev->name,
+					ret);
+		}
+	}
+
+	return 0;
+}
+#endif
+
 /* This is the root driver - all drivers are children of this */
 U_BOOT_DRIVER(root_driver) = {
 	.name	= "root_driver",
@@ -130,6 +130,10 @@ int uclass_destroy(struct uclass *uc)
 	list_del(&uc->sibling_node);
 	if (uc_drv->priv_auto_alloc_size)
 		free(uc->priv);
+#if CONFIG_IS_ENABLED(DM_LOOKUP_INDEX)
+	free(uc->seq_index);
+	free(uc->node_index);
+#endif
 	free(uc);
 
 	return 0;
@@ -293,6 +297,144 @@ int uclass_find_next_free_req_seq(enum uclass_id id)
 }
 #endif
 
+#if CONFIG_IS_ENABLED(DM_LOOKUP_INDEX)
+enum {
+	/* log2 of the number of buckets when a node index is created */
+	UCLASS_NODE_INDEX_MIN_BITS	= 4,
+	/* the seq index grows in steps of this many entries */
+	UCLASS_SEQ_INDEX_STEP		= 8,
+};
+
+static uint uclass_node_hash(struct uclass *uc, ofnode node)
+{
+	/* the node is either an FDT offset or a device_node pointer */
+	ulong key = (ulong)node.of_offset;
+
+	if (sizeof(key) > sizeof(u32))
+		key ^= key >> 16 >> 16;
+
+	return ((u32)key * 0x9e3779b1) >> (32 - uc->node_index_bits);
+}
+
+/**
+ * uclass_node_index_build() - Set up the node index of a uclass from scratch
+ *
+ * All devices in the uclass with a device tree node are added, in the order
+ * of the uclass's list, so a lookup finds the same device as a search.
+ *
+ * @uc: Uclass to update
+ * @bits: log2 of the number of hash buckets to use
+ * @return 0 if OK, -ENOMEM if out of memory (the old index is kept)
+ */
+static int uclass_node_index_build(struct uclass *uc, uint bits)
+{
+	struct list_head *index;
+	struct udevice *dev;
+	int i;
+
+	index = malloc(sizeof(*index) << bits);
+	if (!index)
+		return -ENOMEM;
+	for (i = 0; i < 1 << bits; i++)
+		INIT_LIST_HEAD(&index[i]);
+
+	free(uc->node_index);
+	uc->node_index = index;
+	uc->node_index_bits = bits;
+	uc->node_count = 0;
+	list_for_each_entry(dev, &uc->dev_head, uclass_node) {
+		if (!ofnode_valid(dev->node))
+			continue;
+		list_add_tail(&dev->node_index_node,
+			      &index[uclass_node_hash(uc, dev->node)]);
+		uc->node_count++;
+	}
+
+	return 0;
+}
+
+void uclass_node_index_add(struct udevice *dev)
+{
+	struct uclass *uc = dev->uclass;
+
+	INIT_LIST_HEAD(&dev->node_index_node);
+	if (!ofnode_valid(dev->node))
+		return;
+
+	/* Keep the average chain length at two or less */
+	if (!uc->node_index) {
+		uclass_node_index_build(uc, UCLASS_NODE_INDEX_MIN_BITS);
+		return;
+	} else if (uc->node_count >= 2U << uc->node_index_bits &&
+		   !uclass_node_index_build(uc, uc->node_index_bits + 1)) {
+		return;
+	}
+
+	list_add_tail(&dev->node_index_node,
+		      &uc->node_index[uclass_node_hash(uc, dev->node)]);
+	uc->node_count++;
+}
+
+void uclass_node_index_del(struct udevice *dev)
+{
+	if (list_empty(&dev->node_index_node))
+		return;
+	list_del_init(&dev->node_index_node);
+	dev->uclass->node_count--;
+}
+
+/* Look up a device in the node index, returning -ENOSYS if there is none */
+static int uclass_node_index_find(struct uclass *uc, ofnode node,
+				  struct udevice **devp)
+{
+	struct list_head *head;
+	struct udevice *dev;
+
+	if (!uc->node_index)
+		return -ENOSYS;
+	head = &uc->node_index[uclass_node_hash(uc, node)];
+	list_for_each_entry(dev, head, node_index_node) {
+		if (ofnode_equal(dev->node, node)) {
+			*devp = dev;
+			return 0;
+		}
+	}
+
+	return -ENODEV;
+}
+
+/* Make room for @seq in the seq index, or switch to searching the list */
+static void uclass_seq_index_grow(struct uclass *uc, int seq)
+{
+	int size = ALIGN(seq + 1, UCLASS_SEQ_INDEX_STEP);
+	struct udevice **index;
+
+	index = calloc(size, sizeof(*index));
+	if (index && uc->seq_index_size)
+		memcpy(index, uc->seq_index,
+		       uc->seq_index_size * sizeof(*index));
+	free(uc->seq_index);
+	uc->seq_index = index;
+	uc->seq_index_size = index ? size : -1;
+}
+#endif
+
+void uclass_set_seq(struct udevice *dev, int seq)
+{
+#if CONFIG_IS_ENABLED(DM_LOOKUP_INDEX)
+	struct uclass *uc = dev->uclass;
+
+	if (dev->seq >= 0 && dev->seq < uc->seq_index_size &&
+	    uc->seq_index[dev->seq] == dev)
+		uc->seq_index[dev->seq] = NULL;
+	if (seq >= uc->seq_index_size && uc->seq_index_size != -1)
+		uclass_seq_index_grow(uc, seq);
+	if (seq >= 0 && seq < uc->seq_index_size)
+		uc->seq_index[seq] = dev;
+#endif
+	dev->seq = seq;
+}
+
 int uclass_find_device_by_seq(enum uclass_id id, int seq_or_req_seq,
 			      bool find_req_seq, struct udevice **devp)
 {
@@ -308,6 +450,16 @@ int uclass_find_device_by_seq(enum uclass_id id, int seq_or_req_seq,
 	if (ret)
 		return ret;
 
+#if CONFIG_IS_ENABLED(DM_LOOKUP_INDEX)
+	/* Only probed devices are indexed, as drivers may change req_seq */
+	if (!find_req_seq && uc->seq_index_size != -1) {
+		if (seq_or_req_seq < 0 || seq_or_req_seq >= uc->seq_index_size ||
+		    !uc->seq_index[seq_or_req_seq])
+			return -ENODEV;
+		*devp = uc->seq_index[seq_or_req_seq];
+		return 0;
+	}
+#endif
 	uclass_foreach_dev(dev, uc) {
 		debug("   - %d %d '%s'\n", dev->req_seq, dev->seq, dev->name);
 		if ((find_req_seq ? dev->req_seq : dev->seq) ==
@@ -336,6 +488,11 @@ int uclass_find_device_by_of_offset(enum uclass_id id, int node,
 	if (ret)
 		return ret;
 
+#if CONFIG_IS_ENABLED(DM_LOOKUP_INDEX)
+	ret = uclass_node_index_find(uc, offset_to_ofnode(node), devp);
+	if (ret != -ENOSYS)
+		return ret;
+#endif
 	uclass_foreach_dev(dev, uc) {
 		if (dev_of_offset(dev) == node) {
 			*devp = dev;
@@ -361,6 +518,12 @@ int uclass_find_device_by_ofnode(enum uclass_id id, ofnode node,
 	if (ret)
 		return ret;
 
+#if CONFIG_IS_ENABLED(DM_LOOKUP_INDEX)
+	ret = uclass_node_index_find(uc, node, devp);
+	if (ret != -ENOSYS)
+		goto done;
+	ret = 0;
+#endif
 	uclass_foreach_dev(dev, uc) {
 		log(LOGC_DM, LOGL_DEBUG_CONTENT, "      - checking %s\n",
 		    dev->name);
@@ -631,6 +794,9 @@ int uclass_bind_device(struct udevice *dev)
 
 	uc = dev->uclass;
 	list_add_tail(&dev->uclass_node, &uc->dev_head);
+#if CONFIG_IS_ENABLED(DM_LOOKUP_INDEX)
+	uclass_node_index_add(dev);
+#endif
 
 	if (dev->parent) {
 		struct uclass_driver *uc_drv = dev->parent->uclass->uc_drv;
@@ -645,6 +811,9 @@ int uclass_bind_device(struct udevice *dev)
 	return 0;
 err:
 	/* There is no need to undo the parent's post_bind call */
+#if CONFIG_IS_ENABLED(DM_LOOKUP_INDEX)
+	uclass_node_index_del(dev);
+#endif
 	list_del(&dev->uclass_node);
 
 	return ret;
@@ -663,6 +832,9 @@ int uclass_unbind_device(struct udevice *dev)
 			return ret;
 	}
 
+#if CONFIG_IS_ENABLED(DM_LOOKUP_INDEX)
+	uclass_node_index_del(dev);
+#endif
 	list_del(&dev->uclass_node);
 	return 0;
 }
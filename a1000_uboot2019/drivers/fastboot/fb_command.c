@@ -4,12 +4,14 @@
  */
 
 #include <common.h>
+#include <div64.h>
 #include <fastboot.h>
 #include <fastboot-internal.h>
 #include <fb_mmc.h>
 #include <fb_nand.h>
 #include <part.h>
 #include <stdlib.h>
+#include <linux/sizes.h>
 
 /**
  * image_size - final fastboot image size
@@ -26,6 +28,33 @@ static u32 fastboot_bytes_received;
  */
 static u32 fastboot_bytes_expected;
 
+/**
+ * fastboot_download_start - timer value when the current download started
+ */
+static ulong fastboot_download_start;
+
+/**
+ * fastboot_download_speed - throughput of the last download, in KiB/s
+ */
+u32 fastboot_download_speed;
+
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+/**
+ * fastboot_stream_part - partition downloads are written to as they arrive
+ */
+static char fastboot_stream_part[PART_NAME_LEN + 1];
+
+/**
+ * fastboot_bytes_streamed - bytes of the current download written so far
+ */
+static u32 fastboot_bytes_streamed;
+
+/**
+ * fastboot_streamed - the last download was written to fastboot_stream_part
+ */
+static bool fastboot_streamed;
+#endif
+
 static void okay(char *, char *);
 static void getvar(char *, char *);
 static void download(char *, char *);
@@ -37,6 +66,9 @@ static void reboot_bootloader(char *, char *);
 #if CONFIG_IS_ENABLED(FASTBOOT_CMD_OEM_FORMAT)
 static void oem_format(char *, char *);
 #endif
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+static void oem_stream(char *, char *);
+#endif
 
 static const struct {
 	const char *command;
@@ -86,6 +118,12 @@ static const struct {
 		.dispatch = oem_format,
 	},
 #endif
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+	[FASTBOOT_COMMAND_OEM_STREAM] = {
+		.command = "oem stream",
+		.dispatch = oem_stream,
+	},
+#endif
 };
 
 /**
@@ -147,6 +185,116 @@ static void getvar(char *cmd_parameter, char *response)
 	fastboot_getvar(cmd_parameter, response);
 }
 
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+static bool fastboot_streaming(void)
+{
+	return fastboot_stream_part[0];
+}
+
+/**
+ * fastboot_stream_start() - Start writing a download as it arrives
+ *
+ * @response: Pointer to fastboot response buffer
+ *
+ * Return: 0 if OK or not streaming, -1 on error
+ */
+static int fastboot_stream_start(char *response)
+{
+	if (!fastboot_streaming())
+		return 0;
+
+	fastboot_bytes_streamed = 0;
+	fastboot_streamed = false;
+	return fastboot_mmc_stream_start(fastboot_stream_part, response);
+}
+
+/**
+ * fastboot_stream_write() - Write the data received but not written yet
+ *
+ * @all: Write everything, not only once CONFIG_FASTBOOT_FLASH_STREAM_SIZE
+ *	 bytes are waiting
+ * @response: Pointer to fastboot response buffer
+ *
+ * Return: 0 if OK or not streaming, -1 on error
+ */
+static int fastboot_stream_write(bool all, char *response)
+{
+	u32 min_len = all ? 0 : CONFIG_FASTBOOT_FLASH_STREAM_SIZE;
+	void (*progress)(const char *msg) = fastboot_progress_callback;
+	u32 offset, len;
+	int ret = 0;
+
+	if (!fastboot_streaming() ||
+	    fastboot_bytes_received - fastboot_bytes_streamed < min_len)
+		return 0;
+
+	/* the client does not expect INFO responses during the data phase */
+	fastboot_progress_callback = NULL;
+	while (!ret && fastboot_bytes_streamed < fastboot_bytes_received) {
+		offset = fastboot_bytes_streamed % fastboot_buf_size;
+		len = min(fastboot_bytes_received - fastboot_bytes_streamed,
+			  fastboot_buf_size - offset);
+		ret = fastboot_mmc_stream_write(fastboot_buf_addr + offset,
+						len, response);
+		fastboot_bytes_streamed += len;
+	}
+	fastboot_progress_callback = progress;
+
+	return ret;
+}
+
+/**
+ * fastboot_stream_end() - Write the rest of a download
+ *
+ * @response: Pointer to fastboot response buffer
+ *
+ * Return: 0 if OK or not streaming, -1 on error
+ */
+static int fastboot_stream_end(char *response)
+{
+	if (!fastboot_streaming())
+		return 0;
+
+	if (fastboot_stream_write(true, response) ||
+	    fastboot_mmc_stream_end(fastboot_stream_part, response))
+		return -1;
+
+	fastboot_streamed = true;
+	return 0;
+}
+#else
+static inline bool fastboot_streaming(void)
+{
+	return false;
+}
+
+static inline int fastboot_stream_start(char *response)
+{
+	return 0;
+}
+
+static inline int fastboot_stream_write(bool all, char *response)
+{
+	return 0;
+}
+
+static inline int fastboot_stream_end(char *response)
+{
+	return 0;
+}
+#endif
+
+/**
+ * fastboot_download_max() - Largest download the client may send
+ *
+ * Return: Size of the fastboot buffer, or the largest size the protocol
+ *	   allows while downloads are written as they arrive
+ */
+u32 fastboot_download_max(void)
+{
+	return fastboot_streaming() ? FASTBOOT_STREAM_MAX : fastboot_buf_size;
+}
+
 /**
  * fastboot_download() - Start a download transfer from the client
  *
@@ -173,11 +321,12 @@ static void download(char *cmd_parameter, char *response)
 	 *
 	 * where cmd_parameter is an 8 digit hexadecimal number
 	 */
-	if (fastboot_bytes_expected > fastboot_buf_size) {
+	if (fastboot_bytes_expected > fastboot_download_max()) {
 		fastboot_fail(cmd_parameter, response);
-	} else {
+	} else if (!fastboot_stream_start(response)) {
 		printf("Starting Download of %d bytes\n",
 		       fastboot_bytes_expected);
+		fastboot_download_start = get_timer(0);
 		fastboot_response("DATA", response, "%s", cmd_parameter);
 	}
 }
@@ -209,6 +358,40 @@ u32 fastboot_data_remaining(void)
 void fastboot_data_download(const void *fastboot_data,
 			    unsigned int fastboot_data_len,
 			    char *response)
+{
+	u32 offset, len;
+
+	if (fastboot_data_len == 0 ||
+	    (fastboot_bytes_received + fastboot_data_len) >
+	    fastboot_bytes_expected) {
+		fastboot_fail("Received invalid data length",
+			      response);
+		return;
+	}
+	/*
+	 * Download data to fastboot_buf_addr, which is used as a ring while
+	 * the download is written as it arrives
+	 */
+	offset = fastboot_bytes_received % fastboot_buf_size;
+	len = min(fastboot_data_len, fastboot_buf_size - offset);
+	memcpy(fastboot_buf_addr + offset, fastboot_data, len);
+	memcpy(fastboot_buf_addr, fastboot_data + len,
+	       fastboot_data_len - len);
+
+	fastboot_data_received(fastboot_data_len, response);
+}
+
+/**
+ * fastboot_data_received() - Account for data received in place
+ *
+ * @fastboot_data_len: Number of bytes written to fastboot_buf_addr at the
+ *		       current download offset
+ * @response: Pointer to fastboot response buffer
+ *
+ * Like fastboot_data_download(), for transports which receive the image
+ * directly into fastboot_buf_addr.
+ */
+void fastboot_data_received(unsigned int fastboot_data_len, char *response)
 {
 #define BYTES_PER_DOT	0x20000
 	u32 pre_dot_num, now_dot_num;
@@ -220,9 +403,6 @@ void fastboot_data_download(const void *fastboot_data,
 			      response);
 		return;
 	}
-	/* Download data to fastboot_buf_addr */
-	memcpy(fastboot_buf_addr + fastboot_bytes_received,
-	       fastboot_data, fastboot_data_len);
 
 	pre_dot_num = fastboot_bytes_received / BYTES_PER_DOT;
 	fastboot_bytes_received += fastboot_data_len;
@@ -234,6 +414,8 @@ void fastboot_data_download(const void *fastboot_data,
 			putc('\n');
 	}
 	*response = '\0';
+
+	fastboot_stream_write(false, response);
 }
 
 /**
@@ -245,10 +427,17 @@ void fastboot_data_download(const void *fastboot_data,
  */
 void fastboot_data_complete(char *response)
 {
+	ulong ms = max(get_timer(fastboot_download_start), 1UL);
+
 	/* Download complete. Respond with "OKAY" */
-	fastboot_okay(NULL, response);
-	printf("\ndownloading of %d bytes finished\n", fastboot_bytes_received);
-	image_size = fastboot_bytes_received;
+	if (!fastboot_stream_end(response))
+		fastboot_okay(NULL, response);
+	fastboot_download_speed = lldiv((u64)fastboot_bytes_received * 1000,
+					ms * 1024);
+	printf("\ndownloading of %d bytes finished in %lu ms (%u KiB/s)\n",
+	       fastboot_bytes_received, ms, fastboot_download_speed);
+	/* a streamed image is not in the buffer */
+	image_size = fastboot_streaming() ? 0 : fastboot_bytes_received;
 	env_set_hex("filesize", image_size);
 	fastboot_bytes_expected = 0;
 	fastboot_bytes_received = 0;
@@ -271,9 +460,23 @@ void bst_fastboot_download_mem(void *dst)
  */
 static void flash(char *cmd_parameter, char *response)
 {
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+	if (fastboot_streaming()) {
+		if (!fastboot_streamed || !cmd_parameter ||
+		    strcmp(cmd_parameter, fastboot_stream_part))
+			fastboot_fail("image was not streamed to partition",
+				      response);
+		else
+			fastboot_okay(NULL, response);
+		fastboot_streamed = false;
+		fastboot_mmc_flush(response);
+		return;
+	}
+#endif
 #if CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC)
 	fastboot_mmc_flash_write(cmd_parameter, fastboot_buf_addr, image_size,
 				 response);
+	fastboot_mmc_flush(response);
 #endif
 #if CONFIG_IS_ENABLED(FASTBOOT_FLASH_NAND)
 	fastboot_nand_flash_write(cmd_parameter, fastboot_buf_addr, image_size,
@@ -294,6 +497,7 @@ static void erase(char *cmd_parameter, char *response)
 {
 #if CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC)
 	fastboot_mmc_erase(cmd_parameter, response);
+	fastboot_mmc_flush(response);
 #endif
 #if CONFIG_IS_ENABLED(FASTBOOT_FLASH_NAND)
 	fastboot_nand_erase(cmd_parameter, response);
@@ -335,6 +539,55 @@ static void oem_format(char *cmd_parameter, char *response)
 			fastboot_fail("", response);
 		else
 			fastboot_okay(NULL, response);
+		fastboot_mmc_flush(response);
+	}
+}
+#endif
+
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+/* The USB transport has two download requests in flight in the ring */
+#ifdef CONFIG_FASTBOOT_USB_DL_CHUNK_SIZE
+#define FASTBOOT_STREAM_IN_FLIGHT	(2 * CONFIG_FASTBOOT_USB_DL_CHUNK_SIZE)
+#else
+#define FASTBOOT_STREAM_IN_FLIGHT	0
+#endif
+
+/**
+ * oem_stream() - Write the following downloads to a partition as they arrive
+ *
+ * @cmd_parameter: Pointer to partition name, or NULL to stop streaming
+ * @response: Pointer to fastboot response buffer
+ */
+static void oem_stream(char *cmd_parameter, char *response)
+{
+	struct blk_desc *dev_desc;
+	disk_partition_t info;
+
+	fastboot_stream_part[0] = '\0';
+	fastboot_streamed = false;
+	if (!cmd_parameter || !*cmd_parameter) {
+		fastboot_okay(NULL, response);
+		return;
 	}
+
+	if (strlen(cmd_parameter) >= sizeof(fastboot_stream_part)) {
+		fastboot_fail("partition name too long", response);
+		return;
+	}
+	/* the USB transport needs whole packets up to the end of the ring */
+	if (fastboot_buf_size < 4 * CONFIG_FASTBOOT_FLASH_STREAM_SIZE ||
+	    fastboot_buf_size < CONFIG_FASTBOOT_FLASH_STREAM_SIZE +
+				FASTBOOT_STREAM_IN_FLIGHT ||
+	    !IS_ALIGNED(fastboot_buf_size, SZ_4K)) {
+		fastboot_fail("buffer not suitable for streaming", response);
+		return;
+	}
+	if (fastboot_mmc_get_part_info(cmd_parameter, &dev_desc, &info,
+				       response) < 0)
+		return;
+
+	strcpy(fastboot_stream_part, cmd_parameter);
+	printf("Writing downloads to '%s' as they arrive\n", cmd_parameter);
+	fastboot_okay(NULL, response);
 }
 #endif
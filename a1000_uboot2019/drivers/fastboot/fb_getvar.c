@@ -14,6 +14,7 @@
 static void getvar_version(char *var_parameter, char *response);
 static void getvar_bootloader_version(char *var_parameter, char *response);
 static void getvar_downloadsize(char *var_parameter, char *response);
+static void getvar_download_speed(char *var_parameter, char *response);
 static void getvar_serialno(char *var_parameter, char *response);
 static void getvar_version_baseband(char *var_parameter, char *response);
 static void getvar_product(char *var_parameter, char *response);
@@ -46,6 +47,9 @@ static const struct {
 	}, {
 		.variable = "max-download-size",
 		.dispatch = getvar_downloadsize
+	}, {
+		.variable = "download-speed",
+		.dispatch = getvar_download_speed
 	}, {
 		.variable = "serialno",
 		.dispatch = getvar_serialno
@@ -89,7 +93,13 @@ static void getvar_bootloader_version(char *var_parameter, char *response)
 
 static void getvar_downloadsize(char *var_parameter, char *response)
 {
-	fastboot_response("OKAY", response, "0x%08x", fastboot_buf_size);
+	fastboot_response("OKAY", response, "0x%08x", fastboot_download_max());
+}
+
+static void getvar_download_speed(char *var_parameter, char *response)
+{
+	fastboot_response("OKAY", response, "%u KiB/s",
+			  fastboot_download_speed);
 }
 
 static void getvar_serialno(char *var_parameter, char *response)
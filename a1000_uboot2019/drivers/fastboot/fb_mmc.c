@@ -98,6 +98,30 @@ static lbaint_t fb_mmc_sparse_reserve(struct sparse_storage *info,
 	return blkcnt;
 }
 
+static lbaint_t fb_mmc_sparse_erase(struct sparse_storage *info,
+		lbaint_t blk, lbaint_t blkcnt, bool zero)
+{
+	struct fb_mmc_sparse *sparse = info->priv;
+	struct blk_desc *dev_desc = sparse->dev_desc;
+	struct mmc *mmc = find_mmc_device(dev_desc->devnum);
+	lbaint_t blks = 0;
+
+	if (!mmc || !mmc->ext_csd)
+		return 0;
+	/* trimmed blocks read back as the erased memory content */
+	if (zero && mmc->ext_csd[EXT_CSD_ERASED_MEM_CONT])
+		return 0;
+
+	if (fastboot_progress_callback)
+		fastboot_progress_callback("erasing");
+	if (!zero)
+		blks = mmc_trim(dev_desc, blk, blkcnt, MMC_DISCARD_ARG);
+	if (!blks)
+		blks = mmc_trim(dev_desc, blk, blkcnt, MMC_TRIM_ARG);
+
+	return blks;
+}
+
 static void write_raw_image(struct blk_desc *dev_desc, disk_partition_t *info,
 		const char *part_name, void *buffer,
 		u32 download_bytes, char *response)
@@ -415,6 +439,7 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 		sparse.size = info.size;
 		sparse.write = fb_mmc_sparse_write;
 		sparse.reserve = fb_mmc_sparse_reserve;
+		sparse.erase = fb_mmc_sparse_erase;
 		sparse.mssg = fastboot_fail;
 
 		printf("Flashing sparse image at offset " LBAFU "\n",
@@ -431,6 +456,82 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 	}
 }
 
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+static struct fb_mmc_stream {
+	struct fb_mmc_sparse	sparse_priv;
+	struct sparse_storage	sparse;
+	struct sparse_stream	stream;
+} fb_mmc_stream;
+
+/**
+ * fastboot_mmc_stream_start() - Start writing a download to eMMC
+ *
+ * @cmd: Named partition to write the image to
+ * @response: Pointer to fastboot response buffer
+ * @return 0 if OK, -1 on error
+ */
+int fastboot_mmc_stream_start(const char *cmd, char *response)
+{
+	struct fb_mmc_stream *s = &fb_mmc_stream;
+	struct blk_desc *dev_desc;
+	disk_partition_t info;
+
+	dev_desc = blk_get_dev("mmc", CONFIG_FASTBOOT_FLASH_MMC_DEV);
+	if (!dev_desc || dev_desc->type == DEV_TYPE_UNKNOWN) {
+		pr_err("invalid mmc device\n");
+		fastboot_fail("invalid mmc device", response);
+		return -1;
+	}
+
+	if (part_get_info_by_name_or_alias(dev_desc, cmd, &info) < 0) {
+		pr_err("cannot find partition: '%s'\n", cmd);
+		fastboot_fail("cannot find partition", response);
+		return -1;
+	}
+
+	s->sparse_priv.dev_desc = dev_desc;
+
+	s->sparse.blksz = info.blksz;
+	s->sparse.start = info.start;
+	s->sparse.size = info.size;
+	s->sparse.write = fb_mmc_sparse_write;
+	s->sparse.reserve = fb_mmc_sparse_reserve;
+	s->sparse.erase = fb_mmc_sparse_erase;
+	s->sparse.mssg = fastboot_fail;
+	s->sparse.priv = &s->sparse_priv;
+
+	printf("Streaming image to '%s' at offset " LBAFU "\n", cmd,
+	       s->sparse.start);
+
+	return sparse_stream_init(&s->stream, &s->sparse, response);
+}
+
+/**
+ * fastboot_mmc_stream_write() - Write the next part of a download to eMMC
+ *
+ * @data: Pointer to the data following the previous part
+ * @len: Size of the data
+ * @response: Pointer to fastboot response buffer
+ * @return 0 if OK, -1 on error
+ */
+int fastboot_mmc_stream_write(const void *data, u32 len, char *response)
+{
+	return sparse_stream_write(&fb_mmc_stream.stream, data, len, response);
+}
+
+/**
+ * fastboot_mmc_stream_end() - Finish writing a download to eMMC
+ *
+ * @cmd: Named partition the image was written to
+ * @response: Pointer to fastboot response buffer
+ * @return 0 if OK, -1 on error
+ */
+int fastboot_mmc_stream_end(const char *cmd, char *response)
+{
+	return sparse_stream_finish(&fb_mmc_stream.stream, cmd, response);
+}
+#endif
+
 /**
  * fastboot_mmc_flash_erase() - Erase eMMC for fastboot
  *
@@ -489,3 +590,21 @@ void fastboot_mmc_erase(const char *cmd, char *response)
 	       blks_size * info.blksz, cmd);
 	fastboot_okay(NULL, response);
 }
+
+/**
+ * fastboot_mmc_flush() - Make what was written safe from a reset
+ *
+ * @response: Pointer to fastboot response buffer, changed to a failure if
+ *	the eMMC write cache cannot be flushed after a successful command
+ */
+void fastboot_mmc_flush(char *response)
+{
+	struct mmc *mmc;
+
+	if (!CONFIG_IS_ENABLED(MMC_WRITE) || strncmp(response, "OKAY", 4))
+		return;
+
+	mmc = find_mmc_device(CONFIG_FASTBOOT_FLASH_MMC_DEV);
+	if (mmc && mmc_flush_cache(mmc))
+		fastboot_fail("failed flushing eMMC cache", response);
+}
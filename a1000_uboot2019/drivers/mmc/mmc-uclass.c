@@ -201,6 +201,15 @@ struct mmc *find_mmc_device(int dev_num)
 
 	mmc_dev = dev_get_parent(dev);
 
+	/* With DM_LAZY_PROBE nothing may have probed the device yet */
+	ret = device_probe(mmc_dev);
+	if (ret) {
+#if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
+		printf("MMC Device %d probe failed (err=%d)\n", dev_num, ret);
+#endif
+		return NULL;
+	}
+
 	struct mmc *mmc = mmc_get_mmc_dev(mmc_dev);
 
 	return mmc;
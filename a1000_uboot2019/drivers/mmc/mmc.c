@@ -11,6 +11,7 @@
 #include <command.h>
 #include <dm.h>
 #include <dm/device-internal.h>
+#include <dm/root.h>
 #include <errno.h>
 #include <mmc.h>
 #include <part.h>
@@ -252,6 +253,20 @@ int mmc_send_status(struct mmc *mmc, int timeout)
 	return 0;
 }
 
+int mmc_set_blockcount(struct mmc *mmc,
+		unsigned int blockcount, bool is_rel_write)
+{
+	struct mmc_cmd cmd = {0};
+
+	cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+	cmd.cmdarg = blockcount & 0x0000FFFF;
+	if (is_rel_write)
+		cmd.cmdarg |= 1 << 31;
+	cmd.resp_type = MMC_RSP_R1;
+
+	return mmc_send_cmd(mmc, &cmd, NULL);
+}
+
 int mmc_set_blocklen(struct mmc *mmc, int len)
 {
 	struct mmc_cmd cmd;
@@ -315,6 +330,19 @@ static const u8 tuning_blk_pattern_8bit[] = {
 	0xff, 0x77, 0x77, 0xff, 0x77, 0xbb, 0xdd, 0xee,
 };
 
+const u8 *mmc_get_tuning_block(uint bus_width, int *sizep)
+{
+	if (bus_width == 8) {
+		*sizep = sizeof(tuning_blk_pattern_8bit);
+		return tuning_blk_pattern_8bit;
+	} else if (bus_width == 4) {
+		*sizep = sizeof(tuning_blk_pattern_4bit);
+		return tuning_blk_pattern_4bit;
+	}
+
+	return NULL;
+}
+
 int mmc_send_tuning(struct mmc *mmc, u32 opcode, int *cmd_error)
 {
 	struct mmc_cmd cmd;
@@ -322,15 +350,9 @@ int mmc_send_tuning(struct mmc *mmc, u32 opcode, int *cmd_error)
 	const u8 *tuning_block_pattern;
 	int size, err;
 
-	if (mmc->bus_width == 8) {
-		tuning_block_pattern = tuning_blk_pattern_8bit;
-		size = sizeof(tuning_blk_pattern_8bit);
-	} else if (mmc->bus_width == 4) {
-		tuning_block_pattern = tuning_blk_pattern_4bit;
-		size = sizeof(tuning_blk_pattern_4bit);
-	} else {
+	tuning_block_pattern = mmc_get_tuning_block(mmc->bus_width, &size);
+	if (!tuning_block_pattern)
 		return -EINVAL;
-	}
 
 	ALLOC_CACHE_ALIGN_BUFFER(u8, data_buf, size);
 
@@ -352,6 +374,77 @@ int mmc_send_tuning(struct mmc *mmc, u32 opcode, int *cmd_error)
 
 	return 0;
 }
+
+int mmc_tuning_find_phase(const bool *passed, uint num_phases)
+{
+	uint start = 0, len = 0, best_start = 0, best_len = 0;
+	uint first_len, phase;
+
+	/* Length of the window which starts at phase 0, if any */
+	for (first_len = 0; first_len < num_phases; first_len++) {
+		if (!passed[first_len])
+			break;
+	}
+	if (first_len == num_phases)
+		return num_phases / 2;
+
+	for (phase = first_len; phase < num_phases; phase++) {
+		if (!passed[phase]) {
+			len = 0;
+			continue;
+		}
+		if (!len)
+			start = phase;
+		len++;
+
+		/* The phases wrap, so a window at the end joins the first */
+		if (phase == num_phases - 1)
+			len += first_len;
+		if (len > best_len) {
+			best_start = start;
+			best_len = len;
+		}
+	}
+	if (first_len > best_len) {
+		best_start = 0;
+		best_len = first_len;
+	}
+	if (!best_len)
+		return -EIO;
+
+	return (best_start + (best_len - 1) / 2) % num_phases;
+}
+
+int mmc_tuning_sweep(struct mmc *mmc, u32 opcode, uint num_phases,
+		     int (*set_phase)(struct mmc *mmc, uint phase))
+{
+	bool passed[MMC_TUNING_MAX_PHASES];
+	uint phase;
+	int ret;
+
+	if (!num_phases || num_phases > MMC_TUNING_MAX_PHASES)
+		return -EINVAL;
+
+	for (phase = 0; phase < num_phases; phase++) {
+		ret = set_phase(mmc, phase);
+		if (ret)
+			return ret;
+		passed[phase] = !mmc_send_tuning(mmc, opcode, NULL);
+	}
+
+	ret = mmc_tuning_find_phase(passed, num_phases);
+	if (ret < 0)
+		return ret;
+	debug("%s: tuned to phase %d of %u\n", mmc->cfg->name, ret,
+	      num_phases);
+
+	phase = ret;
+	ret = set_phase(mmc, phase);
+	if (ret)
+		return ret;
+
+	return phase;
+}
 #endif
 
 static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
@@ -2463,6 +2556,12 @@ static int mmc_startup(struct mmc *mmc)
 
 	mmc->best_mode = mmc->selected_mode;
 
+#if CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
+	/* The cache is flushed by mmc_flush_cache() before handing over */
+	if (mmc_cache_size(mmc) && mmc_cache_ctrl(mmc, true))
+		pr_warn("mmc: failed to enable the write cache\n");
+#endif
+
 	/* Fix the block length for DDR mode */
 	if (mmc->ddr_mode) {
 		mmc->read_bl_len = MMC_MAX_BLOCK_LEN;
@@ -2850,6 +2949,12 @@ static int mmc_probe(bd_t *bis)
 	if (ret)
 		return ret;
 
+	/* Each device is probed when its block device is first used */
+	if (dm_probe_deferred(UCLASS_MMC)) {
+		bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "mmc deferred");
+		return 0;
+	}
+
 	/*
 	 * Try to add them in sequence order. Really with driver model we
 	 * should allow holes, but the current MMC list does not allow that.
@@ -14,7 +14,8 @@
 #include <linux/math64.h>
 #include "mmc_private.h"
 
-static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt)
+static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt,
+			 u32 args)
 {
 	struct mmc_cmd cmd;
 	ulong end;
@@ -51,7 +52,7 @@ static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt)
 		goto err_out;
 
 	cmd.cmdidx = MMC_CMD_ERASE;
-	cmd.cmdarg = MMC_ERASE_ARG;
+	cmd.cmdarg = args;
 	cmd.resp_type = MMC_RSP_R1b;
 
 	err = mmc_send_cmd(mmc, &cmd, NULL);
@@ -112,7 +113,7 @@ ulong mmc_berase(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt)
 			blk_r = ((blkcnt - blk) > mmc->erase_grp_size) ?
 				mmc->erase_grp_size : (blkcnt - blk);
 		}
-		err = mmc_erase_t(mmc, start + blk, blk_r);
+		err = mmc_erase_t(mmc, start + blk, blk_r, MMC_ERASE_ARG);
 		if (err)
 			break;
 
@@ -126,12 +127,157 @@ ulong mmc_berase(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt)
 	return blk;
 }
 
+/* Blocks trimmed or discarded by a single command */
+#define MMC_TRIM_MAX_BLKS	(1 << 21)
+
+ulong mmc_trim(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
+	       uint arg)
+{
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+	lbaint_t blk = 0, blk_r;
+	int timeout = 3000;
+
+	if (!mmc || IS_SD(mmc) || !mmc->ext_csd)
+		return 0;
+	if (!(mmc->ext_csd[EXT_CSD_SEC_FEATURE_SUPPORT] & EXT_CSD_SEC_GB_CL_EN))
+		return 0;
+	if (arg == MMC_DISCARD_ARG && mmc->version < MMC_VERSION_4_5)
+		return 0;
+
+	if (blk_select_hwpart_devnum(IF_TYPE_MMC, block_dev->devnum,
+				     block_dev->hwpart) < 0)
+		return 0;
+
+	if (start + blkcnt > block_dev->lba) {
+		printf("MMC: block number 0x" LBAF " exceeds max(0x" LBAF ")\n",
+		       start + blkcnt, block_dev->lba);
+		return 0;
+	}
+
+	/* This does not go through blk_derase(), so drop the cached blocks */
+	blkcache_invalidate_range(block_dev->if_type, block_dev->devnum,
+				  block_dev->hwpart, start, blkcnt,
+				  block_dev->blksz);
+
+	while (blk < blkcnt) {
+		blk_r = min_t(lbaint_t, blkcnt - blk, MMC_TRIM_MAX_BLKS);
+		if (mmc_erase_t(mmc, start + blk, blk_r, arg))
+			break;
+
+		blk += blk_r;
+
+		/* Waiting for the ready status */
+		if (mmc_send_status(mmc, timeout))
+			return 0;
+	}
+
+	return blk;
+}
+
+/* Time allowed for the device to write its cache back to the flash */
+#define MMC_CACHE_FLUSH_TIMEOUT_MS	30000
+
+int mmc_cache_ctrl(struct mmc *mmc, bool enable)
+{
+	int err;
+
+	if (!mmc_cache_size(mmc))
+		return -EMEDIUMTYPE;
+	if (mmc_cache_enabled(mmc) == enable)
+		return 0;
+
+	if (!enable) {
+		err = mmc_flush_cache(mmc);
+		if (err)
+			return err;
+	}
+
+	err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_CACHE_CTRL,
+			 enable);
+	if (err)
+		return err;
+	mmc->ext_csd[EXT_CSD_CACHE_CTRL] = enable;
+
+	return 0;
+}
+
+int mmc_flush_cache(struct mmc *mmc)
+{
+	int err;
+
+	if (!mmc->has_init || !mmc_cache_enabled(mmc))
+		return 0;
+
+	err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_FLUSH_CACHE, 1);
+	/* A large cache can take much longer than a normal switch */
+	if (err == -ETIMEDOUT)
+		err = mmc_send_status(mmc, MMC_CACHE_FLUSH_TIMEOUT_MS);
+	if (err)
+		printf("mmc: cache flush failed (err=%d)\n", err);
+
+	return err;
+}
+
+int mmc_flush_all_caches(void)
+{
+	struct mmc *mmc;
+	int ret, err = 0;
+#if CONFIG_IS_ENABLED(DM_MMC)
+	struct udevice *dev;
+	struct uclass *uc;
+
+	ret = uclass_get(UCLASS_MMC, &uc);
+	if (ret)
+		return ret;
+
+	/* Do not probe anything here, only flush what is already in use */
+	uclass_foreach_dev(dev, uc) {
+		if (!device_active(dev))
+			continue;
+		mmc = mmc_get_mmc_dev(dev);
+		ret = mmc ? mmc_flush_cache(mmc) : 0;
+		if (ret && !err)
+			err = ret;
+	}
+#else
+	int i;
+
+	for (i = 0; i < get_mmc_num(); i++) {
+		mmc = find_mmc_device(i);
+		ret = mmc ? mmc_flush_cache(mmc) : 0;
+		if (ret && !err)
+			err = ret;
+	}
+#endif
+
+	return err;
+}
+
+/*
+ * Use a reliable write when the device implements the enhanced definition,
+ * which works for any block count. Boot partitions always get one, since a
+ * torn write there leaves the board unbootable.
+ */
+static bool mmc_use_reliable_write(struct mmc *mmc)
+{
+	uint hwpart = mmc_get_blk_desc(mmc)->hwpart;
+
+	if (!CONFIG_IS_ENABLED(MMC_RELIABLE_WRITE))
+		return false;
+	if (!(mmc->ext_csd[EXT_CSD_WR_REL_PARAM] & EXT_CSD_EN_REL_WR))
+		return false;
+
+	return mmc->reliable_write || hwpart == 1 || hwpart == 2;
+}
+
 static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 		lbaint_t blkcnt, const void *src)
 {
 	struct mmc_cmd cmd;
 	struct mmc_data data;
 	int timeout = 1000;
+	bool sbc = false;
+	bool rel_wr = false;
 
 	if ((start + blkcnt) > mmc_get_blk_desc(mmc)->lba) {
 		printf("MMC: block number 0x" LBAF " exceeds max(0x" LBAF ")\n",
@@ -139,13 +285,28 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 		return 0;
 	}
 
+	/*
+	 * On eMMC, announce the block count with CMD23 so that the device
+	 * knows the transfer length up front and no CMD12 is needed
+	 */
+	if (CONFIG_IS_ENABLED(MMC_CMD23) && !IS_SD(mmc) && mmc->ext_csd &&
+	    !mmc_host_is_spi(mmc) && blkcnt <= 0xffff) {
+		rel_wr = mmc_use_reliable_write(mmc);
+		sbc = blkcnt > 1 || rel_wr;
+	}
+
 	if (blkcnt == 0)
 		return 0;
-	else if (blkcnt == 1)
+	else if (blkcnt == 1 && !sbc)
 		cmd.cmdidx = MMC_CMD_WRITE_SINGLE_BLOCK;
 	else
 		cmd.cmdidx = MMC_CMD_WRITE_MULTIPLE_BLOCK;
 
+	if (sbc && mmc_set_blockcount(mmc, blkcnt, rel_wr)) {
+		printf("mmc fail to set block count\n");
+		return 0;
+	}
+
 	if (mmc->high_capacity)
 		cmd.cmdarg = start;
 	else
@@ -166,7 +327,7 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 	/* SPI multiblock writes terminate using a special
 	 * token, not a STOP_TRANSMISSION request.
 	 */
-	if (!mmc_host_is_spi(mmc) && blkcnt > 1) {
+	if (!mmc_host_is_spi(mmc) && blkcnt > 1 && !sbc) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -16,6 +16,17 @@ struct sandbox_mmc_plat {
 	struct mmc mmc;
 };
 
+/**
+ * struct sandbox_mmc_priv - Emulated controller state
+ *
+ * @tuning_errors: Sampling phases at which tuning blocks get a CRC error
+ * @tuning_phase: Current sampling phase
+ */
+struct sandbox_mmc_priv {
+	u32 tuning_errors;
+	uint tuning_phase;
+};
+
 /**
  * sandbox_mmc_send_cmd() - Emulate SD commands
  *
@@ -60,6 +71,23 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	case MMC_CMD_READ_MULTIPLE_BLOCK:
 		strcpy(data->dest, "this is a test");
 		break;
+#ifdef MMC_SUPPORTS_TUNING
+	case MMC_CMD_SEND_TUNING_BLOCK:
+	case MMC_CMD_SEND_TUNING_BLOCK_HS200: {
+		struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+		struct mmc *mmc = mmc_get_mmc_dev(dev);
+		const u8 *block;
+		int size;
+
+		if (priv->tuning_errors & BIT(priv->tuning_phase))
+			return -EILSEQ;
+		block = mmc_get_tuning_block(mmc->bus_width, &size);
+		if (!block || size != data->blocksize)
+			return -EINVAL;
+		memcpy(data->dest, block, size);
+		break;
+	}
+#endif
 	case MMC_CMD_STOP_TRANSMISSION:
 		break;
 	case SD_CMD_APP_SEND_OP_COND:
@@ -96,10 +124,49 @@ static int sandbox_mmc_get_cd(struct udevice *dev)
 	return 1;
 }
 
+#ifdef MMC_SUPPORTS_TUNING
+static int sandbox_mmc_set_tuning_phase(struct mmc *mmc, uint phase)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(mmc->dev);
+
+	priv->tuning_phase = phase;
+
+	return 0;
+}
+
+static int sandbox_mmc_execute_tuning(struct udevice *dev, uint opcode)
+{
+	int ret;
+
+	ret = mmc_tuning_sweep(mmc_get_mmc_dev(dev), opcode,
+			       SANDBOX_MMC_TUNING_PHASES,
+			       sandbox_mmc_set_tuning_phase);
+
+	return ret < 0 ? ret : 0;
+}
+#endif
+
+void sandbox_mmc_set_tuning_errors(struct udevice *dev, u32 phase_mask)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	priv->tuning_errors = phase_mask;
+}
+
+uint sandbox_mmc_get_tuning_phase(struct udevice *dev)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	return priv->tuning_phase;
+}
+
 static const struct dm_mmc_ops sandbox_mmc_ops = {
 	.send_cmd = sandbox_mmc_send_cmd,
 	.set_ios = sandbox_mmc_set_ios,
 	.get_cd = sandbox_mmc_get_cd,
+#ifdef MMC_SUPPORTS_TUNING
+	.execute_tuning = sandbox_mmc_execute_tuning,
+#endif
 };
 
 int sandbox_mmc_probe(struct udevice *dev)
@@ -144,5 +211,6 @@ U_BOOT_DRIVER(mmc_sandbox) = {
 	.bind		= sandbox_mmc_bind,
 	.unbind		= sandbox_mmc_unbind,
 	.probe		= sandbox_mmc_probe,
+	.priv_auto_alloc_size = sizeof(struct sandbox_mmc_priv),
 	.platdata_auto_alloc_size = sizeof(struct sandbox_mmc_plat),
 };
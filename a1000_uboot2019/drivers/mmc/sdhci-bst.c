@@ -10,6 +10,7 @@
 
 #include <common.h>
 #include <dm.h>
+#include <dt-structs.h>
 #include <iotrace.h>
 #include <linux/bitfield.h>
 #include <linux/io.h>
@@ -46,7 +47,19 @@
 #define BURST_INCR4_EN  BIT(1)
 #define BURST_EN (BURST_INCR16_EN|BURST_INCR8_EN|BURST_INCR4_EN)
 
+#define EMMC_CTRL_CARD_IS_EMMC		BIT(0)
+#define AT_CTRL_SW_TUNE_EN		BIT(4)
+#define AT_STAT_CENTER_PH_CODE_MASK	GENMASK(7, 0)
+/* HOST_CTRL2_R.UHS_MODE_SEL value for HS400, not the one in sdhci.h */
+#define DWCMSHC_CTRL_HS400		0x7
+
+/* Number of sampling phases the tuning sweep tries */
+#define BST_SDHCI_TUNING_PHASES		128
+
 struct bst_sdhci_plat {
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	struct dtd_bst_sdhci dtplat;
+#endif
 	struct mmc_config cfg;
 	struct mmc mmc;
 	unsigned int f_max;
@@ -58,6 +71,7 @@ struct bst_sdhci_priv {
 	struct sdhci_host *host;
 	struct reset_ctl_bulk	resets;
 	u8 no_1p8;
+	int tuning_phase;	/* Sampling phase from tuning, -1 if none */
 };
 
 void bst_card_clk_enable(struct sdhci_host *host, u32 enable)
@@ -128,20 +142,110 @@ static void bst_set_clock(struct sdhci_host *host, u32 div)
 	bst_mmc_clock_freq_change(host, div);
 }
 
+#if defined(CONFIG_DM_MMC) && defined(MMC_SUPPORTS_TUNING)
+static bool bst_sdhci_is_tuned_mode(struct mmc *mmc)
+{
+	return mmc->selected_mode == MMC_HS_200 ||
+	       mmc->selected_mode == MMC_HS_400;
+}
+
+static int bst_sdhci_set_tuning_phase(struct mmc *mmc, uint phase)
+{
+	struct sdhci_host *host = mmc->priv;
+	u32 stat;
+
+	/* Stop the card clock while the sampling point moves */
+	bst_card_clk_enable(host, 0);
+	stat = sdhci_readl(host, SDHC_AT_STAT_R);
+	stat &= ~AT_STAT_CENTER_PH_CODE_MASK;
+	stat |= phase & AT_STAT_CENTER_PH_CODE_MASK;
+	sdhci_writel(host, stat, SDHC_AT_STAT_R);
+	bst_card_clk_enable(host, 1);
+
+	sdhci_writew(host,
+		sdhci_readw(host, SDHCI_HOST_CONTROL2)|SDHCI_CTRL_TUNED_CLK,
+		SDHCI_HOST_CONTROL2);
+
+	return 0;
+}
+
+static int bst_sdhci_execute_tuning(struct mmc *mmc, u8 opcode)
+{
+	struct bst_sdhci_priv *priv = dev_get_priv(mmc->dev);
+	struct sdhci_host *host = mmc->priv;
+	int phase;
+
+	/* Let software choose the phase rather than the auto-tuning engine */
+	sdhci_writel(host,
+		sdhci_readl(host, SDHC_AT_CTRL_R)|AT_CTRL_SW_TUNE_EN,
+		SDHC_AT_CTRL_R);
+
+	phase = mmc_tuning_sweep(mmc, opcode, BST_SDHCI_TUNING_PHASES,
+				 bst_sdhci_set_tuning_phase);
+	if (phase < 0) {
+		priv->tuning_phase = -1;
+		sdhci_writew(host,
+			sdhci_readw(host, SDHCI_HOST_CONTROL2)&
+				(~SDHCI_CTRL_TUNED_CLK),
+			SDHCI_HOST_CONTROL2);
+		dev_err(mmc->dev, "Tuning failed: %d\n", phase);
+		return phase;
+	}
+	priv->tuning_phase = phase;
+
+	return 0;
+}
+
+/* Platform specific function for post set_ios configuration */
+static void bst_sdhci_set_ios_post(struct sdhci_host *host)
+{
+	struct bst_sdhci_priv *priv = dev_get_priv(host->mmc->dev);
+
+	/*
+	 * set_control_reg() and a clock change drop the tuned sampling
+	 * clock, so select it again in the modes which were tuned
+	 */
+	if (priv->tuning_phase >= 0 && bst_sdhci_is_tuned_mode(host->mmc))
+		bst_sdhci_set_tuning_phase(host->mmc, priv->tuning_phase);
+}
+#else
 /* Platform specific function for post set_ios configuration */
 static void bst_sdhci_set_ios_post(struct sdhci_host *host)
 {
 
 }
+#endif
+
+static u16 bst_sdhci_uhs_mode(struct sdhci_host *host)
+{
+	switch (host->mmc->selected_mode) {
+	case MMC_HS_200:
+		return SDHCI_CTRL_UHS_SDR104;
+	case MMC_HS_400:
+		return DWCMSHC_CTRL_HS400;
+	default:
+		return SDHCI_CTRL_UHS_SDR25;
+	}
+}
 
 static void bst_sdhci_set_control_reg(struct sdhci_host *host)
 {
+	u16 emmc_ctrl;
+
 	sdhci_writew(host, sdhci_readw(host,
 			SDHCI_HOST_CONTROL)|SDHCI_CTRL_HISPD,
 			SDHCI_HOST_CONTROL);
-	if (host->ioaddr == MMC0_BASE)
-		sdhci_writew(host, SDHCI_CTRL_VDD_180|SDHCI_CTRL_UHS_SDR25,
+	if (host->ioaddr == MMC0_BASE) {
+		/* HS400 samples data on the card's data strobe */
+		if (host->mmc->selected_mode == MMC_HS_400) {
+			emmc_ctrl = sdhci_readw(host, SDHC_EMMC_CTRL_R);
+			sdhci_writew(host, emmc_ctrl|EMMC_CTRL_CARD_IS_EMMC,
+				     SDHC_EMMC_CTRL_R);
+		}
+
+		sdhci_writew(host, SDHCI_CTRL_VDD_180|bst_sdhci_uhs_mode(host),
 				SDHCI_HOST_CONTROL2);
+	}
 	sdhci_writew(host,
 			(sdhci_readw(host, MBIU_CTRL)&(~0xf))|BURST_EN,
 			MBIU_CTRL);
@@ -152,7 +256,20 @@ static int bst_sdhci_reset(struct udevice *dev)
 	struct bst_sdhci_priv *priv = dev_get_priv(dev);
 	int ret;
 
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	struct bst_sdhci_plat *plat = dev_get_platdata(dev);
+
+	priv->resets.resets = devm_kcalloc(dev, 1, sizeof(struct reset_ctl),
+					   GFP_KERNEL);
+	if (!priv->resets.resets)
+		return -ENOMEM;
+	ret = reset_get_by_index_platdata(dev, 0, plat->dtplat.resets,
+					  &priv->resets.resets[0]);
+	if (!ret)
+		priv->resets.count = 1;
+#else
 	ret = reset_get_bulk(dev, &priv->resets);
+#endif
 	if (ret) {
 		/*
 		 * Return 0 if error due to !CONFIG_DM_RESET and reset
@@ -181,6 +298,9 @@ static const struct sdhci_ops bst_sdhci_ops = {
 	.set_clock = &bst_set_clock,
 	.set_ios_post = &bst_sdhci_set_ios_post,
 	.set_control_reg = &bst_sdhci_set_control_reg,
+#if defined(CONFIG_DM_MMC) && defined(MMC_SUPPORTS_TUNING)
+	.platform_execute_tuning = &bst_sdhci_execute_tuning,
+#endif
 };
 
 #ifdef CONFIG_BLK
@@ -198,6 +318,47 @@ static int sdhci_bst_bind(struct udevice *dev)
 #endif
 
 #if CONFIG_IS_ENABLED(DM_MMC)
+#if !CONFIG_IS_ENABLED(OF_PLATDATA)
+/* eMMC bus modes from slowest to fastest, as named by "bst,max-mode" */
+static const struct {
+	const char *name;
+	enum bus_mode mode;
+} bst_sdhci_modes[] = {
+	{ "hs", MMC_HS_52 },
+	{ "ddr52", MMC_DDR_52 },
+	{ "hs200", MMC_HS_200 },
+	{ "hs400", MMC_HS_400 },
+};
+
+/*
+ * Drop the eMMC modes faster than the optional "bst,max-mode" property,
+ * for boards whose traces cannot carry the fastest ones
+ */
+static int bst_sdhci_limit_mode(struct udevice *dev, struct mmc_config *cfg)
+{
+	const char *max_mode;
+	int i;
+
+	max_mode = dev_read_string(dev, "bst,max-mode");
+	if (!max_mode)
+		return 0;
+
+	for (i = 0; i < ARRAY_SIZE(bst_sdhci_modes); i++) {
+		if (!strcmp(max_mode, bst_sdhci_modes[i].name))
+			break;
+	}
+	if (i == ARRAY_SIZE(bst_sdhci_modes)) {
+		dev_err(dev, "Invalid \"bst,max-mode\" value %s\n", max_mode);
+		return -EINVAL;
+	}
+
+	for (i++; i < ARRAY_SIZE(bst_sdhci_modes); i++)
+		cfg->host_caps &= ~MMC_CAP(bst_sdhci_modes[i].mode);
+
+	return 0;
+}
+#endif
+
 static int bst_sdhci_probe(struct udevice *dev)
 {
 	//    DECLARE_GLOBAL_DATA_PTR;
@@ -234,6 +395,8 @@ static int bst_sdhci_probe(struct udevice *dev)
 
 	host->max_clk = plat->f_max;
 	host->quirks = SDHCI_QUIRK_WAIT_SEND_CMD|SDHCI_QUIRK_32BIT_DMA_ADDR;
+	/* DWC MSHC: ADMA2 descriptors must not cross a 128M boundary */
+	host->quirks |= SDHCI_QUIRK_ADMA_128M_BOUNDARY;
 	if (priv->no_1p8)
 		host->quirks |= SDHCI_QUIRK_NO_1_8_V;
 	/* do not switch voltage */
@@ -246,17 +409,53 @@ static int bst_sdhci_probe(struct udevice *dev)
 	if (host->ioaddr == MMC1_BASE)
 		host->host_caps |= SDHCI_CAN_VDD_330|SDHCI_CAN_VDD_300;
 
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	/* The subset of mmc_of_parse() which this board's tree uses */
+	switch (host->bus_width) {
+	case 8:
+		plat->cfg.host_caps |= MMC_MODE_8BIT;
+		/* fall through */
+	case 4:
+		plat->cfg.host_caps |= MMC_MODE_4BIT;
+		/* fall through */
+	default:
+		plat->cfg.host_caps |= MMC_MODE_1BIT;
+		break;
+	}
+	plat->cfg.f_max = plat->f_max;
+	if (plat->dtplat.cap_sd_highspeed)
+		plat->cfg.host_caps |= MMC_CAP(SD_HS);
+	if (plat->dtplat.cap_mmc_highspeed)
+		plat->cfg.host_caps |= MMC_CAP(MMC_HS);
+#else
 	ret = mmc_of_parse(dev, &plat->cfg);
 	if (ret) {
 		debug("mmc_of_parse\n");
 		return ret;
 	}
+#endif
 
 	ret = sdhci_setup_cfg(&plat->cfg, host, plat->f_max, plat->f_min);
 	if (ret) {
 		debug("sdhci_setup_cfg\n");
 		return ret;
 	}
+
+#if CONFIG_IS_ENABLED(MMC_HS200_SUPPORT)
+	/* eMMC0 has its IO at 1.8V, as HS200 and HS400 need */
+	if (host->ioaddr == MMC0_BASE) {
+		plat->cfg.host_caps |= MMC_CAP(MMC_HS_200);
+		if (CONFIG_IS_ENABLED(MMC_HS400_SUPPORT) &&
+		    host->bus_width == 8)
+			plat->cfg.host_caps |= MMC_CAP(MMC_HS_400);
+	}
+#endif
+#if !CONFIG_IS_ENABLED(OF_PLATDATA)
+	ret = bst_sdhci_limit_mode(dev, &plat->cfg);
+	if (ret)
+		return ret;
+#endif
+	priv->tuning_phase = -1;
 	host->mmc = &plat->mmc;
 	host->mmc->priv = host;
 	host->mmc->dev = dev;
@@ -276,6 +475,14 @@ static int bst_sdhci_ofdata_to_platdata(struct udevice *dev)
 
 	priv->host->name = dev->name;
 	priv->host->ops = &bst_sdhci_ops;
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	priv->host->ioaddr = (void *)(uintptr_t)plat->dtplat.reg[0];
+	priv->host->bus_width = plat->dtplat.bus_width ?: 4;
+	priv->no_1p8 = plat->dtplat.no_1_8_v;
+
+	plat->f_max = plat->dtplat.max_frequency;
+	plat->f_min = plat->dtplat.min_frequency;
+#else
 	priv->host->ioaddr = (void *)dev_read_addr(dev);
 	if (IS_ERR(priv->host->ioaddr))
 		return PTR_ERR(priv->host->ioaddr);
@@ -284,16 +491,22 @@ static int bst_sdhci_ofdata_to_platdata(struct udevice *dev)
 
 	plat->f_max = dev_read_u32_default(dev, "max-frequency", 0);
 	plat->f_min = dev_read_u32_default(dev, "min-frequency", 0);
+#endif
 
 	return 0;
 }
 
 static const struct udevice_id bst_sdhci_match[] = {
 	{ .compatible = "bst,sdhci" },
+	{ }
 };
 
 U_BOOT_DRIVER(sdhci_bst) = {
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	.name = "bst_sdhci",
+#else
 	.name = "sdhci-bst",
+#endif
 	.id = UCLASS_MMC,
 	.of_match = bst_sdhci_match,
 	.ops = &sdhci_ops,
@@ -333,7 +546,7 @@ int bst_sdhci_init(u32 base, u32 min_clk, u32 quirks)
 	void *reg_base;
 	struct sdhci_host *host = NULL;
 
-	host = (struct sdhci_host *)malloc(sizeof(struct sdhci_host));
+	host = (struct sdhci_host *)calloc(1, sizeof(struct sdhci_host));
 	if (!host) {
 		printf("%s: sdhci host malloc fail!\n", __func__);
 		return -ENOMEM;
@@ -352,7 +565,7 @@ int bst_sdhci_init(u32 base, u32 min_clk, u32 quirks)
 		host->host_caps |= MMC_MODE_HS | MMC_MODE_4BIT;
 	}
 	host->ioaddr = reg_base;
-	host->quirks = quirks;
+	host->quirks = quirks | SDHCI_QUIRK_ADMA_128M_BOUNDARY;
 	host->max_clk = max_clk;
 	host->ops = &bst_sdhci_ops;
 
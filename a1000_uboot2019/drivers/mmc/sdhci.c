@@ -65,6 +65,9 @@ void sdhci_dumpregs(struct sdhci_host *host)
 		sdhci_readl(host, SDHCI_RESPONSE + 12));
 	printf("Host ctl2: 0x%08x\n",
 		sdhci_readw(host, SDHCI_HOST_CONTROL2));
+	printf("ADMA Err:  0x%08x | ADMA Ptr: 0x%08x\n",
+		sdhci_readl(host, SDHCI_ADMA_ERROR),
+		sdhci_readl(host, SDHCI_ADMA_ADDRESS));
 
 	printf("============================================\n");
 }
@@ -120,19 +123,134 @@ static void sdhci_transfer_pio(struct sdhci_host *host, struct mmc_data *data)
 	}
 }
 
-static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data,
-				unsigned int start_addr)
+#if defined(CONFIG_MMC_SDHCI_ADMA) && !defined(CONFIG_SPL_BUILD)
+static void sdhci_adma_desc(struct sdhci_host *host, dma_addr_t dma_addr,
+			    u16 len, bool end)
+{
+	struct sdhci_adma_desc *desc;
+	u8 attr;
+
+	desc = &host->adma_desc_table[host->desc_slot++];
+
+	attr = ADMA_DESC_ATTR_VALID | ADMA_DESC_TRANSFER_DATA;
+	if (end)
+		attr |= ADMA_DESC_ATTR_END;
+
+	desc->attr = attr;
+	desc->len = len;
+	desc->reserved = 0;
+	desc->addr_lo = lower_32_bits(dma_addr);
+#ifdef CONFIG_DMA_ADDR_T_64BIT
+	desc->addr_hi = upper_32_bits(dma_addr);
+#endif
+}
+
+/*
+ * Describe the whole transfer with one descriptor chain, so the engine
+ * runs from the first to the last block without CPU intervention.
+ */
+static void sdhci_prepare_adma_table(struct sdhci_host *host,
+				     struct mmc_data *data,
+				     dma_addr_t dma_addr)
+{
+	uint trans_bytes = data->blocksize * data->blocks;
+	uint len;
+
+	host->desc_slot = 0;
+
+	while (trans_bytes) {
+		len = min_t(uint, trans_bytes, ADMA_MAX_LEN);
+		if (host->quirks & SDHCI_QUIRK_ADMA_128M_BOUNDARY)
+			len = min_t(uint, len, ADMA_BOUNDARY_SIZE -
+				    (dma_addr & (ADMA_BOUNDARY_SIZE - 1)));
+		trans_bytes -= len;
+		sdhci_adma_desc(host, dma_addr, len, !trans_bytes);
+		dma_addr += len;
+	}
+
+	flush_cache((ulong)host->adma_desc_table,
+		    ALIGN(host->desc_slot * sizeof(struct sdhci_adma_desc),
+			  ARCH_DMA_MINALIGN));
+}
+#endif
+
+#if (defined(CONFIG_MMC_SDHCI_SDMA) || defined(CONFIG_MMC_SDHCI_ADMA)) && \
+	!defined(CONFIG_SPL_BUILD)
+/*
+ * Select the DMA engine for this transfer and program its address.
+ * Returns 0 if the data will be moved by DMA, -EINVAL if it must be
+ * moved by PIO.
+ */
+static int sdhci_prepare_dma(struct sdhci_host *host, struct mmc_data *data,
+			     dma_addr_t *start_addr, int *is_aligned,
+			     int trans_bytes)
 {
-	unsigned int stat, rdy, mask, timeout, block = 0;
-	bool transfer_done = false;
-#if defined(CONFIG_MMC_SDHCI_SDMA) && !defined(CONFIG_SPL_BUILD)
 	unsigned char ctrl;
 
+	if (data->flags == MMC_DATA_READ)
+		*start_addr = (unsigned long)data->dest;
+	else
+		*start_addr = (unsigned long)data->src;
+
 	ctrl = sdhci_readb(host, SDHCI_HOST_CONTROL);
 	ctrl &= ~SDHCI_CTRL_DMA_MASK;
+
+#if defined(CONFIG_MMC_SDHCI_ADMA)
+	if ((host->flags & (USE_ADMA | USE_ADMA64)) &&
+	    IS_ALIGNED(*start_addr, ADMA_DATA_ALIGN)) {
+		dma_addr_t desc_addr = (unsigned long)host->adma_desc_table;
+
+		sdhci_prepare_adma_table(host, data, *start_addr);
+		sdhci_writel(host, lower_32_bits(desc_addr),
+			     SDHCI_ADMA_ADDRESS);
+		if (host->flags & USE_ADMA64) {
+			sdhci_writel(host, upper_32_bits(desc_addr),
+				     SDHCI_ADMA_ADDRESS_HI);
+			ctrl |= SDHCI_CTRL_ADMA64;
+		} else {
+			ctrl |= SDHCI_CTRL_ADMA32;
+		}
+		sdhci_writeb(host, ctrl, SDHCI_HOST_CONTROL);
+		return 0;
+	}
+#endif
+
 	sdhci_writeb(host, ctrl, SDHCI_HOST_CONTROL);
+	if (!(host->flags & USE_SDMA))
+		return -EINVAL;
+
+	#if 0 //memory align is nesserery?
+	if ((host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR) &&
+			(*start_addr & 0x7) != 0x0) {
+		*is_aligned = 0;
+		*start_addr = (unsigned long)aligned_buffer;
+		if (data->flags != MMC_DATA_READ)
+			memcpy(aligned_buffer, data->src, trans_bytes);
+	}
+	#endif
+
+#if defined(CONFIG_FIXED_SDHCI_ALIGNED_BUFFER)
+	/*
+	 * Always use this bounce-buffer when
+	 * CONFIG_FIXED_SDHCI_ALIGNED_BUFFER is defined
+	 */
+	*is_aligned = 0;
+	*start_addr = (unsigned long)aligned_buffer;
+	if (data->flags != MMC_DATA_READ)
+		memcpy(aligned_buffer, data->src, trans_bytes);
+#endif
+
+	sdhci_writel(host, *start_addr, SDHCI_DMA_ADDRESS);
+	return 0;
+}
 #endif
 
+static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data,
+				dma_addr_t start_addr)
+{
+	unsigned int stat, rdy, mask, timeout, block = 0;
+	bool transfer_done = false;
+
 	timeout = 1000000;
 	rdy = SDHCI_INT_SPACE_AVAIL | SDHCI_INT_DATA_AVAIL;
 	mask = SDHCI_DATA_AVAILABLE | SDHCI_SPACE_AVAILABLE;
@@ -141,6 +259,11 @@ static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data,
 		if (stat & SDHCI_INT_ERROR) {
 			pr_debug("%s: Error detected in status(0x%X)!\n",
 				 __func__, stat);
+			if (stat & SDHCI_INT_ADMA_ERROR)
+				pr_debug("%s: ADMA error 0x%x at 0x%x\n",
+					 __func__,
+					 sdhci_readl(host, SDHCI_ADMA_ERROR),
+					 sdhci_readl(host, SDHCI_ADMA_ADDRESS));
 			return -EIO;
 		}
 		if (!transfer_done && (stat & rdy)) {
@@ -202,8 +325,10 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	unsigned int stat = 0;
 	int ret = 0;
 	int trans_bytes = 0, is_aligned = 1;
+	bool dma = false;
 	u32 mask, flags, mode;
-	unsigned int time = 0, start_addr = 0;
+	unsigned int time = 0;
+	dma_addr_t start_addr = 0;
 	int mmc_dev = mmc_get_blk_desc(mmc)->devnum;
 	ulong start = get_timer(0);
 
@@ -273,35 +398,13 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 		if (data->flags == MMC_DATA_READ)
 			mode |= SDHCI_TRNS_READ;
 
-#if defined(CONFIG_MMC_SDHCI_SDMA) && !defined(CONFIG_SPL_BUILD)
-		if (data->flags == MMC_DATA_READ)
-			start_addr = (unsigned long)data->dest;
-		else
-			start_addr = (unsigned long)data->src;
-
-		#if 0 //memory align is nesserery?
-		if ((host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR) &&
-				(start_addr & 0x7) != 0x0) {
-			is_aligned = 0;
-			start_addr = (unsigned long)aligned_buffer;
-			if (data->flags != MMC_DATA_READ)
-				memcpy(aligned_buffer, data->src, trans_bytes);
+#if (defined(CONFIG_MMC_SDHCI_SDMA) || defined(CONFIG_MMC_SDHCI_ADMA)) && \
+	!defined(CONFIG_SPL_BUILD)
+		if (!sdhci_prepare_dma(host, data, &start_addr, &is_aligned,
+				       trans_bytes)) {
+			dma = true;
+			mode |= SDHCI_TRNS_DMA;
 		}
-		#endif
-
-#if defined(CONFIG_FIXED_SDHCI_ALIGNED_BUFFER)
-		/*
-		 * Always use this bounce-buffer when
-		 * CONFIG_FIXED_SDHCI_ALIGNED_BUFFER is defined
-		 */
-		is_aligned = 0;
-		start_addr = (unsigned long)aligned_buffer;
-		if (data->flags != MMC_DATA_READ)
-			memcpy(aligned_buffer, data->src, trans_bytes);
-#endif
-
-		sdhci_writel(host, start_addr, SDHCI_DMA_ADDRESS);
-		mode |= SDHCI_TRNS_DMA;
 #endif
 		sdhci_writew(host, SDHCI_MAKE_BLKSZ(SDHCI_DEFAULT_BOUNDARY_ARG,
 				data->blocksize),
@@ -313,12 +416,10 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	}
 
 	sdhci_writel(host, cmd->cmdarg, SDHCI_ARGUMENT);
-#if defined(CONFIG_MMC_SDHCI_SDMA) && !defined(CONFIG_SPL_BUILD)
-	if (data) {
+	if (dma) {
 		trans_bytes = ALIGN(trans_bytes, CONFIG_SYS_CACHELINE_SIZE);
 		flush_cache(start_addr, trans_bytes);
 	}
-#endif
 	sdhci_writew(host, SDHCI_MAKE_CMD(cmd->cmdidx, flags), SDHCI_COMMAND);
 	start = get_timer(0);
 	do {
@@ -352,6 +453,14 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	stat = sdhci_readl(host, SDHCI_INT_STATUS);
 	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
 	if (!ret) {
+		/*
+		 * Drop lines the CPU may have speculatively fetched while
+		 * the engine was writing; only whole lines can be dropped.
+		 */
+		if (dma && data->flags == MMC_DATA_READ &&
+		    IS_ALIGNED(start_addr, CONFIG_SYS_CACHELINE_SIZE))
+			invalidate_dcache_range(start_addr,
+						start_addr + trans_bytes);
 		if ((host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR) &&
 				!is_aligned && (data->flags == MMC_DATA_READ))
 			memcpy(data->dest, aligned_buffer, trans_bytes);
@@ -581,6 +690,19 @@ static int sdhci_init(struct mmc *mmc)
 		}
 	}
 
+#if defined(CONFIG_MMC_SDHCI_ADMA) && !defined(CONFIG_SPL_BUILD)
+	if ((host->flags & (USE_ADMA | USE_ADMA64)) &&
+	    !host->adma_desc_table) {
+		host->adma_desc_table = memalign(ARCH_DMA_MINALIGN,
+						 ADMA_TABLE_SZ);
+		if (!host->adma_desc_table) {
+			printf("%s: ADMA table alloc failed, ADMA disabled\n",
+			       __func__);
+			host->flags &= ~(USE_ADMA | USE_ADMA64);
+		}
+	}
+#endif
+
 	sdhci_set_power(host, fls(mmc->cfg->voltages) - 1);
 
 	if (host->ops && host->ops->get_cd)
@@ -631,6 +753,18 @@ int sdhci_setup_cfg(struct mmc_config *cfg, struct sdhci_host *host,
 		       __func__);
 		return -EINVAL;
 	}
+	host->flags |= USE_SDMA;
+#endif
+#if defined(CONFIG_MMC_SDHCI_ADMA) && !defined(CONFIG_SPL_BUILD)
+	/* The descriptor layout is fixed at build time by dma_addr_t */
+	if (caps & SDHCI_CAN_DO_ADMA2) {
+#ifdef CONFIG_DMA_ADDR_T_64BIT
+		if (caps & SDHCI_CAN_64BIT)
+			host->flags |= USE_ADMA64;
+#else
+		host->flags |= USE_ADMA;
+#endif
+	}
 #endif
 	if (host->quirks & SDHCI_QUIRK_REG32_RW)
 		host->version =
@@ -14,18 +14,36 @@ DECLARE_GLOBAL_DATA_PTR;
 
 int spi_flash_read_dm(struct udevice *dev, u32 offset, size_t len, void *buf)
 {
-	return log_ret(sf_get_ops(dev)->read(dev, offset, len, buf));
+	int ret;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SPI, "sf");
+	ret = sf_get_ops(dev)->read(dev, offset, len, buf);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SPI);
+
+	return log_ret(ret);
 }
 
 int spi_flash_write_dm(struct udevice *dev, u32 offset, size_t len,
 		       const void *buf)
 {
-	return log_ret(sf_get_ops(dev)->write(dev, offset, len, buf));
+	int ret;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SPI, "sf");
+	ret = sf_get_ops(dev)->write(dev, offset, len, buf);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SPI);
+
+	return log_ret(ret);
 }
 
 int spi_flash_erase_dm(struct udevice *dev, u32 offset, size_t len)
 {
-	return log_ret(sf_get_ops(dev)->erase(dev, offset, len));
+	int ret;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SPI, "sf");
+	ret = sf_get_ops(dev)->erase(dev, offset, len);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SPI);
+
+	return log_ret(ret);
 }
 
 int spl_flash_get_sw_write_prot(struct udevice *dev)
@@ -92,6 +92,39 @@ void spi_flash_free(struct spi_flash *flash)
 
 #else /* defined CONFIG_DM_SPI_FLASH */
 
+#ifdef CONFIG_SPI_FLASH_DIRMAP
+__weak int spi_flash_dirmap_read(struct spi_flash *flash, u32 offset,
+				 size_t len, void *buf)
+{
+	return -ENOTSUPP;
+}
+
+static int spi_flash_std_read(struct udevice *dev, u32 offset, size_t len,
+			      void *buf)
+{
+	struct spi_flash *flash = dev_get_uclass_priv(dev);
+	struct mtd_info *mtd = &flash->mtd;
+	enum spi_nor_read_path path = SPI_NOR_READ_FIFO;
+	ulong start = timer_get_us();
+	size_t retlen;
+	int ret = -ENOTSUPP;
+
+	if (!flash->dirmap_disabled) {
+		ret = spi_flash_dirmap_read(flash, offset, len, buf);
+		path = SPI_NOR_READ_DIRMAP;
+	}
+	if (ret == -ENOTSUPP) {
+		ret = mtd->_read(mtd, offset, len, &retlen, buf);
+		path = SPI_NOR_READ_FIFO;
+	}
+	if (!ret) {
+		flash->read_stats[path].bytes += len;
+		flash->read_stats[path].us += timer_get_us() - start;
+	}
+
+	return log_ret(ret);
+}
+#else
 static int spi_flash_std_read(struct udevice *dev, u32 offset, size_t len,
 			      void *buf)
 {
@@ -101,6 +134,7 @@ static int spi_flash_std_read(struct udevice *dev, u32 offset, size_t len,
 
 	return log_ret(mtd->_read(mtd, offset, len, &retlen, buf));
 }
+#endif
 
 static int spi_flash_std_write(struct udevice *dev, u32 offset, size_t len,
 			       const void *buf)
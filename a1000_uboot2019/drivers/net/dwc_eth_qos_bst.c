@@ -79,6 +79,7 @@ struct eqos_mac_regs {
 #define EQOS_MAC_CONFIGURATION_PS			BIT(15)
 #define EQOS_MAC_CONFIGURATION_FES			BIT(14)
 #define EQOS_MAC_CONFIGURATION_DM			BIT(13)
+#define EQOS_MAC_CONFIGURATION_LM			BIT(12)
 #define EQOS_MAC_CONFIGURATION_TE			BIT(1)
 #define EQOS_MAC_CONFIGURATION_RE			BIT(0)
 
@@ -195,6 +196,8 @@ struct eqos_dma_regs {
 #define EQOS_DMA_SYSBUS_MODE_BLEN4			BIT(1)
 #define EQOS_DMA_SYSBUS_MODE_FB				BIT(0)
 
+#define EQOS_DMA_CH0_CONTROL_DSL_SHIFT			18
+#define EQOS_DMA_CH0_CONTROL_DSL_MASK			7
 #define EQOS_DMA_CH0_CONTROL_PBLX8			BIT(16)
 
 #define EQOS_DMA_CH0_TX_CONTROL_TXPBL_SHIFT		16
@@ -227,39 +230,38 @@ struct eqos_regs {
 /* Descriptors */
 
 #define EQOS_DESCRIPTOR_WORDS	4
-#define EQOS_DESCRIPTOR_SIZE	(EQOS_DESCRIPTOR_WORDS * 4)
 /* We assume ARCH_DMA_MINALIGN >= 16; 16 is the EQOS HW minimum */
 #define EQOS_DESCRIPTOR_ALIGN	ARCH_DMA_MINALIGN
-#define EQOS_DESCRIPTORS_TX	4
+// * Each descriptor occupies a whole cache line; the DMA skips the padding
+// * (see EQOS_DMA_CH0_CONTROL_DSL), so cache maintenance on one descriptor
+// * never touches a neighbour that the hardware may be writing back.
+#define EQOS_DESCRIPTOR_SIZE	ALIGN(EQOS_DESCRIPTOR_WORDS * 4, \
+				      EQOS_DESCRIPTOR_ALIGN)
+#define EQOS_DESCRIPTORS_TX	16
 #define EQOS_DESCRIPTORS_RX	4
 #define EQOS_DESCRIPTORS_NUM	(EQOS_DESCRIPTORS_TX + EQOS_DESCRIPTORS_RX)
 #define EQOS_DESCRIPTORS_SIZE	ALIGN(EQOS_DESCRIPTORS_NUM * \
 				      EQOS_DESCRIPTOR_SIZE, ARCH_DMA_MINALIGN)
 #define EQOS_BUFFER_ALIGN	ARCH_DMA_MINALIGN
 #define EQOS_MAX_PACKET_SIZE	ALIGN(1568, ARCH_DMA_MINALIGN)
+#define EQOS_TX_BUFFER_SIZE	(EQOS_DESCRIPTORS_TX * EQOS_MAX_PACKET_SIZE)
 #define EQOS_RX_BUFFER_SIZE	(EQOS_DESCRIPTORS_RX * EQOS_MAX_PACKET_SIZE)
 
-// * Warn if the cache-line size is larger than the descriptor size. In such
-// * cases the driver will likely fail because the CPU needs to flush the cache
-// * when requeuing RX buffers, therefore descriptors written by the hardware
-// * may be discarded. Architectures with full IO coherence, such as x86, do not
-// * experience this issue, and hence are excluded from this condition.
-// *
-// * This can be fixed by defining CONFIG_SYS_NONCACHED_MEMORY which will cause
-// * the driver to allocate descriptors from a pool of non-cached memory.
-#if EQOS_DESCRIPTOR_SIZE < ARCH_DMA_MINALIGN
-#if !defined(CONFIG_SYS_NONCACHED_MEMORY) && \
-	!defined(CONFIG_SYS_DCACHE_OFF) && !defined(CONFIG_X86)
-#warning Cache line size is larger than descriptor size
-#endif
-#endif
+/*
+ * AXI master data width in bits, the unit of the descriptor skip length. It
+ * is an integration parameter of the IP, given by 'bst,axi-bus-width'.
+ */
+#define EQOS_AXI_WIDTH_DEFAULT	64
+
+/* Polling budget (in us) when the TX ring is full or being drained */
+#define EQOS_TX_TIMEOUT_US	10000
 
 struct eqos_desc {
 	u32 des0;
 	u32 des1;
 	u32 des2;
 	u32 des3;
-};
+} __aligned(EQOS_DESCRIPTOR_ALIGN);
 
 #define EQOS_DESC3_OWN		BIT(31)
 #define EQOS_DESC3_FD		BIT(29)
@@ -299,28 +301,28 @@ struct eqos_priv {
 	struct eqos_desc *tx_descs;
 	struct eqos_desc *rx_descs;
 	int tx_desc_idx, rx_desc_idx;
+	/* Oldest TX descriptor not yet reclaimed, and how many are in flight */
+	int tx_desc_clean, tx_desc_busy;
 	void *tx_dma_buf;
 	void *rx_dma_buf;
 	void *rx_pkt;
 	bool started;
 	bool reg_access_ok;
+	bool loopback;
+	int axi_bus_width;
 	int phy_interface;
 	int phy_addr;
 	int board;
 };
 
-// * TX and RX descriptors are 16 bytes. This causes problems with the cache
-// * maintenance on CPUs where the cache-line size exceeds the size of these
-// * descriptors. What will happen is that when the driver receives a packet
-// * it will be immediately requeued for the hardware to reuse. The CPU will
-// * therefore need to flush the cache-line containing the descriptor, which
-// * will cause all other descriptors in the same cache-line to be flushed
-// * along with it. If one of those descriptors had been written to by the
-// * device those changes (and the associated packet) will be lost.
+// * TX and RX descriptors are 16 bytes of hardware state, padded out to a
+// * cache line each. Without the padding, flushing one descriptor would also
+// * write back the other descriptors sharing its cache-line, discarding any
+// * status the device had written to them in the meantime. That would make it
+// * impossible to keep several TX frames in flight.
 // *
-// * To work around this, we make use of non-cached memory if available. If
-// * descriptors are mapped uncached there's no need to manually flush them
-// * or invalidate them.
+// * Non-cached memory is still used if available. If descriptors are mapped
+// * uncached there's no need to manually flush them or invalidate them.
 // *
 // * Note that this only applies to descriptors. The packet data buffers do
 // * not have the same constraints since they are 1536 bytes large, so they
@@ -866,6 +868,8 @@ static int eqos_start(struct udevice *dev)
 	//dcache_disable();
 
 	eqos->tx_desc_idx = 0;
+	eqos->tx_desc_clean = 0;
+	eqos->tx_desc_busy = 0;
 	eqos->rx_desc_idx = 0;
 
 	ret = eqos_start_clks(dev);
@@ -909,7 +913,7 @@ static int eqos_start(struct udevice *dev)
 		goto err_shutdown_phy;
 	}
 
-	if (!eqos->phy->link) {
+	if (!eqos->phy->link && !eqos->loopback) {
 		pr_err("No link");
 		goto err_shutdown_phy;
 	}
@@ -1063,6 +1067,11 @@ static int eqos_start(struct udevice *dev)
 	clrsetbits_le32(&eqos->mac_regs->configuration,
 			0xffffffff, EQOS_MAC_CONFIGURATION_DM);
 
+	/* MAC loopback: every frame sent is handed straight back to RX */
+	if (eqos->loopback)
+		setbits_le32(&eqos->mac_regs->configuration,
+			     EQOS_MAC_CONFIGURATION_LM);
+
 //	clrsetbits_le32(&eqos->mac_regs->configuration,
 //			EQOS_MAC_CONFIGURATION_GPSLCE |
 //			EQOS_MAC_CONFIGURATION_WD |
@@ -1088,9 +1097,24 @@ static int eqos_start(struct udevice *dev)
 	setbits_le32(&eqos->dma_regs->ch0_control,
 		     EQOS_DMA_CH0_CONTROL_PBLX8);
 
+	/* Skip the cache-line padding between descriptors */
+	val = (EQOS_DESCRIPTOR_SIZE - EQOS_DESCRIPTOR_WORDS * 4) /
+		(eqos->axi_bus_width / 8);
+	if (val > EQOS_DMA_CH0_CONTROL_DSL_MASK) {
+		pr_err("descriptor padding %d too large for DSL",
+		       EQOS_DESCRIPTOR_SIZE);
+		ret = -EINVAL;
+		goto err_shutdown_phy;
+	}
+	clrsetbits_le32(&eqos->dma_regs->ch0_control,
+			EQOS_DMA_CH0_CONTROL_DSL_MASK <<
+			EQOS_DMA_CH0_CONTROL_DSL_SHIFT,
+			val << EQOS_DMA_CH0_CONTROL_DSL_SHIFT);
+
 	/* Burst length must be < 1/2 FIFO size. */
 	/* FIFO size in tqs is encoded as (n / 256) - 1. */
-	/* Each burst is n * 8 (PBLX8) * 16 (AXI width) == 128 bytes. */
+	/* Each burst is n * 8 (PBLX8) beats of the AXI width, at most */
+	/* 16 bytes (128 bits), so at most n * 128 bytes. */
 	/* Half of n * 256 is n * 128, so pbl == tqs, modulo the -1. */
 	pbl = tqs + 1;
 	if (pbl > 32)
@@ -1177,6 +1201,43 @@ err:
 	return ret;
 }
 
+// * Retire TX descriptors the DMA has finished with, oldest first. Called
+// * lazily from send and recv instead of waiting for each frame to go out.
+// * Returns the number of descriptors still owned by the hardware.
+static int eqos_tx_reclaim(struct eqos_priv *eqos)
+{
+	struct eqos_desc *tx_desc;
+
+	while (eqos->tx_desc_busy) {
+		tx_desc = &eqos->tx_descs[eqos->tx_desc_clean];
+		eqos_inval_desc(tx_desc);
+		if (readl(&tx_desc->des3) & EQOS_DESC3_OWN)
+			break;
+
+		eqos->tx_desc_clean++;
+		eqos->tx_desc_clean %= EQOS_DESCRIPTORS_TX;
+		eqos->tx_desc_busy--;
+	}
+
+	return eqos->tx_desc_busy;
+}
+
+static int eqos_tx_drain(struct eqos_priv *eqos)
+{
+	int i;
+
+	for (i = 0; eqos_tx_reclaim(eqos); i++) {
+		if (i == EQOS_TX_TIMEOUT_US) {
+			debug("%s: %d TX frames still queued\n", __func__,
+			      eqos->tx_desc_busy);
+			return -ETIMEDOUT;
+		}
+		udelay(1);
+	}
+
+	return 0;
+}
+
 void eqos_stop(struct udevice *dev)
 {
 	struct eqos_priv *eqos = dev_get_priv(dev);
@@ -1189,6 +1250,9 @@ void eqos_stop(struct udevice *dev)
 	eqos->started = false;
 	eqos->reg_access_ok = false;
 
+	/* Let frames still queued in the TX ring go out on the wire */
+	eqos_tx_drain(eqos);
+
 	/* Disable TX DMA */
 	clrbits_le32(&eqos->dma_regs->ch0_tx_control,
 		     EQOS_DMA_CH0_TX_CONTROL_ST);
@@ -1237,20 +1301,37 @@ int eqos_send(struct udevice *dev, void *packet, int length)
 {
 	struct eqos_priv *eqos = dev_get_priv(dev);
 	struct eqos_desc *tx_desc;
+	void *tx_buf;
 	int i;
 
 	debug("%s(dev=%p, packet=%p, length=%d):\n", __func__, dev, packet,
 	      length);
-	//dcache_disable();
 
-	memcpy(eqos->tx_dma_buf, packet, length);
-	eqos_flush_buffer(eqos->tx_dma_buf, length);
+	if (length > EQOS_MAX_PACKET_SIZE)
+		return -EINVAL;
+
+	/* Only block when every descriptor is still owned by the DMA */
+	for (i = 0; eqos_tx_reclaim(eqos) == EQOS_DESCRIPTORS_TX; i++) {
+		if (i == EQOS_TX_TIMEOUT_US) {
+			debug("%s: TX timeout\n", __func__);
+			return -ETIMEDOUT;
+		}
+		udelay(1);
+	}
+
+	/* The caller reuses its packet buffer as soon as we return, so the */
+	/* frame is staged in the buffer owned by this ring slot and is sent */
+	/* from there while the next frame is being built. */
+	tx_buf = eqos->tx_dma_buf + eqos->tx_desc_idx * EQOS_MAX_PACKET_SIZE;
+	memcpy(tx_buf, packet, length);
+	eqos_flush_buffer(tx_buf, length);
 
 	tx_desc = &eqos->tx_descs[eqos->tx_desc_idx];
 	eqos->tx_desc_idx++;
 	eqos->tx_desc_idx %= EQOS_DESCRIPTORS_TX;
+	eqos->tx_desc_busy++;
 
-	tx_desc->des0 = (ulong)eqos->tx_dma_buf;
+	tx_desc->des0 = (ulong)tx_buf;
 	tx_desc->des1 = 0;
 	tx_desc->des2 = length;
 	/* Make sure that if HW sees the _OWN write below, it will see */
@@ -1261,19 +1342,7 @@ int eqos_send(struct udevice *dev, void *packet, int length)
 
 	writel((ulong)(tx_desc + 1), &eqos->dma_regs->ch0_txdesc_tail_pointer);
 
-	for (i = 0; i < 10000; i++) {
-		eqos_inval_desc(tx_desc);
-		if (!(readl(&tx_desc->des3) & EQOS_DESC3_OWN)) {
-			//dcache_enable();
-			return 0;
-		}
-		udelay(1);
-	}
-
-	//dcache_enable();
-	debug("%s: TX timeout\n", __func__);
-
-	return -ETIMEDOUT;
+	return 0;
 }
 
 int eqos_recv(struct udevice *dev, int flags, uchar **packetp)
@@ -1284,7 +1353,10 @@ int eqos_recv(struct udevice *dev, int flags, uchar **packetp)
 
 	debug("%s(dev=%p, flags=%x):\n", __func__, dev, flags);
 	//dcache_disable();
+	eqos_tx_reclaim(eqos);
+
 	rx_desc = &eqos->rx_descs[eqos->rx_desc_idx];
+	eqos_inval_desc(rx_desc);
 	if (rx_desc->des3 & EQOS_DESC3_OWN) {
 		debug("%s: RX desc not avail 0x%p\n", __func__, rx_desc);
 		//dcache_enable();
@@ -1353,7 +1425,7 @@ static int eqos_probe_resources_core(struct udevice *dev)
 	eqos->rx_descs = (eqos->tx_descs + EQOS_DESCRIPTORS_TX);
 	debug("tx=0x%p, rx=0x%p\n", eqos->tx_descs, eqos->rx_descs);
 
-	eqos->tx_dma_buf = memalign(EQOS_BUFFER_ALIGN, EQOS_MAX_PACKET_SIZE);
+	eqos->tx_dma_buf = memalign(EQOS_BUFFER_ALIGN, EQOS_TX_BUFFER_SIZE);
 	if (!eqos->tx_dma_buf) {
 		debug("%s: memalign(tx_dma_buf) failed\n", __func__);
 		ret = -ENOMEM;
@@ -1425,6 +1497,16 @@ static int eqos_probe_resources(struct udevice *dev)
 		return -EBUSY;
 	}
 
+	eqos->loopback = dev_read_bool(dev, "bst,mac-loopback");
+
+	eqos->axi_bus_width = dev_read_u32_default(dev, "bst,axi-bus-width",
+						   EQOS_AXI_WIDTH_DEFAULT);
+	if (eqos->axi_bus_width != 32 && eqos->axi_bus_width != 64 &&
+	    eqos->axi_bus_width != 128) {
+		pr_err("invalid AXI bus width %d\n", eqos->axi_bus_width);
+		return -EINVAL;
+	}
+
 	ret = get_board_type();
 	if (ret < 0)
 		return -ENXIO;
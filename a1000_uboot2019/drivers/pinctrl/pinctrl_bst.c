@@ -1,16 +1,24 @@
 // SPDX-License-Identifier: GPL-2.0+
 #include <common.h>
 #include <asm/io.h>
+#include <dt-structs.h>
 #include <dm/device.h>
 #include <dm/pinctrl.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+struct bst_pinctrl_platdata {
+	struct dtd_bst_a1000_pinctrl dtplat;
+};
+#endif
+
 struct bst_pinctrl_priv {
 	fdt_addr_t base0; /* pinctrl group 0 reg base */
 	fdt_addr_t base1; /* pinctrl group 1 reg base */
 };
 
+#if !CONFIG_IS_ENABLED(OF_PLATDATA)
 static int bst_pinctrl_set_state_simple(struct udevice *dev,
 					struct udevice *periph)
 {
@@ -59,15 +67,31 @@ static int bst_pinctrl_set_state_simple(struct udevice *dev,
 
 	return 0;
 }
+#endif
 
+/*
+ * With of-platdata the pin groups are not available, since dtoc only emits
+ * nodes with a compatible string. Peripherals then have no pinctrl state to
+ * select and keep the muxing set up by the boot ROM.
+ */
 static const struct pinctrl_ops bst_pinctrl_ops = {
+#if !CONFIG_IS_ENABLED(OF_PLATDATA)
 	.set_state_simple = bst_pinctrl_set_state_simple,
+#endif
 };
 
 static int bst_pinctrl_probe(struct udevice *dev)
 {
 	struct bst_pinctrl_priv *priv = dev_get_priv(dev);
 
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	struct bst_pinctrl_platdata *plat = dev_get_platdata(dev);
+	struct dtd_bst_a1000_pinctrl *dtplat = &plat->dtplat;
+
+	/* Each of reggrp0/1 is <addr_hi addr_lo size_hi size_lo> */
+	priv->base0 = ((u64)dtplat->reggrp0[0] << 32) | dtplat->reggrp0[1];
+	priv->base1 = ((u64)dtplat->reggrp1[0] << 32) | dtplat->reggrp1[1];
+#else
 	priv->base0 = fdtdec_get_addr(gd->fdt_blob,
 			dev_of_offset(dev), "reggrp0");
 	if (priv->base0 == FDT_ADDR_T_NONE)
@@ -77,6 +101,7 @@ static int bst_pinctrl_probe(struct udevice *dev)
 			dev_of_offset(dev), "reggrp1");
 	if (priv->base1 == FDT_ADDR_T_NONE)
 		return -EINVAL;
+#endif
 
 	debug("%s: base0 is 0x%llx\n", __func__, priv->base0);
 	debug("%s: base1 is 0x%llx\n", __func__, priv->base1);
@@ -90,11 +115,18 @@ static const struct udevice_id bst_pinctrl_match[] = {
 };
 
 U_BOOT_DRIVER(pinctrl_bst) = {
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	.name			= "bst_a1000_pinctrl",
+#else
 	.name			= "pinctrl_bst",
+#endif
 	.id				= UCLASS_PINCTRL,
 	.of_match		= bst_pinctrl_match,
 	.probe			= bst_pinctrl_probe,
 	.ops			= &bst_pinctrl_ops,
 	.flags			= DM_FLAG_PRE_RELOC,
 	.priv_auto_alloc_size	= sizeof(struct bst_pinctrl_priv),
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	.platdata_auto_alloc_size = sizeof(struct bst_pinctrl_platdata),
+#endif
 };
@@ -6,6 +6,7 @@
  */
 #include <common.h>
 #include <dm.h>
+#include <dt-structs.h>
 #include <dm/of_access.h>
 #include <reset-uclass.h>
 #include <linux/bitops.h>
@@ -16,6 +17,16 @@ struct bst_reset_data {
 	void __iomem *membase;
 };
 
+/*
+ * With of-platdata this must be exactly the dtoc struct, so that clients can
+ * find the controller through reset_get_by_index_platdata()
+ */
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+struct bst_reset_platdata {
+	struct dtd_bst_a1000_reset dtplat;
+};
+#endif
+
 static int bst_reset_assert(struct reset_ctl *reset_ctl)
 {
 	struct bst_reset_data *data = dev_get_priv(reset_ctl->dev);
@@ -63,7 +74,13 @@ static int bst_reset_probe(struct udevice *dev)
 {
 	struct bst_reset_data *data = dev_get_priv(dev);
 
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	struct bst_reset_platdata *plat = dev_get_platdata(dev);
+
+	data->membase = (void __iomem *)(uintptr_t)plat->dtplat.reg[0];
+#else
 	data->membase = devfdt_get_addr_ptr(dev);
+#endif
 
 return 0;
 }
@@ -74,10 +91,18 @@ static const struct udevice_id bst_reset_match[] = {
 };
 
 U_BOOT_DRIVER(bst_reset) = {
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	.name = "bst_a1000_reset",
+#else
 	.name = "bst-reset",
+#endif
 	.id = UCLASS_RESET,
 	.of_match = bst_reset_match,
 	.probe = bst_reset_probe,
 	.priv_auto_alloc_size = sizeof(struct bst_reset_data),
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	.platdata_auto_alloc_size = sizeof(struct bst_reset_platdata),
+#endif
 	.ops = &bst_reset_ops,
+	.flags = DM_FLAG_PRE_RELOC,
 };
@@ -5,9 +5,11 @@
 
 #include <common.h>
 #include <dm.h>
+#include <dt-structs.h>
 #include <fdtdec.h>
 #include <reset.h>
 #include <reset-uclass.h>
+#include <dm/device-internal.h>
 
 static inline struct reset_ops *reset_dev_ops(struct udevice *dev)
 {
@@ -78,6 +80,51 @@ int reset_get_by_index(struct udevice *dev, int index,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+int reset_get_by_index_platdata(struct udevice *dev, int index,
+				struct phandle_1_arg *cells,
+				struct reset_ctl *reset_ctl)
+{
+	struct udevice *dev_reset;
+	struct reset_ops *ops;
+	struct uclass *uc;
+	int ret;
+
+	debug("%s(dev=%p, index=%d, reset_ctl=%p)\n", __func__, dev, index,
+	      reset_ctl);
+	reset_ctl->dev = NULL;
+
+	ret = uclass_get(UCLASS_RESET, &uc);
+	if (ret)
+		return ret;
+
+	/* The phandle points at the dtoc platdata of the provider */
+	ret = -ENODEV;
+	uclass_foreach_dev(dev_reset, uc) {
+		if (dev_get_platdata(dev_reset) == cells[index].node) {
+			ret = device_probe(dev_reset);
+			break;
+		}
+	}
+	if (ret) {
+		debug("%s: no reset provider: %d\n", __func__, ret);
+		return ret;
+	}
+
+	ops = reset_dev_ops(dev_reset);
+	reset_ctl->dev = dev_reset;
+	reset_ctl->id = cells[index].arg[0];
+
+	ret = ops->request(reset_ctl);
+	if (ret) {
+		debug("ops->request() failed: %d\n", ret);
+		return ret;
+	}
+
+	return 0;
+}
+#endif
+
 int reset_get_bulk(struct udevice *dev, struct reset_ctl_bulk *bulk)
 {
 	int i, ret, err, count;
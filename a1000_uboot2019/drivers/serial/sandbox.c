@@ -43,6 +43,7 @@ struct sandbox_serial_platdata {
 
 struct sandbox_serial_priv {
 	bool start_of_line;
+	unsigned int writes;	/* Number of writes made to the terminal */
 };
 
 /**
@@ -99,12 +100,44 @@ static int sandbox_serial_putc(struct udevice *dev, const char ch)
 	}
 
 	os_write(1, &ch, 1);
+	priv->writes++;
 	if (ch == '\n')
 		priv->start_of_line = true;
 
 	return 0;
 }
 
+static ssize_t sandbox_serial_puts(struct udevice *dev, const char *s,
+				   size_t len)
+{
+	struct sandbox_serial_priv *priv = dev_get_priv(dev);
+	struct sandbox_serial_platdata *plat = dev->platdata;
+	const char *newline;
+
+	if (priv->start_of_line && plat->colour != -1) {
+		priv->start_of_line = false;
+		output_ansi_colour(plat->colour);
+	}
+
+	/* Stop after a newline, so the colour is set again for the next line */
+	newline = memchr(s, '\n', len);
+	if (newline)
+		len = newline - s + 1;
+	os_write(1, s, len);
+	priv->writes++;
+	if (s[len - 1] == '\n')
+		priv->start_of_line = true;
+
+	return len;
+}
+
+unsigned int sandbox_serial_get_writes(struct udevice *dev)
+{
+	struct sandbox_serial_priv *priv = dev_get_priv(dev);
+
+	return priv->writes;
+}
+
 static unsigned int increment_buffer_index(unsigned int index)
 {
 	return (index + 1) % ARRAY_SIZE(serial_buf);
@@ -237,6 +270,7 @@ static int sandbox_serial_ofdata_to_platdata(struct udevice *dev)
 
 static const struct dm_serial_ops sandbox_serial_ops = {
 	.putc = sandbox_serial_putc,
+	.puts = sandbox_serial_puts,
 	.pending = sandbox_serial_pending,
 	.getc = sandbox_serial_getc,
 	.getconfig = sandbox_serial_getconfig,
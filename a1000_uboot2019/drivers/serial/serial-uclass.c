@@ -183,10 +183,46 @@ static void _serial_putc(struct udevice *dev, char ch)
 	} while (err == -EAGAIN);
 }
 
+static int _serial_puts_raw(struct udevice *dev, const char *str, size_t len)
+{
+	struct dm_serial_ops *ops = serial_get_ops(dev);
+	ssize_t written;
+
+	while (len) {
+		written = ops->puts(dev, str, len);
+		if (written == -EAGAIN)
+			continue;
+		if (written < 0)
+			return written;
+		str += written;
+		len -= written;
+	}
+
+	return 0;
+}
+
 static void _serial_puts(struct udevice *dev, const char *str)
 {
-	while (*str)
-		_serial_putc(dev, *str++);
+	struct dm_serial_ops *ops = serial_get_ops(dev);
+	const char *newline;
+	size_t len;
+
+	if (!CONFIG_IS_ENABLED(SERIAL_PUTS) || !ops->puts) {
+		while (*str)
+			_serial_putc(dev, *str++);
+		return;
+	}
+
+	/* Hand each line to the driver at once, expanding newlines */
+	while (*str) {
+		newline = strchrnul(str, '\n');
+		len = newline - str;
+		if (_serial_puts_raw(dev, str, len))
+			return;
+		if (*newline && _serial_puts_raw(dev, "\r\n", 2))
+			return;
+		str += len + !!*newline;
+	}
 }
 
 static int __serial_getc(struct udevice *dev)
@@ -282,6 +318,21 @@ int serial_tstc(void)
 	return _serial_tstc(gd->cur_serial_dev);
 }
 
+void serial_flush(void)
+{
+	struct dm_serial_ops *ops;
+
+	if (!gd->cur_serial_dev)
+		return;
+
+	ops = serial_get_ops(gd->cur_serial_dev);
+	if (!ops->pending)
+		return;
+
+	while (ops->pending(gd->cur_serial_dev, false) > 0)
+		;
+}
+
 void serial_setbrg(void)
 {
 	struct dm_serial_ops *ops;
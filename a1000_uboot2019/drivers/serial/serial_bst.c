@@ -8,6 +8,7 @@
 #include <asm/arch/regs-uart.h>
 #include <asm/io.h>
 #include <dm.h>
+#include <dt-structs.h>
 #include <dm/platform_data/serial_bst.h>
 #include <linux/compiler.h>
 #include <serial.h>
@@ -83,7 +84,7 @@ static void bst_serial_setbrg_common(struct bst_uart_regs *uart_regs,
 	writel(readl(&uart_regs->lcr) | (LCR_WLS1 | LCR_WLS0), &uart_regs->lcr);
 }
 
-#if defined CONFIG_SPL_SERIAL_SUPPORT && defined CONFIG_SPL_BUILD
+#if defined(CONFIG_SPL_BUILD) && !CONFIG_IS_ENABLED(DM_SERIAL)
 
 static void bst_serial_setbrg(void)
 {
@@ -163,25 +164,145 @@ __weak struct serial_device *default_serial_console(void)
 
 #else
 
-static int bst_serial_putc(struct udevice *dev, const char ch)
+struct bst_uart_platdata {
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	struct dtd_bst_a1000_dw_uart dtplat;
+#endif
+	struct bst_serial_platdata plat;
+	unsigned int fifo_size;	/* Transmit FIFO depth, 1 if FIFOs are off */
+};
+
+#define BST_SERIAL_TX_MASK	(CONFIG_BST_SERIAL_TX_BUFFER_SIZE - 1)
+
+/**
+ * struct bst_serial_priv - Transmit state of a BST UART
+ *
+ * Output which does not fit in the transmit FIFO is held here and written
+ * out as the FIFO empties, whenever the console next calls into the driver.
+ *
+ * @tx_head: Count of characters added to @tx_buf
+ * @tx_tail: Count of characters written from @tx_buf to the FIFO
+ * @tx_buf: Ring of characters waiting for the FIFO
+ */
+struct bst_serial_priv {
+	unsigned int tx_head;
+	unsigned int tx_tail;
+	char tx_buf[CONFIG_BST_SERIAL_TX_BUFFER_SIZE];
+};
+
+static struct bst_serial_platdata *bst_serial_get_plat(struct udevice *dev)
 {
-	struct bst_serial_platdata *plat = dev->platdata;
-	struct bst_uart_regs *uart_regs = (struct bst_uart_regs *)plat->base;
+	struct bst_uart_platdata *uplat = dev_get_platdata(dev);
 
-	/* Wait for last character to go. */
-	if (!(readl(&uart_regs->lsr) & LSR_TEMT))
-		return -EAGAIN;
+	return &uplat->plat;
+}
 
-	writel(ch, &uart_regs->thr);
+/*
+ * Device data allocated before relocation is thrown away along with the
+ * devices, and is freed when the device is removed before booting an OS, so
+ * only buffer output between those points.
+ */
+static struct bst_serial_priv *bst_serial_get_ring(struct udevice *dev)
+{
+	if (!(gd->flags & GD_FLG_RELOC) || !device_active(dev))
+		return NULL;
+
+	return dev_get_priv(dev);
+}
+
+/* Return the number of characters the transmit FIFO can take right now */
+static unsigned int bst_serial_tx_room(struct udevice *dev)
+{
+	struct bst_uart_platdata *uplat = dev_get_platdata(dev);
+	struct bst_uart_regs *uart_regs = uplat->plat.base;
+
+	/* THRE means the whole FIFO is empty, as THRE interrupts are off */
+	if (readl(&uart_regs->lsr) & LSR_TDRQ)
+		return uplat->fifo_size;
+	if (uplat->fifo_size > 1 && (readl(&uart_regs->usr) & USR_TFNF))
+		return 1;
 
 	return 0;
 }
 
+/* Write characters to the FIFO until it is full, returning the count sent */
+static size_t bst_serial_tx_fill(struct udevice *dev, const char *s,
+				 size_t len)
+{
+	struct bst_serial_platdata *plat = bst_serial_get_plat(dev);
+	struct bst_uart_regs *uart_regs = plat->base;
+	size_t count = 0;
+	unsigned int room;
+
+	while (count < len) {
+		room = min_t(size_t, bst_serial_tx_room(dev), len - count);
+		if (!room)
+			break;
+		while (room--)
+			writel(s[count++], &uart_regs->thr);
+	}
+
+	return count;
+}
+
+/* Move as much buffered output as possible into the FIFO */
+static void bst_serial_tx_drain(struct udevice *dev)
+{
+	struct bst_serial_priv *priv = bst_serial_get_ring(dev);
+	unsigned int start, len;
+	size_t sent;
+
+	if (!priv)
+		return;
+
+	while (priv->tx_head != priv->tx_tail) {
+		start = priv->tx_tail & BST_SERIAL_TX_MASK;
+		len = min(priv->tx_head - priv->tx_tail,
+			  CONFIG_BST_SERIAL_TX_BUFFER_SIZE - start);
+		sent = bst_serial_tx_fill(dev, &priv->tx_buf[start], len);
+		priv->tx_tail += sent;
+		if (sent < len)
+			break;
+	}
+}
+
+static ssize_t bst_serial_puts(struct udevice *dev, const char *s, size_t len)
+{
+	struct bst_serial_priv *priv = bst_serial_get_ring(dev);
+	size_t count = 0;
+
+	bst_serial_tx_drain(dev);
+
+	/* Earlier output must go first, so only bypass an empty ring */
+	if (!priv || priv->tx_head == priv->tx_tail)
+		count = bst_serial_tx_fill(dev, s, len);
+
+	if (priv) {
+		while (count < len && priv->tx_head - priv->tx_tail <
+		       CONFIG_BST_SERIAL_TX_BUFFER_SIZE)
+			priv->tx_buf[priv->tx_head++ & BST_SERIAL_TX_MASK] =
+				s[count++];
+	}
+
+	return count ? count : -EAGAIN;
+}
+
+static int bst_serial_putc(struct udevice *dev, const char ch)
+{
+	ssize_t ret;
+
+	ret = bst_serial_puts(dev, &ch, 1);
+
+	return ret < 0 ? ret : 0;
+}
+
 static int bst_serial_getc(struct udevice *dev)
 {
-	struct bst_serial_platdata *plat = dev->platdata;
+	struct bst_serial_platdata *plat = bst_serial_get_plat(dev);
 	struct bst_uart_regs *uart_regs = (struct bst_uart_regs *)plat->base;
 
+	bst_serial_tx_drain(dev);
+
 	/* Wait for a character to arrive. */
 	if (!(readl(&uart_regs->lsr) & LSR_DR))
 		return -EAGAIN;
@@ -189,11 +310,44 @@ static int bst_serial_getc(struct udevice *dev)
 	return readl(&uart_regs->rbr) & 0xff;
 }
 
+static int bst_serial_pending(struct udevice *dev, bool input)
+{
+	struct bst_serial_platdata *plat = bst_serial_get_plat(dev);
+	struct bst_uart_regs *uart_regs = (struct bst_uart_regs *)plat->base;
+	struct bst_serial_priv *priv;
+	int count = 0;
+
+	/* The console polls this while idle, so use it to drain output */
+	bst_serial_tx_drain(dev);
+
+	if (input)
+		return readl(&uart_regs->lsr) & LSR_DR ? 1 : 0;
+
+	priv = bst_serial_get_ring(dev);
+	if (priv)
+		count = priv->tx_head - priv->tx_tail;
+	if (!(readl(&uart_regs->lsr) & LSR_TEMT))
+		count++;
+
+	return count;
+}
+
+/* Wait until all buffered output has left the UART */
+static void bst_serial_flush(struct udevice *dev)
+{
+	while (bst_serial_pending(dev, false))
+		WATCHDOG_RESET();
+}
+
 static int bst_serial_setbrg(struct udevice *dev, int baudrate)
 {
-	struct bst_serial_platdata *plat = dev->platdata;
+	struct bst_serial_platdata *plat = bst_serial_get_plat(dev);
 	struct bst_uart_regs *uart_regs = (struct bst_uart_regs *)plat->base;
 
+	/* Do not garble output already queued at the old rate */
+	if (bst_serial_get_ring(dev))
+		bst_serial_flush(dev);
+
 	if (!gd->baudrate)
 		gd->baudrate = plat->baudrate;
 
@@ -202,31 +356,43 @@ static int bst_serial_setbrg(struct udevice *dev, int baudrate)
 	return 0;
 }
 
-static int bst_serial_pending(struct udevice *dev, bool input)
+static int bst_serial_probe(struct udevice *dev)
 {
-	struct bst_serial_platdata *plat = dev->platdata;
-	struct bst_uart_regs *uart_regs = (struct bst_uart_regs *)plat->base;
+	struct bst_uart_platdata *uplat = dev_get_platdata(dev);
+	struct bst_uart_regs *uart_regs = uplat->plat.base;
 
-	if (input)
-		return readl(&uart_regs->lsr) & LSR_DR ? 1 : 0;
+	BUILD_BUG_ON(CONFIG_BST_SERIAL_TX_BUFFER_SIZE & BST_SERIAL_TX_MASK);
+
+	bst_serial_setbrg(dev, uplat->plat.baudrate);
+
+	/* The DW APB UART FIFO depth is at least 16 when it is enabled */
+	if (readl(&uart_regs->iir) & (IIR_FIFOES1 | IIR_FIFOES0))
+		uplat->fifo_size = 16;
 	else
-		return readl(&uart_regs->lsr) & LSR_TEMT ? 0 : 1;
+		uplat->fifo_size = 1;
 
 	return 0;
 }
 
-static int bst_serial_probe(struct udevice *dev)
+static int bst_serial_remove(struct udevice *dev)
 {
-	struct bst_serial_platdata *plat = dev->platdata;
-
-	bst_serial_setbrg(dev, plat->baudrate);
+	/* Let the console output finish before an OS takes over the UART */
+	bst_serial_flush(dev);
 
 	return 0;
 }
 
 static int bst_serial_ofdata_to_platdata(struct udevice *dev)
 {
-	struct bst_serial_platdata *plat = dev->platdata;
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	struct bst_uart_platdata *uplat = dev_get_platdata(dev);
+	struct dtd_bst_a1000_dw_uart *dtplat = &uplat->dtplat;
+
+	/* Fill in the standard platform data from the dtoc output */
+	uplat->plat.base = (struct bst_uart_regs *)(uintptr_t)dtplat->reg[0];
+	uplat->plat.baudrate = dtplat->baudrate ?: CONFIG_BAUDRATE;
+#else
+	struct bst_serial_platdata *plat = bst_serial_get_plat(dev);
 	fdt_addr_t addr;
 	int baudrate;
 
@@ -242,12 +408,14 @@ static int bst_serial_ofdata_to_platdata(struct udevice *dev)
 		return -EINVAL;
 
 	plat->baudrate = baudrate;
+#endif
 
 	return 0;
 }
 
 static const struct dm_serial_ops bst_serial_ops = {
 	.putc		= bst_serial_putc,
+	.puts		= bst_serial_puts,
 	.pending	= bst_serial_pending,
 	.getc		= bst_serial_getc,
 	.setbrg		= bst_serial_setbrg,
@@ -259,14 +427,20 @@ static const struct udevice_id bst_serial_ids[] = {
 };
 
 U_BOOT_DRIVER(serial_bst) = {
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	.name	= "bst_a1000_dw_uart",
+#else
 	.name	= "serial_bst",
+#endif
 	.id	= UCLASS_SERIAL,
 	.of_match = bst_serial_ids,
 	.ofdata_to_platdata = bst_serial_ofdata_to_platdata,
-	.platdata_auto_alloc_size = sizeof(struct bst_serial_platdata),
+	.platdata_auto_alloc_size = sizeof(struct bst_uart_platdata),
+	.priv_auto_alloc_size = sizeof(struct bst_serial_priv),
 	.probe	= bst_serial_probe,
+	.remove	= bst_serial_remove,
 	.ops	= &bst_serial_ops,
-	.flags	= DM_FLAG_PRE_RELOC,
+	.flags	= DM_FLAG_PRE_RELOC | DM_FLAG_OS_PREPARE,
 };
 
 #endif
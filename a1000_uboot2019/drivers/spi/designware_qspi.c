@@ -13,15 +13,18 @@
 #include <asm-generic/gpio.h>
 #include <clk.h>
 #include <dm.h>
+#include <dt-structs.h>
 #include <errno.h>
 #include <malloc.h>
 #include <spi.h>
+#include <spi-mem.h>
 #include <fdtdec.h>
 #include <reset.h>
 #include <linux/compat.h>
 #include <linux/iopoll.h>
 #include <watchdog.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
 #include <watchdog.h>
 
 
@@ -53,6 +56,7 @@ DECLARE_GLOBAL_DATA_PTR;
 #define DW_QSPI_IDR			0x58
 #define DW_QSPI_VERSION			0x5c
 #define DW_QSPI_DR			0x60
+#define DW_QSPI_SPI_CTRL0		0xf4
 
 /* Bit fields in CTRLR0 */
 #define SPI_DFS_OFFSET			0
@@ -78,6 +82,28 @@ DECLARE_GLOBAL_DATA_PTR;
 #define SPI_SRL_OFFSET			11
 #define SPI_CFS_OFFSET			12
 
+#define SPI_SPI_FRF_OFFSET		22
+#define SPI_SPI_FRF_STD			0x0
+#define SPI_SPI_FRF_DUAL		0x1
+#define SPI_SPI_FRF_QUAD		0x2
+
+/* Bit fields in SPI_CTRLR0 (enhanced SPI mode) */
+#define SPI_TRANS_TYPE_OFFSET		0
+#define SPI_TRANS_TYPE_TT0		0x0	/* inst & addr on 1 line */
+#define SPI_TRANS_TYPE_TT1		0x1	/* addr on SPI_FRF lines */
+#define SPI_ADDR_L_OFFSET		2	/* in 4 bit units */
+#define SPI_INST_L_OFFSET		8
+#define SPI_INST_L_8			0x2
+#define SPI_WAIT_CYCLES_OFFSET		11
+#define SPI_WAIT_CYCLES_MAX		0x1f
+#define SPI_CLK_STRETCH_EN		BIT(30)
+
+/* Bit fields in TXFTLR */
+#define SPI_TXFTHR_OFFSET		16
+
+/* Max number of data frames (CTRLR1.NDF + 1) of one enhanced transfer */
+#define DW_QSPI_MAX_NDF			0x10000
+
 /* Bit fields in SR, 7 bits */
 #define SR_MASK				GENMASK(6, 0)	/* cover 7 bits */
 #define SR_BUSY				BIT(0)
@@ -91,6 +117,9 @@ DECLARE_GLOBAL_DATA_PTR;
 #define RX_TIMEOUT			1000		/* timeout in ms */
 
 struct dw_qspi_platdata {
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	struct dtd_snps_dw_ahb_ssi dtplat;
+#endif
 	s32 frequency;		/* Default clock frequency, -1 for none */
 	void __iomem *regs;
 };
@@ -168,6 +197,16 @@ static int request_gpio_cs(struct udevice *bus)
 
 static int dw_qspi_ofdata_to_platdata(struct udevice *bus)
 {
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	struct dw_qspi_platdata *plat = bus->platdata;
+	struct dtd_snps_dw_ahb_ssi *dtplat = &plat->dtplat;
+
+	/* There is no tree to look up cs-gpio in, so the SSI drives CS */
+	plat->regs = (void __iomem *)(uintptr_t)dtplat->reg[0];
+	plat->frequency = dtplat->spi_max_frequency ?: 500000;
+
+	return 0;
+#else
 	struct dw_qspi_platdata *plat = bus->platdata;
 	const void *blob = gd->fdt_blob;
 	int node = dev_of_offset(bus);
@@ -181,6 +220,7 @@ static int dw_qspi_ofdata_to_platdata(struct udevice *bus)
 	      plat->frequency);
 
 	return request_gpio_cs(bus);
+#endif
 }
 
 static inline void spi_enable_chip(struct dw_qspi_priv *priv, int enable)
@@ -260,7 +300,20 @@ static int dw_qspi_reset(struct udevice *bus)
 	int ret;
 	struct dw_qspi_priv *priv = dev_get_priv(bus);
 
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	struct dw_qspi_platdata *plat = dev_get_platdata(bus);
+
+	priv->resets.resets = devm_kcalloc(bus, 1, sizeof(struct reset_ctl),
+					   GFP_KERNEL);
+	if (!priv->resets.resets)
+		return -ENOMEM;
+	ret = reset_get_by_index_platdata(bus, 0, plat->dtplat.resets,
+					  &priv->resets.resets[0]);
+	if (!ret)
+		priv->resets.count = 1;
+#else
 	ret = reset_get_bulk(bus, &priv->resets);
+#endif
 	if (ret) {
 		/*
 		 * Return 0 if error due to !CONFIG_DM_RESET and reset
@@ -534,6 +587,210 @@ static int dw_qspi_xfer(struct udevice *dev, unsigned int bitlen,
 	return ret;
 }
 
+/*
+ * Enhanced SPI memory operations: the controller shifts out the opcode and
+ * the address, inserts the dummy cycles and moves the data phase on 2 or 4
+ * lines by itself, stretching the clock whenever the FIFO runs empty (tx)
+ * or full (rx). Single line operations keep using dw_qspi_xfer().
+ */
+static bool dw_qspi_mem_is_enhanced(const struct spi_mem_op *op)
+{
+	return op->data.nbytes && op->data.buswidth > 1;
+}
+
+static int dw_qspi_adjust_op_size(struct spi_slave *slave,
+				  struct spi_mem_op *op)
+{
+	if (!dw_qspi_mem_is_enhanced(op))
+		return 0;
+
+	/* Reads move whole 32-bit frames, the tail is a separate op */
+	if (op->data.dir == SPI_MEM_DATA_IN && op->data.nbytes >= 4)
+		op->data.nbytes = min_t(unsigned int,
+					op->data.nbytes & ~3,
+					DW_QSPI_MAX_NDF * 4);
+	else
+		op->data.nbytes = min_t(unsigned int, op->data.nbytes,
+					DW_QSPI_MAX_NDF);
+
+	return 0;
+}
+
+static bool dw_qspi_supports_op(struct spi_slave *slave,
+				const struct spi_mem_op *op)
+{
+	if (!spi_mem_default_supports_op(slave, op))
+		return false;
+
+	if (!dw_qspi_mem_is_enhanced(op))
+		return true;
+
+	if (op->cmd.buswidth != 1)
+		return false;
+
+	if (op->addr.nbytes &&
+	    (op->addr.nbytes > 4 || (op->addr.buswidth != 1 &&
+				     op->addr.buswidth != op->data.buswidth)))
+		return false;
+
+	if (op->dummy.nbytes &&
+	    (op->dummy.buswidth != op->addr.buswidth ||
+	     op->dummy.nbytes * 8 / op->dummy.buswidth > SPI_WAIT_CYCLES_MAX))
+		return false;
+
+	return true;
+}
+
+static int dw_qspi_mem_read(struct dw_qspi_priv *priv, u8 *buf,
+			    unsigned int len, unsigned int frame_bytes)
+{
+	ulong start = get_timer(0);
+	u32 n, val;
+
+	while (len) {
+		/* Drain everything the FIFO holds per status read */
+		n = dw_read(priv, DW_QSPI_RXFLR);
+		if (!n) {
+			if (get_timer(start) > RX_TIMEOUT)
+				return -ETIMEDOUT;
+			continue;
+		}
+
+		n = min_t(u32, n, len / frame_bytes);
+		len -= n * frame_bytes;
+		while (n--) {
+			val = dw_read(priv, DW_QSPI_DR);
+			if (frame_bytes == 4)
+				put_unaligned_be32(val, buf);
+			else
+				*buf = val;
+			buf += frame_bytes;
+		}
+		start = get_timer(0);
+	}
+
+	return 0;
+}
+
+static int dw_qspi_mem_write(struct dw_qspi_priv *priv, const u8 *buf,
+			     unsigned int len)
+{
+	ulong start = get_timer(0);
+	u32 n;
+
+	while (len) {
+		n = priv->fifo_len - dw_read(priv, DW_QSPI_TXFLR);
+		if (!n) {
+			if (get_timer(start) > RX_TIMEOUT)
+				return -ETIMEDOUT;
+			continue;
+		}
+
+		n = min_t(u32, n, len);
+		len -= n;
+		while (n--)
+			dw_write(priv, DW_QSPI_DR, *buf++);
+		start = get_timer(0);
+	}
+
+	return 0;
+}
+
+static int dw_qspi_exec_op(struct spi_slave *slave,
+			   const struct spi_mem_op *op)
+{
+	struct udevice *bus = slave->dev->parent;
+	struct dw_qspi_priv *priv = dev_get_priv(bus);
+	unsigned int frame_bytes, nframes, nstart;
+	u32 cr0, spi_cr0, val;
+	int ret, tret;
+
+	if (!dw_qspi_mem_is_enhanced(op))
+		return -ENOTSUPP;
+
+	if (op->data.dir == SPI_MEM_DATA_IN && !(op->data.nbytes % 4))
+		frame_bytes = 4;
+	else
+		frame_bytes = 1;
+	nframes = op->data.nbytes / frame_bytes;
+	if (nframes > DW_QSPI_MAX_NDF)
+		return -EINVAL;
+
+	cr0 = (frame_bytes * 8 - 1) << SPI_DFS_OFFSET |
+		(SPI_FRF_SPI << SPI_FRF_OFFSET) |
+		(priv->mode << SPI_MODE_OFFSET) |
+		((op->data.buswidth == 4 ? SPI_SPI_FRF_QUAD : SPI_SPI_FRF_DUAL)
+		 << SPI_SPI_FRF_OFFSET);
+	if (op->data.dir == SPI_MEM_DATA_IN)
+		cr0 |= SPI_TMOD_RO << SPI_TMOD_OFFSET;
+	else
+		cr0 |= SPI_TMOD_TO << SPI_TMOD_OFFSET;
+
+	spi_cr0 = (SPI_INST_L_8 << SPI_INST_L_OFFSET) |
+		(op->addr.nbytes * 2) << SPI_ADDR_L_OFFSET |
+		SPI_CLK_STRETCH_EN;
+	if (op->addr.nbytes && op->addr.buswidth > 1)
+		spi_cr0 |= SPI_TRANS_TYPE_TT1 << SPI_TRANS_TYPE_OFFSET;
+	else
+		spi_cr0 |= SPI_TRANS_TYPE_TT0 << SPI_TRANS_TYPE_OFFSET;
+	if (op->dummy.nbytes)
+		spi_cr0 |= (op->dummy.nbytes * 8 / op->dummy.buswidth) <<
+			SPI_WAIT_CYCLES_OFFSET;
+
+	/*
+	 * Hold off the transfer until the opcode and address (and for
+	 * writes as much data as fits) have been queued.
+	 */
+	nstart = op->addr.nbytes ? 2 : 1;
+	if (op->data.dir == SPI_MEM_DATA_OUT)
+		nstart = min(priv->fifo_len, nstart + nframes);
+
+	spi_enable_chip(priv, 0);
+	dw_write(priv, DW_QSPI_CTRL0, cr0);
+	dw_write(priv, DW_QSPI_CTRL1, nframes - 1);
+	dw_write(priv, DW_QSPI_SPI_CTRL0, spi_cr0);
+	/* The FIFO is drained by the CPU, keep DMA handshaking off */
+	dw_write(priv, DW_QSPI_DMACR, 0);
+	dw_write(priv, DW_QSPI_TXFLTR, (nstart - 1) << SPI_TXFTHR_OFFSET);
+	spi_enable_chip(priv, 1);
+
+	debug("%s: op %02x addr %llx len %u cr0=%08x spi_cr0=%08x\n",
+	      __func__, op->cmd.opcode, op->addr.val, op->data.nbytes,
+	      cr0, spi_cr0);
+
+	external_cs_manage(slave->dev, false);
+
+	dw_write(priv, DW_QSPI_DR, op->cmd.opcode);
+	if (op->addr.nbytes)
+		dw_write(priv, DW_QSPI_DR, op->addr.val);
+
+	if (op->data.dir == SPI_MEM_DATA_IN)
+		ret = dw_qspi_mem_read(priv, op->data.buf.in,
+				       op->data.nbytes, frame_bytes);
+	else
+		ret = dw_qspi_mem_write(priv, op->data.buf.out,
+					op->data.nbytes);
+
+	tret = readl_poll_timeout(priv->regs + DW_QSPI_SR, val,
+				  (val & SR_TF_EMPT) && !(val & SR_BUSY),
+				  RX_TIMEOUT * 1000);
+
+	external_cs_manage(slave->dev, true);
+
+	if (ret || tret) {
+		debug("%s: op %02x timed out\n", __func__, op->cmd.opcode);
+		return -ETIMEDOUT;
+	}
+
+	return 0;
+}
+
+static const struct spi_controller_mem_ops dw_qspi_mem_ops = {
+	.adjust_op_size	= dw_qspi_adjust_op_size,
+	.supports_op	= dw_qspi_supports_op,
+	.exec_op	= dw_qspi_exec_op,
+};
+
 static int dw_qspi_set_speed(struct udevice *bus, uint speed)
 {
 	struct dw_qspi_platdata *plat = bus->platdata;
@@ -570,7 +827,8 @@ static int dw_qspi_set_mode(struct udevice *bus, uint mode)
 	 * rx & tx is requested. So we have to defer this to the
 	 * real transfer function.
 	 */
-	priv->mode = mode;
+	/* Bus widths are per operation, CTRLR0 only takes CPOL/CPHA */
+	priv->mode = mode & (SPI_CPOL | SPI_CPHA);
 	debug("%s: regs=%p, mode=%d\n", __func__, priv->regs, priv->mode);
 
 	return 0;
@@ -587,6 +845,7 @@ static const struct dm_spi_ops dw_qspi_ops = {
 	.xfer		= dw_qspi_xfer,
 	.set_speed	= dw_qspi_set_speed,
 	.set_mode	= dw_qspi_set_mode,
+	.mem_ops	= &dw_qspi_mem_ops,
 	/*
 	 * cs_info is not needed, since we require all chip selects to be
 	 * in the device tree explicitly
@@ -599,7 +858,11 @@ static const struct udevice_id dw_qspi_ids[] = {
 };
 
 U_BOOT_DRIVER(dw_qspi) = {
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+	.name = "snps_dw_ahb_ssi",
+#else
 	.name = "dw_qspi",
+#endif
 	.id = UCLASS_SPI,
 	.of_match = dw_qspi_ids,
 	.ops = &dw_qspi_ops,
@@ -18,6 +18,7 @@
 #include <linux/usb/gadget.h>
 #include <linux/usb/composite.h>
 #include <linux/compiler.h>
+#include <fastboot-internal.h>
 #include <g_dnl.h>
 
 #define FASTBOOT_INTERFACE_CLASS	0xff
@@ -35,12 +36,23 @@
  * that expect bulk OUT requests to be divisible by maxpacket size.
  */
 
+/*
+ * Downloads are received straight into the fastboot buffer by DL_REQS
+ * requests of CONFIG_FASTBOOT_USB_DL_CHUNK_SIZE bytes, each one queued
+ * again for the next chunk as soon as it completes.
+ */
+#define DL_REQS				2
+
 struct f_fastboot {
 	struct usb_function usb_function;
 
 	/* IN/OUT EP's and corresponding requests */
 	struct usb_ep *in_ep, *out_ep;
 	struct usb_request *in_req, *out_req;
+
+	/* OUT requests for downloads, the next offset and the total size */
+	struct usb_request *dl_req[DL_REQS];
+	unsigned int dl_next, dl_size;
 };
 
 static inline struct f_fastboot *func_to_fastboot(struct usb_function *f)
@@ -199,6 +211,42 @@ static void fastboot_unbind(struct usb_configuration *c, struct usb_function *f)
 	memset(fastboot_func, 0, sizeof(*fastboot_func));
 }
 
+static void rx_handler_dl_direct(struct usb_ep *ep, struct usb_request *req);
+
+static void fastboot_free_dl_reqs(struct f_fastboot *f_fb)
+{
+	int i;
+
+	for (i = 0; i < DL_REQS; i++) {
+		if (f_fb->dl_req[i]) {
+			usb_ep_free_request(f_fb->out_ep, f_fb->dl_req[i]);
+			f_fb->dl_req[i] = NULL;
+		}
+	}
+}
+
+/*
+ * Allocate the download requests. Their buffers point into the fastboot
+ * buffer, so none is allocated here. Without them, downloads go through
+ * out_req and are copied.
+ */
+static void fastboot_alloc_dl_reqs(struct f_fastboot *f_fb)
+{
+	int i;
+
+	if (!CONFIG_FASTBOOT_USB_DL_CHUNK_SIZE)
+		return;
+
+	for (i = 0; i < DL_REQS; i++) {
+		f_fb->dl_req[i] = usb_ep_alloc_request(f_fb->out_ep, 0);
+		if (!f_fb->dl_req[i]) {
+			fastboot_free_dl_reqs(f_fb);
+			return;
+		}
+		f_fb->dl_req[i]->complete = rx_handler_dl_direct;
+	}
+}
+
 static void fastboot_disable(struct usb_function *f)
 {
 	struct f_fastboot *f_fb = func_to_fastboot(f);
@@ -216,6 +264,7 @@ static void fastboot_disable(struct usb_function *f)
 		usb_ep_free_request(f_fb->in_ep, f_fb->in_req);
 		f_fb->in_req = NULL;
 	}
+	fastboot_free_dl_reqs(f_fb);
 }
 
 static struct usb_request *fastboot_start_ep(struct usb_ep *ep)
@@ -263,6 +312,7 @@ static int fastboot_set_alt(struct usb_function *f,
 		goto err;
 	}
 	f_fb->out_req->complete = rx_handler_command;
+	fastboot_alloc_dl_reqs(f_fb);
 
 	d = fb_ep_desc(gadget, &fs_ep_in, &hs_ep_in);
 	ret = usb_ep_enable(f_fb->in_ep, d);
@@ -409,6 +459,109 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 	usb_ep_queue(ep, req, 0);
 }
 
+/* Queue @req to receive the next chunk of the download, if any is left */
+static void fastboot_dl_queue(struct usb_ep *ep, struct usb_request *req)
+{
+	struct f_fastboot *f_fb = fastboot_func;
+	unsigned int len = f_fb->dl_size - f_fb->dl_next;
+	unsigned int offset = f_fb->dl_next % fastboot_buf_size;
+	unsigned int maxpacket = ep->maxpacket;
+
+	if (!len)
+		return;
+	if (len > CONFIG_FASTBOOT_USB_DL_CHUNK_SIZE)
+		len = CONFIG_FASTBOOT_USB_DL_CHUNK_SIZE;
+	/* a download written out as it arrives wraps around the buffer */
+	if (len > fastboot_buf_size - offset)
+		len = fastboot_buf_size - offset;
+
+	req->buf = fastboot_buf_addr + offset;
+	/* see rx_bytes_expected() */
+	req->length = roundup(len, maxpacket);
+	req->actual = 0;
+	f_fb->dl_next += len;
+
+	/* context marks the request as queued */
+	req->context = f_fb;
+	if (usb_ep_queue(ep, req, 0))
+		req->context = NULL;
+}
+
+/* Whether the download can be received straight into the fastboot buffer */
+static bool fastboot_dl_direct(void)
+{
+	return fastboot_func->dl_req[0] &&
+	       IS_ALIGNED((ulong)fastboot_buf_addr,
+			  CONFIG_SYS_CACHELINE_SIZE);
+}
+
+static void fastboot_dl_start(struct usb_ep *ep)
+{
+	struct f_fastboot *f_fb = fastboot_func;
+	int i;
+
+	f_fb->dl_next = 0;
+	f_fb->dl_size = fastboot_data_remaining();
+	for (i = 0; i < DL_REQS; i++)
+		fastboot_dl_queue(ep, f_fb->dl_req[i]);
+}
+
+/* Cancel the download requests and wait for a command again */
+static void fastboot_dl_end(struct usb_ep *ep)
+{
+	struct f_fastboot *f_fb = fastboot_func;
+	struct usb_request *req = f_fb->out_req;
+	int i;
+
+	f_fb->dl_next = f_fb->dl_size;
+	for (i = 0; i < DL_REQS; i++)
+		if (f_fb->dl_req[i]->context)
+			usb_ep_dequeue(ep, f_fb->dl_req[i]);
+
+	req->complete = rx_handler_command;
+	req->length = EP_BUFFER_SIZE;
+	req->actual = 0;
+	usb_ep_queue(ep, req, 0);
+}
+
+static void rx_handler_dl_direct(struct usb_ep *ep, struct usb_request *req)
+{
+	char response[FASTBOOT_RESPONSE_LEN] = { 0 };
+	unsigned int remaining = fastboot_data_remaining();
+	unsigned int len = min(req->actual, remaining);
+
+	req->context = NULL;
+
+	/* cancelled by fastboot_dl_end() or the controller */
+	if (req->status != 0) {
+		if (req->status != -ECONNRESET)
+			printf("Bad status: %d\n", req->status);
+		return;
+	}
+
+	/*
+	 * The following chunk has been queued at the offset after this one,
+	 * so a short transfer can only end the download.
+	 */
+	if (req->actual < req->length && len < remaining) {
+		pr_err("short transfer of %u bytes\n", req->actual);
+		fastboot_fail("short transfer", response);
+	} else {
+		fastboot_data_received(len, response);
+	}
+
+	if (response[0]) {
+		fastboot_dl_end(ep);
+		fastboot_tx_write_str(response);
+	} else if (!fastboot_data_remaining()) {
+		fastboot_data_complete(response);
+		fastboot_dl_end(ep);
+		fastboot_tx_write_str(response);
+	} else {
+		fastboot_dl_queue(ep, req);
+	}
+}
+
 static void do_exit_on_complete(struct usb_ep *ep, struct usb_request *req)
 {
 	g_dnl_trigger_detach();
@@ -442,6 +595,7 @@ static void rx_handler_command(struct usb_ep *ep, struct usb_request *req)
 	char response[FASTBOOT_RESPONSE_LEN] = { 0 };
 	int cmd = -1;
 	void *download_addr = 0;
+	bool direct = false;
 
 	if (req->status != 0 || req->length == 0)
 		return;
@@ -465,8 +619,12 @@ static void rx_handler_command(struct usb_ep *ep, struct usb_request *req)
 	}
 
 	if (!strncmp("DATA", response, 4)) {
-		req->complete = rx_handler_dl_image;
-		req->length = rx_bytes_expected(ep);
+		if (fastboot_dl_direct()) {
+			direct = true;
+		} else {
+			req->complete = rx_handler_dl_image;
+			req->length = rx_bytes_expected(ep);
+		}
 	}
 
 	fastboot_tx_write_str(response);
@@ -490,5 +648,9 @@ static void rx_handler_command(struct usb_ep *ep, struct usb_request *req)
 
 	*cmdbuf = '\0';
 	req->actual = 0;
-	usb_ep_queue(ep, req, 0);
+	/* out_req is queued again once the download is complete */
+	if (direct)
+		fastboot_dl_start(ep);
+	else
+		usb_ep_queue(ep, req, 0);
 }
@@ -191,7 +191,13 @@ static inline int write_env(struct mmc *mmc, unsigned long size,
 	blk_start	= ALIGN(offset, mmc->write_bl_len) / mmc->write_bl_len;
 	blk_cnt		= ALIGN(size, mmc->write_bl_len) / mmc->write_bl_len;
 
+	/* A torn environment is lost, so ask for an atomic write */
+	mmc->reliable_write = true;
 	n = blk_dwrite(desc, blk_start, blk_cnt, (u_char *)buffer);
+	mmc->reliable_write = false;
+	if (CONFIG_IS_ENABLED(MMC_WRITE) && n == blk_cnt &&
+	    mmc_flush_cache(mmc))
+		n = 0;
 
 	return (n == blk_cnt) ? 0 : -1;
 }
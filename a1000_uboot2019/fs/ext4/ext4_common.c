@@ -1521,8 +1521,42 @@ void ext4fs_allocate_blocks(struct ext2_inode *file_inode,
 
 #endif
 
+void ext_cache_init(struct ext_block_cache *cache)
+{
+	memset(cache, 0, sizeof(*cache));
+}
+
+void ext_cache_fini(struct ext_block_cache *cache)
+{
+	free(cache->buf);
+	ext_cache_init(cache);
+}
+
+/* Read @block into the cache buffer unless it is there already */
+int ext_cache_read(struct ext_block_cache *cache, lbaint_t block, int size)
+{
+	if (cache->buf && cache->block == block && cache->size == size)
+		return 1;
+
+	if (cache->size != size) {
+		ext_cache_fini(cache);
+		cache->buf = memalign(ARCH_DMA_MINALIGN, size);
+		if (!cache->buf)
+			return 0;
+		cache->size = size;
+	}
+
+	if (!ext4fs_devread(block, 0, size, cache->buf)) {
+		ext_cache_fini(cache);
+		return 0;
+	}
+	cache->block = block;
+
+	return 1;
+}
+
 static struct ext4_extent_header *ext4fs_get_extent_block
-	(struct ext2_data *data, char *buf,
+	(struct ext2_data *data, struct ext_block_cache *cache,
 		struct ext4_extent_header *ext_block,
 		uint32_t fileblock, int log2_blksz)
 {
@@ -1552,14 +1586,69 @@ static struct ext4_extent_header *ext4fs_get_extent_block
 		block = le16_to_cpu(index[i].ei_leaf_hi);
 		block = (block << 32) + le32_to_cpu(index[i].ei_leaf_lo);
 
-		if (ext4fs_devread((lbaint_t)block << log2_blksz, 0, blksz,
-				   buf))
-			ext_block = (struct ext4_extent_header *)buf;
+		if (ext_cache_read(cache, (lbaint_t)block << log2_blksz, blksz))
+			ext_block = (struct ext4_extent_header *)cache->buf;
 		else
 			return NULL;
 	}
 }
 
+/*
+ * Map @fileblock of an extent-mapped inode, recording in @map the whole
+ * extent (or hole) it belongs to.
+ */
+static long int ext4fs_map_extent(struct ext2_inode *inode, int fileblock,
+				  struct ext2fs_block_map *map,
+				  struct ext_block_cache *cache)
+{
+	struct ext4_extent_header *ext_block;
+	struct ext4_extent *extent;
+	long int startblock, endblock;
+	unsigned long long start;
+	int log2_blksz;
+	int i;
+
+	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
+		- get_fs()->dev_desc->log2blksz;
+
+	ext_block = ext4fs_get_extent_block(ext4fs_root, cache,
+					    (struct ext4_extent_header *)
+					    inode->b.blocks.dir_blocks,
+					    fileblock, log2_blksz);
+	if (!ext_block) {
+		printf("invalid extent block\n");
+		return -EINVAL;
+	}
+
+	extent = (struct ext4_extent *)(ext_block + 1);
+
+	/* Past the last extent of this leaf: a one block hole */
+	map->fileblock = fileblock;
+	map->len = 1;
+	map->start = 0;
+
+	for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
+		startblock = le32_to_cpu(extent[i].ee_block);
+		endblock = startblock + le16_to_cpu(extent[i].ee_len);
+
+		if (startblock > fileblock) {
+			/* Sparse file */
+			map->len = startblock - fileblock;
+			break;
+		} else if (fileblock < endblock) {
+			start = le16_to_cpu(extent[i].ee_start_hi);
+			start = (start << 32) +
+				le32_to_cpu(extent[i].ee_start_lo);
+			map->fileblock = startblock;
+			map->len = endblock - startblock;
+			map->start = start;
+			break;
+		}
+	}
+
+	return map->start ? map->start + (fileblock - map->fileblock) : 0;
+}
+
 static int ext4fs_blockgroup
 	(struct ext2_data *data, int group, struct ext2_block_group *blkgrp)
 {
@@ -1614,6 +1703,27 @@ int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
 }
 
 long int read_allocated_block(struct ext2_inode *inode, int fileblock)
+{
+	struct ext2fs_block_map map;
+	struct ext_block_cache cache;
+	long int blknr;
+
+	map.len = 0;
+	ext_cache_init(&cache);
+	blknr = read_allocated_blocks(inode, fileblock, &map, &cache);
+	ext_cache_fini(&cache);
+
+	return blknr;
+}
+
+/*
+ * Like read_allocated_block(), but also describe in @map the run of
+ * contiguous blocks @fileblock is part of. If @fileblock already lies
+ * in @map, it is resolved from there without touching the disk.
+ */
+long int read_allocated_blocks(struct ext2_inode *inode, int fileblock,
+			       struct ext2fs_block_map *map,
+			       struct ext_block_cache *cache)
 {
 	long int blknr;
 	int blksz;
@@ -1622,55 +1732,20 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 	long int rblock;
 	long int perblock_parent;
 	long int perblock_child;
-	unsigned long long start;
+
+	if (map->len && fileblock >= map->fileblock &&
+	    fileblock - map->fileblock < map->len)
+		return map->start ?
+			map->start + (fileblock - map->fileblock) : 0;
+
+	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL)
+		return ext4fs_map_extent(inode, fileblock, map, cache);
+
 	/* get the blocksize of the filesystem */
 	blksz = EXT2_BLOCK_SIZE(ext4fs_root);
 	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
 		- get_fs()->dev_desc->log2blksz;
 
-	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
-		long int startblock, endblock;
-		char *buf = zalloc(blksz);
-		if (!buf)
-			return -ENOMEM;
-		struct ext4_extent_header *ext_block;
-		struct ext4_extent *extent;
-		int i;
-		ext_block =
-			ext4fs_get_extent_block(ext4fs_root, buf,
-						(struct ext4_extent_header *)
-						inode->b.blocks.dir_blocks,
-						fileblock, log2_blksz);
-		if (!ext_block) {
-			printf("invalid extent block\n");
-			free(buf);
-			return -EINVAL;
-		}
-
-		extent = (struct ext4_extent *)(ext_block + 1);
-
-		for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
-			startblock = le32_to_cpu(extent[i].ee_block);
-			endblock = startblock + le16_to_cpu(extent[i].ee_len);
-
-			if (startblock > fileblock) {
-				/* Sparse file */
-				free(buf);
-				return 0;
-
-			} else if (fileblock < endblock) {
-				start = le16_to_cpu(extent[i].ee_start_hi);
-				start = (start << 32) +
-					le32_to_cpu(extent[i].ee_start_lo);
-				free(buf);
-				return (fileblock - startblock) + start;
-			}
-		}
-
-		free(buf);
-		return 0;
-	}
-
 	/* Direct blocks. */
 	if (fileblock < INDIRECT_BLOCKS)
 		blknr = le32_to_cpu(inode->b.blocks.dir_blocks[fileblock]);
@@ -1953,6 +2028,10 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 	}
 	debug("read_allocated_block %ld\n", blknr);
 
+	map->fileblock = fileblock;
+	map->len = 1;
+	map->start = blknr;
+
 	return blknr;
 }
 
@@ -47,6 +47,20 @@ static inline void *zalloc(size_t size)
 	return p;
 }
 
+/* A buffer holding the last extent tree block read */
+struct ext_block_cache {
+	char *buf;
+	lbaint_t block;
+	int size;
+};
+
+void ext_cache_init(struct ext_block_cache *cache);
+void ext_cache_fini(struct ext_block_cache *cache);
+int ext_cache_read(struct ext_block_cache *cache, lbaint_t block, int size);
+
+long int read_allocated_blocks(struct ext2_inode *inode, int fileblock,
+			       struct ext2fs_block_map *map,
+			       struct ext_block_cache *cache);
 int ext4fs_read_inode(struct ext2_data *data, int ino,
 		      struct ext2_inode *inode);
 int ext4fs_read_file(struct ext2fs_node *node, loff_t pos, loff_t len,
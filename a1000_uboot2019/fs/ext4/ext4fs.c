@@ -44,12 +44,16 @@ void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot)
  * Taken from openmoko-kernel mailing list: By Andy green
  * Optimized read file API : collects and defers contiguous sector
  * reads into one potentially more efficient larger sequential read action
+ *
+ * Blocks are looked up a run at a time (a whole extent for extent-mapped
+ * inodes), the last run being kept in the node for the next read.
  */
 int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		loff_t len, char *buf, loff_t *actread)
 {
 	struct ext_filesystem *fs = get_fs();
-	int i;
+	struct ext_block_cache cache;
+	int i, blkcnt;
 	lbaint_t blockcnt;
 	int log2blksz = fs->dev_desc->log2blksz;
 	int log2_fs_blocksize = LOG2_BLOCK_SIZE(node->data) - log2blksz;
@@ -61,7 +65,8 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 	lbaint_t delayed_skipfirst = 0;
 	lbaint_t delayed_next = 0;
 	char *delayed_buf = NULL;
-	short status;
+	int status;
+	int ret = -1;
 
 	if (blocksize <= 0)
 		return -1;
@@ -72,25 +77,30 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 
 	blockcnt = lldiv(((len + pos) + blocksize - 1), blocksize);
 
-	for (i = lldiv(pos, blocksize); i < blockcnt; i++) {
+	ext_cache_init(&cache);
+
+	for (i = lldiv(pos, blocksize); i < blockcnt; i += blkcnt) {
 		long int blknr;
 		int blockoff = pos - (blocksize * i);
-		int blockend = blocksize;
+		loff_t blockend;
 		int skipfirst = 0;
-		blknr = read_allocated_block(&(node->inode), i);
+
+		blknr = read_allocated_blocks(&node->inode, i, &node->map,
+					      &cache);
 		if (blknr < 0)
-			return -1;
+			goto out;
+
+		/* Blocks of the run from here on, within the read */
+		blkcnt = node->map.len - (i - node->map.fileblock);
+		if (blkcnt > blockcnt - i)
+			blkcnt = blockcnt - i;
+		blockend = (loff_t)blkcnt * blocksize;
 
 		blknr = blknr << log2_fs_blocksize;
 
 		/* Last block.  */
-		if (i == blockcnt - 1) {
-			blockend = (len + pos) - (blocksize * i);
-
-			/* The last portion is exactly blocksize. */
-			if (!blockend)
-				blockend = blocksize;
-		}
+		if (i + blkcnt == blockcnt)
+			blockend = (len + pos) - ((loff_t)blocksize * i);
 
 		/* First block. */
 		if (i == lldiv(pos, blocksize)) {
@@ -98,38 +108,30 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 			blockend -= skipfirst;
 		}
 		if (blknr) {
-			int status;
-
-			if (previous_block_number != -1) {
-				if (delayed_next == blknr) {
-					delayed_extent += blockend;
-					delayed_next += blockend >> log2blksz;
-				} else {	/* spill */
+			if (previous_block_number != -1 &&
+			    delayed_next == blknr) {
+				delayed_extent += blockend;
+				delayed_next += (lbaint_t)blkcnt <<
+					log2_fs_blocksize;
+			} else {
+				if (previous_block_number != -1) {
+					/* spill */
 					status = ext4fs_devread(delayed_start,
 							delayed_skipfirst,
 							delayed_extent,
 							delayed_buf);
 					if (status == 0)
-						return -1;
-					previous_block_number = blknr;
-					delayed_start = blknr;
-					delayed_extent = blockend;
-					delayed_skipfirst = skipfirst;
-					delayed_buf = buf;
-					delayed_next = blknr +
-						(blockend >> log2blksz);
+						goto out;
 				}
-			} else {
 				previous_block_number = blknr;
 				delayed_start = blknr;
 				delayed_extent = blockend;
 				delayed_skipfirst = skipfirst;
 				delayed_buf = buf;
 				delayed_next = blknr +
-					(blockend >> log2blksz);
+					((lbaint_t)blkcnt << log2_fs_blocksize);
 			}
 		} else {
-			int n;
 			if (previous_block_number != -1) {
 				/* spill */
 				status = ext4fs_devread(delayed_start,
@@ -137,16 +139,13 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 							delayed_extent,
 							delayed_buf);
 				if (status == 0)
-					return -1;
+					goto out;
 				previous_block_number = -1;
 			}
-			/* Zero no more than `len' bytes. */
-			n = blocksize - skipfirst;
-			if (n > len)
-				n = len;
-			memset(buf, 0, n);
+			/* Zero the hole */
+			memset(buf, 0, blockend);
 		}
-		buf += blocksize - skipfirst;
+		buf += blockend;
 	}
 	if (previous_block_number != -1) {
 		/* spill */
@@ -154,12 +153,16 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 					delayed_skipfirst, delayed_extent,
 					delayed_buf);
 		if (status == 0)
-			return -1;
+			goto out;
 		previous_block_number = -1;
 	}
 
 	*actread  = len;
-	return 0;
+	ret = 0;
+out:
+	ext_cache_fini(&cache);
+
+	return ret;
 }
 
 int ext4fs_ls(const char *dirname)
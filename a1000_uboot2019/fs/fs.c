@@ -6,6 +6,10 @@
 #include <config.h>
 #include <errno.h>
 #include <common.h>
+#include <bootstage.h>
+#include <decomp_stream.h>
+#include <image.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <part.h>
 #include <ext4fs.h>
@@ -621,6 +625,113 @@ int do_size(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(DECOMP_STREAM)
+#ifndef CONFIG_SYS_BOOTM_LEN
+/* use 8MByte as default max decompressed size, as bootm does */
+#define CONFIG_SYS_BOOTM_LEN	0x800000
+#endif
+
+/*
+ * Read a file in pieces and decompress each piece before reading the next,
+ * straight to @addr. The compressed file is never stored in full. The
+ * device must have been selected with fs_set_blk_dev().
+ */
+static int fs_load_decomp(const char *ifname, const char *dev_part_str,
+			  int fstype, const char *filename, ulong addr,
+			  loff_t max, loff_t pos, loff_t *len_read,
+			  size_t *len_out, ulong *read_time)
+{
+	struct decomp_stream ds;
+	loff_t size, len, actread;
+	bool started = false;
+	ulong time;
+	void *buf;
+	int ret;
+
+	ret = fs_size(filename, &size);
+	if (ret)
+		return ret;
+	buf = malloc(CONFIG_DECOMP_STREAM_CHUNK);
+	if (!buf)
+		return -ENOMEM;
+
+	*len_read = 0;
+	*read_time = 0;
+	while (pos < size) {
+		/* each access closes the filesystem */
+		ret = fs_set_blk_dev(ifname, dev_part_str, fstype);
+		if (ret)
+			break;
+		len = min_t(loff_t, size - pos, CONFIG_DECOMP_STREAM_CHUNK);
+		time = get_timer(0);
+		bootstage_start(BOOTSTAGE_ID_ACCUM_LOAD, "load");
+		ret = fs_read(filename, map_to_sysmem(buf), pos, len, &actread);
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_LOAD);
+		*read_time += get_timer(time);
+		if (!ret && !actread)
+			ret = -EIO;
+		if (ret)
+			break;
+		pos += actread;
+		*len_read += actread;
+
+		if (!started) {
+			ret = decomp_stream_init(&ds,
+					decomp_stream_detect(buf, actread),
+					map_sysmem(addr, max), max);
+			if (ret)
+				break;
+			started = true;
+		}
+		bootstage_start(BOOTSTAGE_ID_ACCUM_DECOMP, "decompress");
+		ret = decomp_stream_write(&ds, buf, actread);
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_DECOMP);
+		if (ret || ds.done)
+			break;
+	}
+	if (started) {
+		int err = decomp_stream_finish(&ds);
+
+		if (!ret)
+			ret = err;
+		*len_out = ds.out;
+		unmap_sysmem(ds.dst);
+	}
+	free(buf);
+
+	return ret;
+}
+
+static int do_load_decomp(const char *ifname, const char *dev_part_str,
+			  int fstype, const char *filename, ulong addr,
+			  loff_t max, loff_t pos)
+{
+	loff_t len_read;
+	size_t len_out = 0;
+	ulong time, read_time;
+	int ret;
+
+	if (!max)
+		max = CONFIG_SYS_BOOTM_LEN;
+	time = get_timer(0);
+	ret = fs_load_decomp(ifname, dev_part_str, fstype, filename, addr,
+			     max, pos, &len_read, &len_out, &read_time);
+	time = get_timer(time);
+	if (ret) {
+		printf("** Decompressing %s failed: %d **\n", filename, ret);
+		return 1;
+	}
+
+	printf("%llu bytes read, %zu bytes decompressed in %lu ms "
+	       "(%lu ms reading)\n", len_read, len_out, time, read_time);
+	flush_cache(addr, len_out);
+	env_set_hex("fileaddr", addr);
+	env_set_hex("filesize", len_out);
+
+	return 0;
+}
+#endif
+
 int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 		int fstype)
 {
@@ -633,7 +744,14 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	int ret;
 	unsigned long time;
 	char *ep;
+	bool decomp = false;
 
+	if (CONFIG_IS_ENABLED(DECOMP_STREAM) && argc >= 2 &&
+	    !strcmp(argv[1], "-d")) {
+		decomp = true;
+		argc--;
+		argv++;
+	}
 	if (argc < 2)
 		return CMD_RET_USAGE;
 	if (argc > 7)
@@ -671,6 +789,12 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	else
 		pos = 0;
 
+#if CONFIG_IS_ENABLED(DECOMP_STREAM)
+	if (decomp)
+		return do_load_decomp(argv[1], (argc >= 3) ? argv[2] : NULL,
+				      fstype, filename, addr, bytes, pos);
+#endif
+
 	time = get_timer(0);
 	ret = _fs_read(filename, addr, pos, bytes, 1, &len_read);
 	time = get_timer(time);
@@ -7,8 +7,41 @@
 
 #include <common.h>
 #include <compiler.h>
+#include <errno.h>
 #include <part.h>
+#include <malloc.h>
 #include <memalign.h>
+#include <linux/sizes.h>
+
+#define FS_DEVREAD_BOUNCE_SIZE	SZ_1M
+
+static int fs_devread_bounce(struct blk_desc *blk, lbaint_t start,
+			     lbaint_t blkcnt, char *buf)
+{
+	lbaint_t max = FS_DEVREAD_BOUNCE_SIZE >> blk->log2blksz;
+	lbaint_t n = min(blkcnt, max);
+	void *bounce;
+	int ret = 0;
+
+	bounce = memalign(ARCH_DMA_MINALIGN, n << blk->log2blksz);
+	if (!bounce)
+		return -ENOMEM;
+
+	while (blkcnt) {
+		n = min(blkcnt, max);
+		if (blk_dread(blk, start, n, bounce) != n) {
+			ret = -EIO;
+			break;
+		}
+		memcpy(buf, bounce, n << blk->log2blksz);
+		buf += n << blk->log2blksz;
+		start += n;
+		blkcnt -= n;
+	}
+	free(bounce);
+
+	return ret;
+}
 
 int fs_devread(struct blk_desc *blk, disk_partition_t *partition,
 	       lbaint_t sector, int byte_offset, int byte_len, char *buf)
@@ -68,15 +101,22 @@ int fs_devread(struct blk_desc *blk, disk_partition_t *partition,
 		return 1;
 	}
 
-	ALLOC_CACHE_ALIGN_BUFFER(u8, continuous_data, block_len);
-	if (blk_dread(blk, partition->start + sector,
-		block_len >> log2blksz, (void *)continuous_data) !=
-		block_len >> log2blksz) {
+	/*
+	 * Read straight into the caller's buffer when it is aligned for
+	 * DMA, otherwise bounce through a bounded heap buffer.
+	 */
+	if (!((ulong)buf & (ARCH_DMA_MINALIGN - 1))) {
+		if (blk_dread(blk, partition->start + sector,
+			      block_len >> log2blksz, (void *)buf) !=
+		    block_len >> log2blksz) {
+			printf(" ** %s read error - block\n", __func__);
+			return 0;
+		}
+	} else if (fs_devread_bounce(blk, partition->start + sector,
+				     block_len >> log2blksz, buf)) {
 		printf(" ** %s read error - block\n", __func__);
 		return 0;
 	}
-	memcpy(buf, continuous_data, block_len);
-	block_len = byte_len & ~(blk->blksz - 1);
 	buf += block_len;
 	byte_len -= block_len;
 	sector += block_len / blk->blksz;
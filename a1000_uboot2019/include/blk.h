@@ -118,6 +118,7 @@ struct blk_desc {
  *
  * @param iftype - IF_TYPE_x for type of device
  * @param dev - device index of particular type
+ * @param hwpart - hardware partition the blocks belong to
  * @param start - starting block number
  * @param blkcnt - number of blocks to read
  * @param blksz - size in bytes of each block
@@ -125,7 +126,7 @@ struct blk_desc {
  *
  * @return - '1' if block returned from cache, '0' otherwise.
  */
-int blkcache_read(int iftype, int dev,
+int blkcache_read(int iftype, int dev, int hwpart,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer);
 
@@ -135,19 +136,71 @@ int blkcache_read(int iftype, int dev,
  *
  * @param iftype - IF_TYPE_x for type of device
  * @param dev - device index of particular type
+ * @param hwpart - hardware partition the blocks belong to
  * @param start - starting block number
  * @param blkcnt - number of blocks available
  * @param blksz - size in bytes of each block
  * @param buf - buffer containing data to cache
  *
  */
-void blkcache_fill(int iftype, int dev,
+void blkcache_fill(int iftype, int dev, int hwpart,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer);
 
 /**
- * blkcache_invalidate() - discard the cache for a set of blocks
- * because of a write or device (re)initialization.
+ * blkcache_readahead() - decide how many blocks to read on a cache miss
+ *
+ * Small reads that continue where the previous read on the same device
+ * ended are extended up to CONFIG_BLOCK_CACHE_READAHEAD blocks, so that
+ * the following reads of a sequential scan hit the cache.
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ * @param start - starting block number
+ * @param blkcnt - number of blocks requested
+ * @param blksz - size in bytes of each block
+ *
+ * @return - number of blocks to read from the device, at least @blkcnt
+ */
+lbaint_t blkcache_readahead(int iftype, int dev,
+			    lbaint_t start, lbaint_t blkcnt,
+			    unsigned long blksz);
+
+/**
+ * blkcache_write() - update cached blocks with data written to the device
+ *
+ * Only blocks which are already cached are updated.
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ * @param hwpart - hardware partition the blocks belong to
+ * @param start - starting block number
+ * @param blkcnt - number of blocks written
+ * @param blksz - size in bytes of each block
+ * @param buf - buffer containing the data written
+ */
+void blkcache_write(int iftype, int dev, int hwpart,
+		    lbaint_t start, lbaint_t blkcnt,
+		    unsigned long blksz, void const *buffer);
+
+/**
+ * blkcache_invalidate_range() - discard the cache for a set of blocks
+ * because of a failed write or an erase.
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ * @param hwpart - hardware partition the blocks belong to
+ * @param start - starting block number
+ * @param blkcnt - number of blocks
+ * @param blksz - size in bytes of each block
+ */
+void blkcache_invalidate_range(int iftype, int dev, int hwpart,
+			       lbaint_t start, lbaint_t blkcnt,
+			       unsigned long blksz);
+
+/**
+ * blkcache_invalidate() - discard the cache for a whole device, all of
+ * its hardware partitions, because of device (re)initialization.
  *
  * @param iftype - IF_TYPE_x for type of device
  * @param dev - device index of particular type
@@ -157,10 +210,10 @@ void blkcache_invalidate(int iftype, int dev);
 /**
  * blkcache_configure() - configure block cache
  *
- * @param blocks - maximum blocks per entry
- * @param entries - maximum entries in cache
+ * @param blocks - maximum blocks per read to cache
+ * @param bytes - maximum size of the cache in bytes
  */
-void blkcache_configure(unsigned blocks, unsigned entries);
+void blkcache_configure(unsigned blocks, unsigned long bytes);
 
 /*
  * statistics of the block cache
@@ -168,9 +221,12 @@ void blkcache_configure(unsigned blocks, unsigned entries);
 struct block_cache_stats {
 	unsigned hits;
 	unsigned misses;
-	unsigned entries; /* current entry count */
-	unsigned max_blocks_per_entry;
-	unsigned max_entries;
+	unsigned readaheads;
+	unsigned entries; /* current page count */
+	unsigned max_blocks;
+	unsigned long bytes; /* current size */
+	unsigned long max_bytes;
+	u64 bytes_saved; /* bytes read from cache instead of the device */
 };
 
 /**
@@ -182,17 +238,33 @@ void blkcache_stats(struct block_cache_stats *stats);
 
 #else
 
-static inline int blkcache_read(int iftype, int dev,
+static inline int blkcache_read(int iftype, int dev, int hwpart,
 				lbaint_t start, lbaint_t blkcnt,
 				unsigned long blksz, void *buffer)
 {
 	return 0;
 }
 
-static inline void blkcache_fill(int iftype, int dev,
+static inline void blkcache_fill(int iftype, int dev, int hwpart,
 				 lbaint_t start, lbaint_t blkcnt,
 				 unsigned long blksz, void const *buffer) {}
 
+static inline lbaint_t blkcache_readahead(int iftype, int dev,
+					  lbaint_t start, lbaint_t blkcnt,
+					  unsigned long blksz)
+{
+	return blkcnt;
+}
+
+static inline void blkcache_write(int iftype, int dev, int hwpart,
+				  lbaint_t start, lbaint_t blkcnt,
+				  unsigned long blksz, void const *buffer) {}
+
+static inline void blkcache_invalidate_range(int iftype, int dev,
+					     int hwpart,
+					     lbaint_t start, lbaint_t blkcnt,
+					     unsigned long blksz) {}
+
 static inline void blkcache_invalidate(int iftype, int dev) {}
 
 #endif
@@ -430,7 +502,8 @@ static inline ulong blk_dread(struct blk_desc *block_dev, lbaint_t start,
 {
 	ulong blks_read;
 	if (blkcache_read(block_dev->if_type, block_dev->devnum,
-			  start, blkcnt, block_dev->blksz, buffer))
+			  block_dev->hwpart, start, blkcnt, block_dev->blksz,
+			  buffer))
 		return blkcnt;
 
 	/*
@@ -441,7 +514,8 @@ static inline ulong blk_dread(struct blk_desc *block_dev, lbaint_t start,
 	blks_read = block_dev->block_read(block_dev, start, blkcnt, buffer);
 	if (blks_read == blkcnt)
 		blkcache_fill(block_dev->if_type, block_dev->devnum,
-			      start, blkcnt, block_dev->blksz, buffer);
+			      block_dev->hwpart, start, blkcnt,
+			      block_dev->blksz, buffer);
 
 	return blks_read;
 }
@@ -449,14 +523,27 @@ static inline ulong blk_dread(struct blk_desc *block_dev, lbaint_t start,
 static inline ulong blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 			       lbaint_t blkcnt, const void *buffer)
 {
-	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
-	return block_dev->block_write(block_dev, start, blkcnt, buffer);
+	ulong blks_written;
+
+	blks_written = block_dev->block_write(block_dev, start, blkcnt, buffer);
+	if (blks_written == blkcnt)
+		blkcache_write(block_dev->if_type, block_dev->devnum,
+			       block_dev->hwpart, start, blkcnt,
+			       block_dev->blksz, buffer);
+	else
+		blkcache_invalidate_range(block_dev->if_type,
+					  block_dev->devnum, block_dev->hwpart,
+					  start, blkcnt, block_dev->blksz);
+
+	return blks_written;
 }
 
 static inline ulong blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			       lbaint_t blkcnt)
 {
-	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	blkcache_invalidate_range(block_dev->if_type, block_dev->devnum,
+				  block_dev->hwpart, start, blkcnt,
+				  block_dev->blksz);
 	return block_dev->block_erase(block_dev, start, blkcnt);
 }
 
@@ -15,6 +15,7 @@
 enum bootstage_flags {
 	BOOTSTAGEF_ERROR	= 1 << 0,	/* Error record */
 	BOOTSTAGEF_ALLOC	= 1 << 1,	/* Allocate an id */
+	BOOTSTAGEF_SPAN		= 1 << 2,	/* Start and duration of a step */
 };
 
 /* bootstate sub-IDs used for kernel and ramdisk ranges */
@@ -194,6 +195,11 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ACCUM_SCSI,
 	BOOTSTAGE_ID_ACCUM_SPI,
 	BOOTSTAGE_ID_ACCUM_DECOMP,
+	BOOTSTAGE_ID_ACCUM_LOAD,
+	BOOTSTAGE_ID_ACCUM_BLK,
+	BOOTSTAGE_ID_ACCUM_NET,
+	BOOTSTAGE_ID_ACCUM_HASH,
+	BOOTSTAGE_ID_ACCUM_FDT,
 	BOOTSTAGE_ID_ACCUM_OF_LIVE,
 	BOOTSTAGE_ID_FPGA_INIT,
 	BOOTSTATE_ID_ACCUM_DM_SPL,
@@ -304,9 +310,48 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name);
  */
 uint32_t bootstage_accum(enum bootstage_id id);
 
+/**
+ * bootstage_add_span() - Record the start and duration of a step
+ *
+ * Each step gets a record of its own, which shows up in the report with its
+ * start time and how long it took.
+ *
+ * @name: Name of the step, which must stay valid
+ * @start_us: Time at which the step started, from timer_get_boot_us()
+ * @return 0 if OK, -ENOSPC if there are no records left
+ */
+int bootstage_add_span(const char *name, ulong start_us);
+
+/**
+ * bootstage_initcall() - Record an init call
+ *
+ * The record is named after the address of the function, as found in
+ * u-boot.map.
+ *
+ * @addr: Unrelocated address of the function
+ * @start_us: Time at which the function was called
+ */
+void bootstage_initcall(ulong addr, ulong start_us);
+
 /* Print a report about boot time */
 void bootstage_report(void);
 
+enum bootstage_export_fmt {
+	BOOTSTAGE_EXPORT_CSV,
+	BOOTSTAGE_EXPORT_JSON,
+};
+
+/**
+ * bootstage_export() - Print all records in a machine-readable format
+ *
+ * Each record has its type ("mark", "accum" or "span"), id, name, and its
+ * time and duration in microseconds. A mark's duration is the time since
+ * the previous mark.
+ *
+ * @fmt: Output format
+ */
+void bootstage_export(enum bootstage_export_fmt fmt);
+
 /**
  * Add bootstage information to the device tree
  *
@@ -403,6 +448,15 @@ static inline uint32_t bootstage_accum(enum bootstage_id id)
 	return 0;
 }
 
+static inline int bootstage_add_span(const char *name, ulong start_us)
+{
+	return 0;
+}
+
+static inline void bootstage_initcall(ulong addr, ulong start_us)
+{
+}
+
 static inline int bootstage_stash(void *base, int size)
 {
 	return 0;	/* Pretend to succeed */
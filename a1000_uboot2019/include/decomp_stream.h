@@ -0,0 +1,95 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Decompressing an image while it is being loaded
+ *
+ * The compressed data is passed in as it arrives, in pieces of any size, and
+ * is decompressed straight to its final place. The whole compressed image
+ * never has to be in memory.
+ */
+
+#ifndef __DECOMP_STREAM_H
+#define __DECOMP_STREAM_H
+
+/**
+ * struct decomp_stream - State of a streaming decompression
+ *
+ * @comp: Compression type (IH_COMP_...)
+ * @dst: Where the output goes
+ * @dst_max: Size of the output buffer
+ * @out: Number of bytes of output so far
+ * @in: Number of bytes of input used so far
+ * @done: true once the end of the compressed data was seen, any input after
+ *	it is ignored
+ * @priv: Decoder state
+ */
+struct decomp_stream {
+	int comp;
+	void *dst;
+	size_t dst_max;
+	size_t out;
+	size_t in;
+	bool done;
+	void *priv;
+};
+
+/**
+ * decomp_stream_detect() - Find the compression type from the first bytes
+ *
+ * @buf: Start of the compressed data
+ * @len: Number of bytes at @buf
+ * @return IH_COMP_GZIP, IH_COMP_LZ4 or IH_COMP_LZMA if the data starts like
+ *	that, else IH_COMP_NONE
+ */
+int decomp_stream_detect(const void *buf, size_t len);
+
+/**
+ * decomp_stream_init() - Start a streaming decompression
+ *
+ * @ds: Stream to set up
+ * @comp: Compression type (IH_COMP_...), IH_COMP_NONE just copies
+ * @dst: Where the output goes
+ * @dst_max: Size of the output buffer
+ * @return 0 if OK, -EPROTONOSUPPORT if @comp is not supported, -ENOMEM if out
+ *	of memory
+ */
+int decomp_stream_init(struct decomp_stream *ds, int comp, void *dst,
+		       size_t dst_max);
+
+/**
+ * decomp_stream_write() - Decompress the next piece of input
+ *
+ * @ds: Stream
+ * @src: Compressed data
+ * @len: Number of bytes at @src
+ * @return 0 if OK, -ENOSPC if the output buffer is full, -EPROTO if the data
+ *	is corrupt, other -ve on error
+ */
+int decomp_stream_write(struct decomp_stream *ds, const void *src,
+			size_t len);
+
+/**
+ * decomp_stream_finish() - End a streaming decompression
+ *
+ * This frees the decoder state and must be called for each stream that was
+ * set up, also after an error.
+ *
+ * @ds: Stream
+ * @return 0 if all of the compressed data was seen, -EPROTO if it was cut
+ *	short
+ */
+int decomp_stream_finish(struct decomp_stream *ds);
+
+/* Decoders, called by the functions above */
+int gzip_stream_init(struct decomp_stream *ds);
+int gzip_stream_write(struct decomp_stream *ds, const void *src, size_t len);
+void gzip_stream_finish(struct decomp_stream *ds);
+
+int ulz4_stream_init(struct decomp_stream *ds);
+int ulz4_stream_write(struct decomp_stream *ds, const void *src, size_t len);
+void ulz4_stream_finish(struct decomp_stream *ds);
+
+int lzma_stream_init(struct decomp_stream *ds);
+int lzma_stream_write(struct decomp_stream *ds, const void *src, size_t len);
+void lzma_stream_finish(struct decomp_stream *ds);
+
+#endif /* __DECOMP_STREAM_H */
@@ -123,6 +123,8 @@ enum {
  *		When CONFIG_DEVRES is enabled, devm_kmalloc() and friends will
  *		add to this list. Memory so-allocated will be freed
  *		automatically when the device is removed / unbound
+ * @node_index_node: Used by uclass to link its devices with the same hash of
+ *		@node, when CONFIG_DM_LOOKUP_INDEX is enabled
  */
 struct udevice {
 	const struct driver *driver;
@@ -146,6 +148,9 @@ struct udevice {
 #ifdef CONFIG_DEVRES
 	struct list_head devres_head;
 #endif
+#if CONFIG_IS_ENABLED(DM_LOOKUP_INDEX)
+	struct list_head node_index_node;
+#endif
 };
 
 /* Maximum sequence number supported */
@@ -162,9 +167,28 @@ static inline int dev_of_offset(const struct udevice *dev)
 	return ofnode_to_offset(dev->node);
 }
 
+/**
+ * dev_set_ofnode() - Change the device tree node of a device
+ *
+ * Drivers which bind a device first and find its node later must use this
+ * rather than writing dev->node, so that the device can still be found by
+ * uclass_find_device_by_ofnode().
+ *
+ * @dev: Device to update
+ * @node: New node for the device
+ */
+#if CONFIG_IS_ENABLED(DM_LOOKUP_INDEX)
+void dev_set_ofnode(struct udevice *dev, ofnode node);
+#else
+static inline void dev_set_ofnode(struct udevice *dev, ofnode node)
+{
+	dev->node = node;
+}
+#endif
+
 static inline void dev_set_of_offset(struct udevice *dev, int of_offset)
 {
-	dev->node = offset_to_ofnode(of_offset);
+	dev_set_ofnode(dev, offset_to_ofnode(of_offset));
 }
 
 static inline bool dev_has_of_node(struct udevice *dev)
@@ -9,6 +9,8 @@
 #ifndef _DM_ROOT_H_
 #define _DM_ROOT_H_
 
+#include <dm/uclass-id.h>
+
 struct udevice;
 
 /**
@@ -95,6 +97,29 @@ int dm_scan_other(bool pre_reloc_only);
  */
 int dm_init_and_scan(bool pre_reloc_only);
 
+#if CONFIG_IS_ENABLED(DM_LAZY_PROBE)
+/**
+ * dm_probe_deferred() - Check if a uclass is probed on first use
+ *
+ * @id: Uclass ID to check
+ * @return true if the devices in this uclass should not be probed during
+ * init, false if they should
+ */
+bool dm_probe_deferred(enum uclass_id id);
+
+/**
+ * dm_probe_early() - Probe the uclasses listed in DM_LAZY_PROBE_EARLY
+ *
+ * A device which fails to probe is reported, but does not stop the others.
+ *
+ * @return 0 if OK, -ve on error
+ */
+int dm_probe_early(void);
+#else
+static inline bool dm_probe_deferred(enum uclass_id id) { return false; }
+static inline int dm_probe_early(void) { return 0; }
+#endif
+
 /**
  * dm_init() - Initialise Driver Model structures
  *
@@ -196,6 +196,35 @@ int uclass_unbind_device(struct udevice *dev);
 static inline int uclass_unbind_device(struct udevice *dev) { return 0; }
 #endif
 
+/**
+ * uclass_set_seq() - Set the sequence number of a device
+ *
+ * This keeps the uclass's index of sequence numbers up to date, so dev->seq
+ * must not be written directly.
+ *
+ * @dev:	Pointer to the device
+ * @seq:	New sequence number, or -1 if the device is no longer probed
+ */
+void uclass_set_seq(struct udevice *dev, int seq);
+
+#if CONFIG_IS_ENABLED(DM_LOOKUP_INDEX)
+/**
+ * uclass_node_index_add() - Add a device to its uclass's node index
+ *
+ * This does nothing if the device has no device tree node.
+ *
+ * @dev:	Pointer to the device, which must be in its uclass's list
+ */
+void uclass_node_index_add(struct udevice *dev);
+
+/**
+ * uclass_node_index_del() - Remove a device from its uclass's node index
+ *
+ * @dev:	Pointer to the device
+ */
+void uclass_node_index_del(struct udevice *dev);
+#endif
+
 /**
  * uclass_pre_probe_device() - Deal with a device that is about to be probed
  *
@@ -30,12 +30,27 @@
  * @dev_head: List of devices in this uclass (devices are attached to their
  * uclass when their bind method is called)
  * @sibling_node: Next uclass in the linked list of uclasses
+ * @seq_index: Probed devices indexed by their sequence number, when
+ * CONFIG_DM_LOOKUP_INDEX is enabled
+ * @seq_index_size: Number of entries in @seq_index, or -1 if it could not be
+ * allocated and the devices must be searched instead
+ * @node_index: Hash table of devices with a device tree node, by node. NULL
+ * if it could not be allocated, in which case the devices are searched
+ * @node_index_bits: log2 of the number of buckets in @node_index
+ * @node_count: Number of devices with a device tree node
  */
 struct uclass {
 	void *priv;
 	struct uclass_driver *uc_drv;
 	struct list_head dev_head;
 	struct list_head sibling_node;
+#if CONFIG_IS_ENABLED(DM_LOOKUP_INDEX)
+	struct udevice **seq_index;
+	int seq_index_size;
+	struct list_head *node_index;
+	uint node_index_bits;
+	uint node_count;
+#endif
 };
 
 struct driver;
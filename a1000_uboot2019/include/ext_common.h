@@ -193,11 +193,19 @@ struct ext2_dirent {
 	__u8 filetype;
 };
 
+/* A run of file blocks that are physically contiguous (or a hole). */
+struct ext2fs_block_map {
+	int fileblock;		/* First file block of the run */
+	int len;		/* Blocks in the run, 0 if nothing is mapped */
+	long int start;		/* First disk block of the run, 0 for a hole */
+};
+
 struct ext2fs_node {
 	struct ext2_data *data;
 	struct ext2_inode inode;
 	int ino;
 	int inode_read;
+	struct ext2fs_block_map map;	/* Last run looked up for reading */
 };
 
 /* Information about a "mounted" ext2 filesystem. */
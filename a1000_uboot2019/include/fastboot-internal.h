@@ -13,6 +13,25 @@ extern void *fastboot_buf_addr;
  */
 extern u32 fastboot_buf_size;
 
+/**
+ * fastboot_download_speed - throughput of the last download, in KiB/s
+ */
+extern u32 fastboot_download_speed;
+
+/*
+ * Largest download while downloads are written to a partition as they
+ * arrive: the size is sent as 8 hex digits, so keep it below 4 GiB
+ */
+#define FASTBOOT_STREAM_MAX	0xfffff000
+
+/**
+ * fastboot_download_max() - Largest download the client may send
+ *
+ * Return: Size of the fastboot buffer, or FASTBOOT_STREAM_MAX while
+ *	   downloads are written to a partition as they arrive
+ */
+u32 fastboot_download_max(void);
+
 /**
  * fastboot_progress_callback - callback executed during long operations
  */
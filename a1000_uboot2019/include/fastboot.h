@@ -36,6 +36,9 @@ enum {
 #if CONFIG_IS_ENABLED(FASTBOOT_CMD_OEM_FORMAT)
 	FASTBOOT_COMMAND_OEM_FORMAT,
 #endif
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+	FASTBOOT_COMMAND_OEM_STREAM,
+#endif
 
 	FASTBOOT_COMMAND_COUNT
 };
@@ -142,6 +145,18 @@ u32 fastboot_data_remaining(void);
 void fastboot_data_download(const void *fastboot_data,
 			    unsigned int fastboot_data_len, char *response);
 
+/**
+ * fastboot_data_received() - Account for data received in place
+ *
+ * @fastboot_data_len: Number of bytes written to fastboot_buf_addr at the
+ *		       current download offset
+ * @response: Pointer to fastboot response buffer
+ *
+ * Like fastboot_data_download(), for transports which receive the image
+ * directly into fastboot_buf_addr.
+ */
+void fastboot_data_received(unsigned int fastboot_data_len, char *response);
+
 /**
  * fastboot_data_complete() - Mark current transfer complete
  *
@@ -34,4 +34,46 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
  * @response: Pointer to fastboot response buffer
  */
 void fastboot_mmc_erase(const char *cmd, char *response);
+
+/**
+ * fastboot_mmc_stream_start() - Start writing a download to eMMC
+ *
+ * The image is written while it is being downloaded, see
+ * CONFIG_FASTBOOT_FLASH_STREAM.
+ *
+ * @cmd: Named partition to write the image to
+ * @response: Pointer to fastboot response buffer
+ * @return 0 if OK, -1 on error
+ */
+int fastboot_mmc_stream_start(const char *cmd, char *response);
+
+/**
+ * fastboot_mmc_stream_write() - Write the next part of a download to eMMC
+ *
+ * @data: Pointer to the data following the previous part
+ * @len: Size of the data
+ * @response: Pointer to fastboot response buffer
+ * @return 0 if OK, -1 on error
+ */
+int fastboot_mmc_stream_write(const void *data, u32 len, char *response);
+
+/**
+ * fastboot_mmc_stream_end() - Finish writing a download to eMMC
+ *
+ * @cmd: Named partition the image was written to
+ * @response: Pointer to fastboot response buffer
+ * @return 0 if OK, -1 on error
+ */
+int fastboot_mmc_stream_end(const char *cmd, char *response);
+
+/**
+ * fastboot_mmc_flush() - Make what was written safe from a reset
+ *
+ * This writes the eMMC cache back to the flash, so call it before reporting
+ * success for a command which wrote to the eMMC.
+ *
+ * @response: Pointer to fastboot response buffer, changed to a failure if
+ *	the eMMC write cache cannot be flushed after a successful command
+ */
+void fastboot_mmc_flush(char *response);
 #endif
@@ -110,6 +110,18 @@ int hash_command(const char *algo_name, int flags, cmd_tbl_t *cmdtp, int flag,
 int hash_block(const char *algo_name, const void *data, unsigned int len,
 	       uint8_t *output, int *output_size);
 
+/**
+ * hash_bench() - Print the throughput of each hash algorithm
+ *
+ * Each algorithm repeatedly hashes the same buffer of @len bytes, and the
+ * rate it achieves is printed in MB/s. This shows which algorithms are
+ * accelerated on the running CPU.
+ *
+ * @len:		Size of the buffer to hash in bytes
+ * @return 0 if ok, -ENOMEM if the buffer could not be allocated
+ */
+int hash_bench(unsigned int len);
+
 #endif /* !USE_HOSTCC */
 
 /**
@@ -3,6 +3,7 @@
  * Copyright 2014 Broadcom Corporation.
  */
 
+#include <memalign.h>
 #include <part.h>
 #include <sparse_format.h>
 
@@ -23,6 +24,17 @@ struct sparse_storage {
 				 lbaint_t blk,
 				 lbaint_t blkcnt);
 
+	/*
+	 * Optional: erase or discard blocks instead of writing them. With
+	 * @zero set the blocks must read back as zeroes, otherwise their
+	 * contents do not matter. Returns the number of blocks erased, less
+	 * than @blkcnt if the storage could not do it.
+	 */
+	lbaint_t	(*erase)(struct sparse_storage *info,
+				 lbaint_t blk,
+				 lbaint_t blkcnt,
+				 bool zero);
+
 	void		(*mssg)(const char *str, char *response);
 };
 
@@ -39,3 +51,93 @@ static inline int is_sparse_image(void *buf)
 
 int write_sparse_image(struct sparse_storage *info, const char *part_name,
 		       void *data, char *response);
+
+/* Largest storage block size supported by struct sparse_stream */
+#define SPARSE_STREAM_MAX_BLKSZ	4096
+
+enum sparse_stream_state {
+	SPARSE_STREAM_HEADER,		/* receiving the sparse file header */
+	SPARSE_STREAM_IMAGE,		/* not sparse, writing a raw image */
+	SPARSE_STREAM_CHUNK,		/* receiving a chunk header */
+	SPARSE_STREAM_DATA,		/* writing the data of a raw chunk */
+	SPARSE_STREAM_FILL,		/* receiving the value of a fill chunk */
+	SPARSE_STREAM_END,		/* all chunks done */
+	SPARSE_STREAM_ERROR,
+};
+
+/**
+ * struct sparse_stream - An image being written as it is received
+ *
+ * Unlike write_sparse_image(), which needs the whole image in memory, this
+ * takes the image in pieces of any size and writes each block as soon as it
+ * is complete. Images without a sparse header are written as they are.
+ *
+ * @info: Storage the image is written to
+ * @state: What the next bytes of the image are
+ * @skip: Bytes to drop before continuing with @state
+ * @left: Bytes left in the current raw chunk
+ * @blk: Next block to write
+ * @chunk_idx: Index of the current chunk
+ * @total_blocks: Sparse blocks covered by the chunks so far
+ * @bytes_written: Bytes written to the storage so far
+ * @header: Sparse file header
+ * @chunk: Current chunk header
+ * @hdr: Header or fill value being received
+ * @hdr_len: Bytes received in @hdr
+ * @part: Start of a block whose end has not been received yet
+ * @part_len: Bytes in @part
+ */
+struct sparse_stream {
+	struct sparse_storage	*info;
+	enum sparse_stream_state state;
+	u32		skip;
+	u64		left;
+	lbaint_t	blk;
+	u32		chunk_idx;
+	u32		total_blocks;
+	u64		bytes_written;
+	sparse_header_t	header;
+	chunk_header_t	chunk;
+	u8		hdr[sizeof(sparse_header_t)];
+	u32		hdr_len;
+	u8		part[SPARSE_STREAM_MAX_BLKSZ]
+			__aligned(ARCH_DMA_MINALIGN);
+	u32		part_len;
+};
+
+/**
+ * sparse_stream_init() - Start writing an image received in pieces
+ *
+ * @ss: Stream state to set up
+ * @info: Storage to write the image to
+ * @response: Pointer to fastboot response buffer
+ * @return 0 if OK, -1 if @info is not supported
+ */
+int sparse_stream_init(struct sparse_stream *ss, struct sparse_storage *info,
+		       char *response);
+
+/**
+ * sparse_stream_write() - Write the next piece of an image
+ *
+ * @ss: Stream state
+ * @data: Image data following the previous piece
+ * @len: Number of bytes at @data
+ * @response: Pointer to fastboot response buffer
+ * @return 0 if OK, -1 on error (which is reported through info->mssg)
+ */
+int sparse_stream_write(struct sparse_stream *ss, const void *data,
+			u32 len, char *response);
+
+/**
+ * sparse_stream_finish() - Write what is left of an image
+ *
+ * This pads the last block of a raw image with zeroes and checks that a
+ * sparse image was complete.
+ *
+ * @ss: Stream state
+ * @part_name: Name of the partition, for the summary message
+ * @response: Pointer to fastboot response buffer
+ * @return 0 if OK, -1 on error
+ */
+int sparse_stream_finish(struct sparse_stream *ss, const char *part_name,
+			 char *response);
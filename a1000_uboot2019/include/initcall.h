@@ -21,6 +21,11 @@ static inline int initcall_run_list(const init_fnc_t init_sequence[])
 	for (init_fnc_ptr = init_sequence; *init_fnc_ptr; ++init_fnc_ptr) {
 		unsigned long reloc_ofs = 0;
 		int ret;
+#if CONFIG_IS_ENABLED(BOOTSTAGE_TIMELINE)
+		/* there is no timer before bootstage is set up */
+		bool timed = gd->bootstage;
+		ulong start_us = timed ? timer_get_boot_us() : 0;
+#endif
 
 		if (gd->flags & GD_FLG_RELOC)
 			reloc_ofs = gd->reloc_off;
@@ -33,6 +38,11 @@ static inline int initcall_run_list(const init_fnc_t init_sequence[])
 		else
 			debug("\n");
 		ret = (*init_fnc_ptr)();
+#if CONFIG_IS_ENABLED(BOOTSTAGE_TIMELINE)
+		if (timed)
+			bootstage_initcall((ulong)*init_fnc_ptr - reloc_ofs,
+					   start_us);
+#endif
 		if (ret) {
 //		if (1) {
 			printf("initcall sequence %p ", init_sequence);
@@ -236,6 +236,23 @@ enum spi_nor_option_flags {
 	SNOR_F_BROKEN_RESET	= BIT(6),
 };
 
+/* Paths a read can take, see spi_flash_dirmap_read() */
+enum spi_nor_read_path {
+	SPI_NOR_READ_DIRMAP = 0,
+	SPI_NOR_READ_FIFO,
+	SPI_NOR_READ_PATHS,
+};
+
+/**
+ * struct spi_nor_read_stats - Read throughput accounting for one path
+ * @bytes:		number of bytes read
+ * @us:			time spent reading, in microseconds
+ */
+struct spi_nor_read_stats {
+	u64			bytes;
+	u64			us;
+};
+
 /**
  * struct flash_info - Forward declaration of a structure used internally by
  *		       spi_nor_scan()
@@ -282,6 +299,8 @@ struct flash_info;
  * @flash_is_locked:	[FLASH-SPECIFIC] check if a region of the SPI NOR is
  * @quad_enable:	[FLASH-SPECIFIC] enables SPI NOR quad mode
  *			completely locked
+ * @dirmap_disabled:	don't try the memory-mapped read window
+ * @read_stats:		bytes read and time spent per read path
  * @priv:		the private data
  */
 struct spi_nor {
@@ -323,6 +342,10 @@ struct spi_nor {
 	int (*flash_is_locked)(struct spi_nor *nor, loff_t ofs, uint64_t len);
 	int (*quad_enable)(struct spi_nor *nor);
 
+#ifdef CONFIG_SPI_FLASH_DIRMAP
+	bool			dirmap_disabled;
+	struct spi_nor_read_stats read_stats[SPI_NOR_READ_PATHS];
+#endif
 	void *priv;
 /* Compatibility for spi_flash, remove once sf layer is merged with mtd */
 	const char *name;
@@ -0,0 +1,99 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * High-bandwidth memory test engine
+ *
+ * The memory is tested a 64-byte line at a time, with the chunks of a
+ * region spread over all CPUs by smp_work_run().
+ */
+
+#ifndef __MEMTEST_H
+#define __MEMTEST_H
+
+/* Start and size of a region must be a multiple of this */
+#define MEMTEST_LINE_SIZE	64
+
+/* Failing words reported for each region */
+#define MEMTEST_MAX_FAILS	8
+
+/* Algorithms for memtest_run(), may be combined */
+enum {
+	MEMTEST_WALK	= 1 << 0,	/* walking 1/0 on data and address bus */
+	MEMTEST_MATS	= 1 << 1,	/* MATS+ march */
+	MEMTEST_ADDR	= 1 << 2,	/* address in address, and inverted */
+	MEMTEST_ALL	= MEMTEST_WALK | MEMTEST_MATS | MEMTEST_ADDR,
+
+	MEMTEST_ZVA	= 1 << 8,	/* zero with the fastest fill available */
+};
+
+/**
+ * struct memtest_fail - A word which did not read back as written
+ *
+ * @addr:	Physical address of the word
+ * @expect:	Value written
+ * @actual:	Value read back
+ */
+struct memtest_fail {
+	ulong addr;
+	u64 expect;
+	u64 actual;
+};
+
+/**
+ * struct memtest_result - Result of a test run
+ *
+ * @errors:	Number of failing reads
+ * @nfails:	Number of entries in @fail
+ * @fail:	First failures, in address order of the chunks they were found in
+ * @bytes:	Bytes read and written by the passes over the whole region
+ * @us:		Time taken by those passes in microseconds
+ * @cpus:	Number of CPUs which ran the test
+ */
+struct memtest_result {
+	ulong errors;
+	uint nfails;
+	struct memtest_fail fail[MEMTEST_MAX_FAILS];
+	u64 bytes;
+	ulong us;
+	int cpus;
+};
+
+/**
+ * memtest_run() - Test a region of memory
+ *
+ * The previous contents of the region are lost. It must not hold anything
+ * in use by U-Boot, such as its code, stack or malloc() area.
+ *
+ * @start:	Physical start address of the region
+ * @size:	Size of the region in bytes
+ * @flags:	MEMTEST_... algorithms and options
+ * @res:	Returns the result
+ * @return 0 if the test ran (see @res->errors for the outcome), -EINVAL if
+ *	the region is not aligned to MEMTEST_LINE_SIZE, -ENOMEM if out of
+ *	memory, -EINTR if interrupted with Ctrl-C
+ */
+int memtest_run(ulong start, ulong size, uint flags,
+		struct memtest_result *res);
+
+/**
+ * arch_memtest_zero() - Zero a region with the fastest fill available
+ *
+ * This is used for MEMTEST_ZVA and may run on any CPU. The default is
+ * memset().
+ *
+ * @buf:	Region to zero, aligned to MEMTEST_LINE_SIZE
+ * @size:	Size in bytes, a multiple of MEMTEST_LINE_SIZE
+ */
+void arch_memtest_zero(void *buf, ulong size);
+
+/**
+ * arch_memtest_inject() - Corrupt memory after it has been written
+ *
+ * This is called on the boot CPU after each pass which writes to memory, so
+ * that faults can be simulated. It does nothing except on sandbox.
+ *
+ * @start:	Physical start address of the region written
+ * @size:	Size of the region in bytes
+ */
+void arch_memtest_inject(ulong start, ulong size);
+
+#endif
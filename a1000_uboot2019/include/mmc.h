@@ -203,6 +203,8 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 /*
  * EXT_CSD fields
  */
+#define EXT_CSD_FLUSH_CACHE		32	/* W */
+#define EXT_CSD_CACHE_CTRL		33	/* R/W/E_P */
 #define EXT_CSD_ENH_START_ADDR		136	/* R/W */
 #define EXT_CSD_ENH_SIZE_MULT		140	/* R/W */
 #define EXT_CSD_GP_SIZE_MULT		143	/* R/W */
@@ -219,6 +221,7 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 #define EXT_CSD_BOOT_BUS_WIDTH		177
 #define EXT_CSD_PART_CONF		179	/* R/W */
 #define EXT_CSD_BUS_WIDTH		183	/* R/W */
+#define EXT_CSD_ERASED_MEM_CONT		181	/* RO */
 #define EXT_CSD_HS_TIMING		185	/* R/W */
 #define EXT_CSD_REV			192	/* RO */
 #define EXT_CSD_CARD_TYPE		196	/* RO */
@@ -226,6 +229,8 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 #define EXT_CSD_HC_WP_GRP_SIZE		221	/* RO */
 #define EXT_CSD_HC_ERASE_GRP_SIZE	224	/* RO */
 #define EXT_CSD_BOOT_MULT		226	/* RO */
+#define EXT_CSD_SEC_FEATURE_SUPPORT	231	/* RO */
+#define EXT_CSD_CACHE_SIZE		249	/* RO, 4 bytes */
 #define EXT_CSD_BKOPS_SUPPORT		502	/* RO */
 
 /*
@@ -266,6 +271,8 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 #define EXT_CSD_TIMING_HS200	2	/* HS200 */
 #define EXT_CSD_TIMING_HS400	3	/* HS400 */
 
+#define EXT_CSD_SEC_GB_CL_EN	BIT(4)	/* TRIM is supported */
+
 #define EXT_CSD_BOOT_ACK_ENABLE			(1 << 6)
 #define EXT_CSD_BOOT_PARTITION_ENABLE		(1 << 3)
 #define EXT_CSD_PARTITION_ACCESS_ENABLE		(1 << 0)
@@ -289,6 +296,7 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 #define EXT_CSD_ENH_GP(x)	(1 << ((x)+1))	/* GP part (x+1) is enhanced */
 
 #define EXT_CSD_HS_CTRL_REL	(1 << 0)	/* host controlled WR_REL_SET */
+#define EXT_CSD_EN_REL_WR	(1 << 2)	/* enhanced reliable write */
 
 #define EXT_CSD_WR_DATA_REL_USR		(1 << 0)	/* user data area WR_REL */
 #define EXT_CSD_WR_DATA_REL_GP(x)	(1 << ((x)+1))	/* GP part (x+1) WR_REL */
@@ -606,6 +614,7 @@ struct mmc {
 #if CONFIG_IS_ENABLED(MMC_WRITE)
 	struct sd_ssr	ssr;	/* SD status register */
 #endif
+	bool reliable_write;	/* use reliable writes on any partition */
 	u64 capacity;
 	u64 capacity_user;
 	u64 capacity_boot;
@@ -690,6 +699,47 @@ int mmc_initialize(bd_t *bis);
 int mmc_init(struct mmc *mmc);
 int mmc_send_tuning(struct mmc *mmc, u32 opcode, int *cmd_error);
 
+/* Largest number of sampling phases mmc_tuning_sweep() can try */
+#define MMC_TUNING_MAX_PHASES	256
+
+/**
+ * mmc_get_tuning_block() - Get the data a card returns for a tuning command
+ *
+ * @bus_width:	Bus width in bits
+ * @sizep:	Returns the size of the block in bytes
+ * @return pointer to the block, or NULL if there is none for this width
+ */
+const u8 *mmc_get_tuning_block(uint bus_width, int *sizep);
+
+/**
+ * mmc_tuning_find_phase() - Pick a sampling phase from the results of a sweep
+ *
+ * This finds the longest run of phases which passed and returns the one in
+ * the middle of it, being the furthest from a failure. The phases are taken
+ * to cover a whole clock cycle, so a run may wrap from the last phase to the
+ * first.
+ *
+ * @passed:	Array with an entry for each phase, true if it passed
+ * @num_phases:	Number of phases in @passed
+ * @return phase to use, or -EIO if none passed
+ */
+int mmc_tuning_find_phase(const bool *passed, uint num_phases);
+
+/**
+ * mmc_tuning_sweep() - Tune by trying each sampling phase in turn
+ *
+ * This selects each phase with @set_phase() and sends a tuning command, then
+ * selects the phase chosen by mmc_tuning_find_phase().
+ *
+ * @mmc:	MMC device to tune
+ * @opcode:	Tuning command to send
+ * @num_phases:	Number of phases, at most MMC_TUNING_MAX_PHASES
+ * @set_phase:	Function to select a phase in the host controller
+ * @return phase selected, or -ve on error
+ */
+int mmc_tuning_sweep(struct mmc *mmc, u32 opcode, uint num_phases,
+		     int (*set_phase)(struct mmc *mmc, uint phase));
+
 #if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT) || \
     CONFIG_IS_ENABLED(MMC_HS200_SUPPORT) || \
     CONFIG_IS_ENABLED(MMC_HS400_SUPPORT)
@@ -758,6 +808,83 @@ int mmc_set_part_conf(struct mmc *mmc, u8 ack, u8 part_num, u8 access);
 int mmc_set_boot_bus_width(struct mmc *mmc, u8 width, u8 reset, u8 mode);
 /* Function to modify the RST_n_FUNCTION field of EXT_CSD */
 int mmc_set_rst_n_function(struct mmc *mmc, u8 enable);
+
+/**
+ * mmc_trim() - Trim or discard blocks of an eMMC device
+ *
+ * Unlike erase, which acts on whole erase groups, these act on exactly the
+ * blocks given. Trimmed blocks read back as the erased memory content
+ * (EXT_CSD_ERASED_MEM_CONT), discarded blocks may keep any content.
+ *
+ * @block_dev:	MMC block device
+ * @start:	First block
+ * @blkcnt:	Number of blocks
+ * @arg:	MMC_TRIM_ARG or MMC_DISCARD_ARG
+ * @return number of blocks trimmed, 0 if not supported by the device
+ */
+ulong mmc_trim(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
+	       uint arg);
+
+/**
+ * mmc_cache_size() - Get the size of the eMMC volatile write cache
+ *
+ * @mmc:	MMC device
+ * @return cache size in KiB, 0 if the device has no cache
+ */
+static inline uint mmc_cache_size(struct mmc *mmc)
+{
+	const u8 *ext_csd = mmc->ext_csd;
+
+	if (IS_SD(mmc) || !ext_csd || mmc->version < MMC_VERSION_4_5)
+		return 0;
+
+	return ext_csd[EXT_CSD_CACHE_SIZE] |
+	       ext_csd[EXT_CSD_CACHE_SIZE + 1] << 8 |
+	       ext_csd[EXT_CSD_CACHE_SIZE + 2] << 16 |
+	       ext_csd[EXT_CSD_CACHE_SIZE + 3] << 24;
+}
+
+/**
+ * mmc_cache_enabled() - Check whether the eMMC write cache is turned on
+ *
+ * @mmc:	MMC device
+ * @return true if written data may still be held in the device cache
+ */
+static inline bool mmc_cache_enabled(struct mmc *mmc)
+{
+	return mmc_cache_size(mmc) && (mmc->ext_csd[EXT_CSD_CACHE_CTRL] & 1);
+}
+
+/**
+ * mmc_cache_ctrl() - Turn the eMMC volatile write cache on or off
+ *
+ * The cache is flushed before it is turned off.
+ *
+ * @mmc:	MMC device
+ * @enable:	true to turn the cache on
+ * @return 0 if OK, -EMEDIUMTYPE if the device has no cache, other -ve on error
+ */
+int mmc_cache_ctrl(struct mmc *mmc, bool enable);
+
+/**
+ * mmc_flush_cache() - Write the eMMC cache contents back to the flash
+ *
+ * This does nothing if the device is not initialised or has no cache turned
+ * on. It must be called before the device loses power or is handed over to
+ * another owner, e.g. the OS.
+ *
+ * @mmc:	MMC device
+ * @return 0 if OK, -ve on error
+ */
+int mmc_flush_cache(struct mmc *mmc);
+
+/**
+ * mmc_flush_all_caches() - Flush the write cache of every active MMC device
+ *
+ * @return 0 if OK, -ve error from the first device which failed
+ */
+int mmc_flush_all_caches(void);
+
 /* Functions to read / write the RPMB partition */
 int mmc_rpmb_set_key(struct mmc *mmc, void *key);
 int mmc_rpmb_get_counter(struct mmc *mmc, unsigned long *counter);
@@ -364,4 +364,29 @@ int os_write_file(const char *name, const void *buf, int size);
  */
 int os_read_file(const char *name, void **bufp, int *sizep);
 
+/**
+ * os_thread_create() - Start a host thread
+ *
+ * This is used to run U-Boot code on more than one host CPU. The code must
+ * not call into the rest of U-Boot, which is not thread-safe.
+ *
+ * @threadp:	Returns the thread, to be passed to os_thread_join()
+ * @fn:		Function run by the thread
+ * @arg:	Argument passed to @fn
+ * @return 0 if OK, -ve on error
+ */
+int os_thread_create(void **threadp, void *(*fn)(void *arg), void *arg);
+
+/**
+ * os_thread_join() - Wait for a host thread to finish
+ *
+ * @thread:	Thread returned by os_thread_create()
+ */
+void os_thread_join(void *thread);
+
+/**
+ * os_thread_yield() - Let other host threads run
+ */
+void os_thread_yield(void);
+
 #endif
@@ -99,6 +99,29 @@ struct reset_ctl_bulk {
 int reset_get_by_index(struct udevice *dev, int index,
 		       struct reset_ctl *reset_ctl);
 
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
+struct phandle_1_arg;
+
+/**
+ * reset_get_by_index_platdata - Get/request a reset signal from of-platdata
+ *
+ * This is the of-platdata equivalent of reset_get_by_index(). The 'resets'
+ * property of the client is passed in as generated by dtoc. The provider is
+ * the reset device whose platform data is the dtoc structure referenced by
+ * the phandle, so the provider driver must not allocate more platform data
+ * than its dtoc structure.
+ *
+ * @dev:	The client device.
+ * @index:	The index of the reset signal to request, within @cells.
+ * @cells:	The client's 'resets' property, as generated by dtoc.
+ * @reset_ctl	A pointer to a reset control struct to initialize.
+ * @return 0 if OK, or a negative error code.
+ */
+int reset_get_by_index_platdata(struct udevice *dev, int index,
+				struct phandle_1_arg *cells,
+				struct reset_ctl *reset_ctl);
+#endif
+
 /**
  * reset_get_bulk - Get/request all reset signals of a device.
  *
@@ -210,6 +210,7 @@
 /* 55-57 reserved */
 
 #define SDHCI_ADMA_ADDRESS	0x58
+#define SDHCI_ADMA_ADDRESS_HI	0x5C
 
 /* 60-FB reserved */
 
@@ -251,6 +252,12 @@
 #define SDHCI_QUIRK_USE_WIDE8		(1 << 8)
 #define SDHCI_QUIRK_NO_1_8_V		(1 << 9)
 #define SDHCI_QUIRK_BROKEN_MULTI_BLK	(1 << 10)
+/*
+ * SDHCI_QUIRK_ADMA_128M_BOUNDARY
+ * an ADMA2 descriptor must not describe a buffer that crosses a 128 MiB
+ * boundary (Synopsys DWC MSHC)
+ */
+#define SDHCI_QUIRK_ADMA_128M_BOUNDARY	BIT(11)
 
 /* to make gcc happy */
 struct sdhci_host;
@@ -260,6 +267,49 @@ struct sdhci_host;
  */
 #define SDHCI_DEFAULT_BOUNDARY_SIZE	(512 * 1024)
 #define SDHCI_DEFAULT_BOUNDARY_ARG	(7)
+
+/*
+ * ADMA2 descriptor table. One descriptor moves at most ADMA_MAX_LEN bytes
+ * (kept a multiple of 4 so that a length of 0 never means 64 KiB), so the
+ * table is sized for the largest request the MMC core will issue.
+ */
+#define ADMA_MAX_LEN			65532
+#define ADMA_BOUNDARY_SIZE		(128 * 1024 * 1024)
+#define ADMA_TABLE_NO_ENTRIES \
+	(DIV_ROUND_UP(CONFIG_SYS_MMC_MAX_BLK_COUNT * MMC_MAX_BLOCK_LEN, \
+		      ADMA_MAX_LEN) + \
+	 DIV_ROUND_UP(CONFIG_SYS_MMC_MAX_BLK_COUNT * MMC_MAX_BLOCK_LEN, \
+		      ADMA_BOUNDARY_SIZE) + 1)
+#define ADMA_TABLE_SZ \
+	(ADMA_TABLE_NO_ENTRIES * sizeof(struct sdhci_adma_desc))
+
+/* Data buffers handed to the ADMA engine must be 32-bit aligned */
+#define ADMA_DATA_ALIGN			4
+
+/* Descriptor attributes */
+#define ADMA_DESC_ATTR_VALID		BIT(0)
+#define ADMA_DESC_ATTR_END		BIT(1)
+#define ADMA_DESC_ATTR_INT		BIT(2)
+#define ADMA_DESC_ATTR_ACT1		BIT(4)
+#define ADMA_DESC_ATTR_ACT2		BIT(5)
+
+#define ADMA_DESC_TRANSFER_DATA		ADMA_DESC_ATTR_ACT2
+#define ADMA_DESC_LINK_DESC	(ADMA_DESC_ATTR_ACT1 | ADMA_DESC_ATTR_ACT2)
+
+/*
+ * ADMA2 descriptor. With 64-bit DMA addressing this is the 96-bit
+ * descriptor of the SD Host Controller Specification Version 3.00.
+ */
+struct sdhci_adma_desc {
+	u8 attr;
+	u8 reserved;
+	u16 len;
+	u32 addr_lo;
+#ifdef CONFIG_DMA_ADDR_T_64BIT
+	u32 addr_hi;
+#endif
+} __packed;
+
 struct sdhci_ops {
 #ifdef CONFIG_MMC_SDHCI_IO_ACCESSORS
 	u32	(*read_l)(struct sdhci_host *host, int reg);
@@ -297,6 +347,13 @@ struct sdhci_host {
 	uint	voltages;
 
 	struct mmc_config cfg;
+	uint	flags;
+#define USE_SDMA	BIT(0)
+#define USE_ADMA	BIT(1)
+#define USE_ADMA64	BIT(2)
+#define USE_DMA		(USE_SDMA | USE_ADMA | USE_ADMA64)
+	struct sdhci_adma_desc *adma_desc_table;
+	uint	desc_slot;
 };
 
 #ifdef CONFIG_MMC_SDHCI_IO_ACCESSORS
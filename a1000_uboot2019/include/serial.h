@@ -190,6 +190,22 @@ struct dm_serial_ops {
 	 * @return 0 if OK, -ve on error
 	 */
 	int (*putc)(struct udevice *dev, const char ch);
+	/**
+	 * puts() - Write a string
+	 *
+	 * This writes as many of the characters as the device can take
+	 * without waiting, for example by filling a FIFO. Newlines are not
+	 * expanded: the uclass writes '\r' itself. If nothing could be
+	 * written, this should return -EAGAIN.
+	 *
+	 * This method is optional, putc() is used without it.
+	 *
+	 * @dev: Device pointer
+	 * @s: Characters to write
+	 * @len: Number of characters to write
+	 * @return number of characters written, -ve on error
+	 */
+	ssize_t (*puts)(struct udevice *dev, const char *s, size_t len);
 	/**
 	 * pending() - Check if input/output characters are waiting
 	 *
@@ -314,6 +330,14 @@ int serial_setconfig(struct udevice *dev, uint config);
  */
 int serial_getinfo(struct udevice *dev, struct serial_device_info *info);
 
+/**
+ * serial_flush() - Wait until the console has sent all its output
+ *
+ * Output may be buffered by the driver, so call this before anything which
+ * stops the UART or hands it over, such as booting an OS.
+ */
+void serial_flush(void);
+
 void atmel_serial_initialize(void);
 void mcf_serial_initialize(void);
 void mpc85xx_serial_initialize(void);
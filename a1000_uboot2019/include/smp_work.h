@@ -0,0 +1,92 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Running CPU-bound work on the secondary CPUs
+ *
+ * The secondary CPUs are started the first time smp_work_run() is called.
+ * Between jobs they wait for the next one, and smp_work_stop() hands them
+ * back to whatever started them (spin table, PSCI) before an OS is booted.
+ */
+
+#ifndef __SMP_WORK_H
+#define __SMP_WORK_H
+
+/**
+ * typedef smp_work_fn - Function run for each item of a job
+ *
+ * It may run on any CPU, at the same time as the items before and after it,
+ * so it must only work on memory and not use drivers, the console or malloc.
+ *
+ * @priv: Private data passed to smp_work_run()
+ * @item: Item number, 0 to the item count - 1
+ */
+typedef void (*smp_work_fn)(void *priv, uint item);
+
+#ifdef CONFIG_SMP_WORK
+/**
+ * smp_work_run() - Run a function for a number of items on all CPUs
+ *
+ * The items are spread over the CPUs, including this one, and the call
+ * returns once all of them are done. Without secondary CPUs the items are
+ * simply run one after the other.
+ *
+ * @fn: Function to run for each item
+ * @priv: Private data passed to @fn
+ * @count: Number of items
+ * @return number of CPUs which ran the items
+ */
+int smp_work_run(smp_work_fn fn, void *priv, uint count);
+
+/**
+ * smp_work_stop() - Park the secondary CPUs
+ *
+ * This must be called before jumping to an OS. The CPUs are started again
+ * by the next smp_work_run().
+ */
+void smp_work_stop(void);
+#else
+static inline int smp_work_run(smp_work_fn fn, void *priv, uint count)
+{
+	uint item;
+
+	for (item = 0; item < count; item++)
+		fn(priv, item);
+
+	return 1;
+}
+
+static inline void smp_work_stop(void)
+{
+}
+#endif
+
+/**
+ * smp_work_secondary() - Wait for and run jobs on a secondary CPU
+ *
+ * This is called by the architecture code on each CPU it started, and
+ * returns when the CPU is to be parked.
+ *
+ * @cpu: CPU number, 1 to the number returned by arch_smp_work_start()
+ */
+void smp_work_secondary(uint cpu);
+
+/**
+ * arch_smp_work_start() - Start the secondary CPUs
+ *
+ * @max_cpus: Maximum number of CPUs to start
+ * @return number of CPUs started, each of which calls smp_work_secondary(),
+ *	or -ve on error
+ */
+int arch_smp_work_start(uint max_cpus);
+
+/**
+ * arch_smp_work_stop() - Wait for the secondary CPUs to be parked
+ *
+ * This is called once smp_work_secondary() has been told to return.
+ */
+void arch_smp_work_stop(void);
+
+/* Wait for an update from another CPU, and send one */
+void arch_smp_work_wait(void);
+void arch_smp_work_wake(void);
+
+#endif /* __SMP_WORK_H */
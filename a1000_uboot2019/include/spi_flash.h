@@ -77,6 +77,25 @@ static inline int spi_flash_get(u32 offset, size_t len,
 }
 #endif
 
+#ifdef CONFIG_SPI_FLASH_DIRMAP
+/**
+ * spi_flash_dirmap_read() - Read data through a memory-mapped flash window
+ *
+ * Boards whose controller can map the flash into the address space
+ * provide this; spi_flash_read_dm() tries it before falling back to
+ * regular FIFO reads.
+ *
+ * @flash:	SPI flash device
+ * @offset:	Offset into device in bytes to read from
+ * @len:	Number of bytes to read
+ * @buf:	Buffer to put the data that is read
+ * @return 0 if OK, -ENOTSUPP if this flash/range is not mapped, other -ve
+ *	value on error
+ */
+int spi_flash_dirmap_read(struct spi_flash *flash, u32 offset, size_t len,
+			  void *buf);
+#endif
+
 #ifdef CONFIG_DM_SPI_FLASH
 /**
  * spi_flash_read_dm() - Read data from SPI flash
@@ -30,6 +30,11 @@ uint32_t crc32 (uint32_t, const unsigned char *, uint);
 uint32_t crc32_wd (uint32_t, const unsigned char *, uint, uint);
 uint32_t crc32_no_comp (uint32_t, const unsigned char *, uint);
 
+#if defined(CONFIG_CRC32_ARMV8) && !defined(USE_HOSTCC)
+/* arch/arm/cpu/armv8/crc32.S, like crc32_no_comp() */
+uint32_t crc32_armv8(uint32_t crc, const unsigned char *buf, size_t len);
+#endif
+
 /**
  * crc32_wd_buf - Perform CRC32 on a buffer and return result in buffer
  *
@@ -101,6 +101,18 @@ void sha1_hmac(const unsigned char *key, int keylen,
  */
 int sha1_self_test( void );
 
+#if defined(CONFIG_SHA1_ARMV8_CE) && !defined(USE_HOSTCC)
+/**
+ * \brief	   Block function using the ARMv8 Crypto Extensions
+ *
+ * \param state    intermediate digest state
+ * \param data     consecutive 64-byte blocks to process
+ * \param blocks   number of blocks
+ */
+void sha1_ce_transform(uint32_t state[5], const unsigned char *data,
+		       unsigned int blocks);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,4 +22,10 @@ void sha256_finish(sha256_context * ctx, uint8_t digest[SHA256_SUM_LEN]);
 void sha256_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
+#if defined(CONFIG_SHA256_ARMV8_CE) && !defined(USE_HOSTCC)
+/* Block function using the ARMv8 Crypto Extensions */
+void sha256_ce_transform(uint32_t state[8], const uint8_t *data,
+			 unsigned int blocks);
+#endif
+
 #endif /* _SHA256_H */
@@ -13,6 +13,9 @@
 #else
 #include <common.h>
 #include <efi_loader.h>
+#ifdef CONFIG_CRC32_ARMV8
+#include <asm/system.h>
+#endif
 #endif
 #include <compiler.h>
 #include <u-boot/crc.h>
@@ -227,6 +230,19 @@ uint32_t __efi_runtime crc32(uint32_t crc, const Bytef *p, uInt len)
      return crc32_no_comp(crc ^ 0xffffffffL, p, len) ^ 0xffffffffL;
 }
 
+/*
+ * crc32() using the CPU's CRC32 instructions when it has them. crc32()
+ * itself is left alone as it is part of the EFI runtime services.
+ */
+static uint32_t crc32_fast(uint32_t crc, const Bytef *p, uInt len)
+{
+#if defined(CONFIG_CRC32_ARMV8) && !defined(USE_HOSTCC)
+	if (id_aa64isar0_field(ID_AA64ISAR0_CRC32_SHIFT))
+		return crc32_armv8(crc ^ 0xffffffffL, p, len) ^ 0xffffffffL;
+#endif
+	return crc32(crc, p, len);
+}
+
 /*
  * Calculate the crc32 checksum triggering the watchdog every 'chunk_sz' bytes
  * of input.
@@ -244,12 +260,12 @@ uint32_t crc32_wd(uint32_t crc, const unsigned char *buf, uInt len,
 		chunk = end - curr;
 		if (chunk > chunk_sz)
 			chunk = chunk_sz;
-		crc = crc32 (crc, curr, chunk);
+		crc = crc32_fast(crc, curr, chunk);
 		curr += chunk;
 		WATCHDOG_RESET ();
 	}
 #else
-	crc = crc32 (crc, buf, len);
+	crc = crc32_fast(crc, buf, len);
 #endif
 
 	return crc;
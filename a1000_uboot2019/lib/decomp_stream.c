@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Decompressing an image while it is being loaded
+ */
+
+#include <common.h>
+#include <decomp_stream.h>
+#include <image.h>
+#include <watchdog.h>
+
+int decomp_stream_detect(const void *buf, size_t len)
+{
+	const u8 *p = buf;
+
+	if (len >= 2 && p[0] == 0x1f && p[1] == 0x8b)
+		return IH_COMP_GZIP;
+	if (len >= 4 && p[0] == 0x04 && p[1] == 0x22 && p[2] == 0x4d &&
+	    p[3] == 0x18)
+		return IH_COMP_LZ4;
+	/* lc=3, lp=0, pb=2 as used by all the lzma tools, then a 2^n window */
+	if (len >= 3 && p[0] == 0x5d && p[1] == 0 && p[2] == 0)
+		return IH_COMP_LZMA;
+
+	return IH_COMP_NONE;
+}
+
+int decomp_stream_init(struct decomp_stream *ds, int comp, void *dst,
+		       size_t dst_max)
+{
+	memset(ds, '\0', sizeof(*ds));
+	ds->comp = comp;
+	ds->dst = dst;
+	ds->dst_max = dst_max;
+
+	switch (comp) {
+	case IH_COMP_NONE:
+		return 0;
+	case IH_COMP_GZIP:
+		if (IS_ENABLED(CONFIG_GZIP))
+			return gzip_stream_init(ds);
+		break;
+	case IH_COMP_LZ4:
+		if (IS_ENABLED(CONFIG_LZ4))
+			return ulz4_stream_init(ds);
+		break;
+	case IH_COMP_LZMA:
+		if (IS_ENABLED(CONFIG_LZMA))
+			return lzma_stream_init(ds);
+		break;
+	}
+
+	return -EPROTONOSUPPORT;
+}
+
+int decomp_stream_write(struct decomp_stream *ds, const void *src,
+			size_t len)
+{
+	size_t size;
+
+	if (ds->done)
+		return 0;
+	WATCHDOG_RESET();
+
+	switch (ds->comp) {
+	case IH_COMP_NONE:
+		size = min(len, ds->dst_max - ds->out);
+		memcpy(ds->dst + ds->out, src, size);
+		ds->out += size;
+		ds->in += size;
+		return size < len ? -ENOSPC : 0;
+	case IH_COMP_GZIP:
+		if (IS_ENABLED(CONFIG_GZIP))
+			return gzip_stream_write(ds, src, len);
+		break;
+	case IH_COMP_LZ4:
+		if (IS_ENABLED(CONFIG_LZ4))
+			return ulz4_stream_write(ds, src, len);
+		break;
+	case IH_COMP_LZMA:
+		if (IS_ENABLED(CONFIG_LZMA))
+			return lzma_stream_write(ds, src, len);
+		break;
+	}
+
+	return -EPROTONOSUPPORT;
+}
+
+int decomp_stream_finish(struct decomp_stream *ds)
+{
+	switch (ds->comp) {
+	case IH_COMP_NONE:
+		/* there is no end marker, all of the input is the image */
+		return 0;
+	case IH_COMP_GZIP:
+		if (IS_ENABLED(CONFIG_GZIP))
+			gzip_stream_finish(ds);
+		break;
+	case IH_COMP_LZ4:
+		if (IS_ENABLED(CONFIG_LZ4))
+			ulz4_stream_finish(ds);
+		break;
+	case IH_COMP_LZMA:
+		if (IS_ENABLED(CONFIG_LZMA))
+			lzma_stream_finish(ds);
+		break;
+	}
+
+	return ds->done ? 0 : -EPROTO;
+}
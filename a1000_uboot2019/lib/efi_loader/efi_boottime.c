@@ -10,6 +10,7 @@
 #include <efi_loader.h>
 #include <environment.h>
 #include <malloc.h>
+#include <smp_work.h>
 #include <linux/libfdt_env.h>
 #include <u-boot/crc.h>
 #include <bootm.h>
@@ -1957,6 +1958,7 @@ static efi_status_t EFIAPI efi_exit_boot_services(efi_handle_t image_handle,
 	/* TODO: Should persist EFI variables here */
 
 	board_quiesce_devices();
+	smp_work_stop();
 
 	/* Fix up caches for EFI payloads if necessary */
 	efi_exit_caches();
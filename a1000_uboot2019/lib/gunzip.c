@@ -8,6 +8,7 @@
 #include <watchdog.h>
 #include <command.h>
 #include <console.h>
+#include <decomp_stream.h>
 #include <image.h>
 #include <malloc.h>
 #include <memalign.h>
@@ -79,6 +80,74 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 	return zunzip(dst, dstlen, src, lenp, 1, offset);
 }
 
+#if CONFIG_IS_ENABLED(DECOMP_STREAM)
+int gzip_stream_init(struct decomp_stream *ds)
+{
+	z_stream *s;
+	int r;
+
+	s = calloc(1, sizeof(*s));
+	if (!s)
+		return -ENOMEM;
+	s->zalloc = gzalloc;
+	s->zfree = gzfree;
+
+	/* let zlib parse the gzip header and check the trailer */
+	r = inflateInit2(s, 16 + MAX_WBITS);
+	if (r != Z_OK) {
+		free(s);
+		return -ENOMEM;
+	}
+	s->next_out = ds->dst;
+	s->avail_out = ds->dst_max;
+	ds->priv = s;
+
+	return 0;
+}
+
+int gzip_stream_write(struct decomp_stream *ds, const void *src, size_t len)
+{
+	z_stream *s = ds->priv;
+	int r = Z_OK;
+
+	s->next_in = (unsigned char *)src;
+	s->avail_in = len;
+	while (s->avail_in) {
+		r = inflate(s, Z_NO_FLUSH);
+		if (r != Z_OK)
+			break;
+	}
+	ds->in = s->total_in;
+	ds->out = s->total_out;
+
+	switch (r) {
+	case Z_OK:
+		return 0;
+	case Z_STREAM_END:
+		ds->done = true;
+		return 0;
+	case Z_BUF_ERROR:
+		if (!s->avail_out)
+			return -ENOSPC;
+		return 0;
+	case Z_MEM_ERROR:
+		return -ENOMEM;
+	default:
+		debug("%s: inflate() returned %d\n", __func__, r);
+		return -EPROTO;
+	}
+}
+
+void gzip_stream_finish(struct decomp_stream *ds)
+{
+	z_stream *s = ds->priv;
+
+	inflateEnd(s);
+	free(s);
+	ds->priv = NULL;
+}
+#endif
+
 #ifdef CONFIG_CMD_UNZIP
 __weak
 void gzwrite_progress_init(u64 expectedsize)
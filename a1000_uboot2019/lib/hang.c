@@ -9,6 +9,7 @@
 
 #include <common.h>
 #include <bootstage.h>
+#include <serial.h>
 
 /**
  * hang - stop processing by staying in an endless loop
@@ -24,6 +25,9 @@ void hang(void)
 		(CONFIG_IS_ENABLED(LIBCOMMON_SUPPORT) && \
 		 CONFIG_IS_ENABLED(SERIAL_SUPPORT))
 	puts("### ERROR ### Please RESET the board ###\n");
+	/* Nothing drains buffered console output once we stop here */
+	if (CONFIG_IS_ENABLED(DM_SERIAL))
+		serial_flush();
 #endif
 	bootstage_error(BOOTSTAGE_ID_NEED_RESET);
 	for (;;)
@@ -46,6 +46,96 @@
 
 static void default_log(const char *ignored, char *response) {}
 
+/**
+ * sparse_write_fill() - Write @blkcnt blocks filled with @fill_val
+ *
+ * @info: Storage to write to
+ * @blk: First block to write, advanced past the blocks written
+ * @blkcnt: Number of blocks
+ * @fill_val: 32-bit pattern to fill the blocks with
+ * @response: Pointer to fastboot response buffer
+ *
+ * Return: 0 on success, -1 on error
+ */
+static int sparse_write_fill(struct sparse_storage *info, lbaint_t *blk,
+			     lbaint_t blkcnt, uint32_t fill_val,
+			     char *response)
+{
+	uint32_t *fill_buf;
+	int fill_buf_num_blks;
+	lbaint_t blks;
+	int i;
+	int j;
+
+	fill_buf_num_blks = CONFIG_IMAGE_SPARSE_FILLBUF_SIZE / info->blksz;
+
+	if (*blk + blkcnt > info->start + info->size) {
+		printf("%s: Request would exceed partition size!\n", __func__);
+		info->mssg("Request would exceed partition size!", response);
+		return -1;
+	}
+
+	/* a zero fill can be erased rather than written */
+	if (!fill_val && info->erase &&
+	    info->erase(info, *blk, blkcnt, true) == blkcnt) {
+		*blk += blkcnt;
+		return 0;
+	}
+
+	fill_buf = (uint32_t *)
+		   memalign(ARCH_DMA_MINALIGN,
+			    ROUNDUP(info->blksz * fill_buf_num_blks,
+				    ARCH_DMA_MINALIGN));
+	if (!fill_buf) {
+		info->mssg("Malloc failed for: CHUNK_TYPE_FILL", response);
+		return -1;
+	}
+
+	for (i = 0; i < (info->blksz * fill_buf_num_blks / sizeof(fill_val));
+	     i++)
+		fill_buf[i] = fill_val;
+
+	for (i = 0; i < blkcnt;) {
+		j = blkcnt - i;
+		if (j > fill_buf_num_blks)
+			j = fill_buf_num_blks;
+		blks = info->write(info, *blk, j, fill_buf);
+		/* blks might be > j (eg. NAND bad-blocks) */
+		if (blks < j) {
+			printf("%s: %s " LBAFU " [%d]\n", __func__,
+			       "Write failed, block #", *blk, j);
+			info->mssg("flash write failure", response);
+			free(fill_buf);
+			return -1;
+		}
+		*blk += blks;
+		i += j;
+	}
+
+	free(fill_buf);
+	return 0;
+}
+
+/**
+ * sparse_discard() - Let the storage discard the blocks of a don't care chunk
+ *
+ * @info: Storage to discard blocks of
+ * @blk: First block of the chunk
+ * @blkcnt: Number of blocks
+ * @chunk: Index of the chunk in the image
+ *
+ * A leading don't care chunk is kept: when the host splits a large image into
+ * several sparse images, each one starts by skipping the blocks written by
+ * the ones before.
+ */
+static void sparse_discard(struct sparse_storage *info, lbaint_t blk,
+			   lbaint_t blkcnt, unsigned int chunk)
+{
+	if (info->erase && chunk && blkcnt &&
+	    blk + blkcnt <= info->start + info->size)
+		info->erase(info, blk, blkcnt, false);
+}
+
 int write_sparse_image(struct sparse_storage *info,
 		       const char *part_name, void *data, char *response)
 {
@@ -56,16 +146,10 @@ int write_sparse_image(struct sparse_storage *info,
 	unsigned int chunk;
 	unsigned int offset;
 	unsigned int chunk_data_sz;
-	uint32_t *fill_buf = NULL;
 	uint32_t fill_val;
 	sparse_header_t *sparse_header;
 	chunk_header_t *chunk_header;
 	uint32_t total_blocks = 0;
-	int fill_buf_num_blks;
-	int i;
-	int j;
-
-	fill_buf_num_blks = CONFIG_IMAGE_SPARSE_FILLBUF_SIZE / info->blksz;
 
 	/* Read and skip over sparse image header */
 	sparse_header = (sparse_header_t *)data;
@@ -171,60 +255,18 @@ int write_sparse_image(struct sparse_storage *info,
 				return -1;
 			}
 
-			fill_buf = (uint32_t *)
-				   memalign(ARCH_DMA_MINALIGN,
-					    ROUNDUP(
-						info->blksz * fill_buf_num_blks,
-						ARCH_DMA_MINALIGN));
-			if (!fill_buf) {
-				info->mssg("Malloc failed for: CHUNK_TYPE_FILL",
-					   response);
-				return -1;
-			}
-
 			fill_val = *(uint32_t *)data;
 			data = (char *)data + sizeof(uint32_t);
 
-			for (i = 0;
-			     i < (info->blksz * fill_buf_num_blks /
-				  sizeof(fill_val));
-			     i++)
-				fill_buf[i] = fill_val;
-
-			if (blk + blkcnt > info->start + info->size) {
-				printf(
-				    "%s: Request would exceed partition size!\n",
-				    __func__);
-				info->mssg("Request would exceed partition size!",
-					   response);
+			if (sparse_write_fill(info, &blk, blkcnt, fill_val,
+					      response))
 				return -1;
-			}
-
-			for (i = 0; i < blkcnt;) {
-				j = blkcnt - i;
-				if (j > fill_buf_num_blks)
-					j = fill_buf_num_blks;
-				blks = info->write(info, blk, j, fill_buf);
-				/* blks might be > j (eg. NAND bad-blocks) */
-				if (blks < j) {
-					printf("%s: %s " LBAFU " [%d]\n",
-					       __func__,
-					       "Write failed, block #",
-					       blk, j);
-					info->mssg("flash write failure",
-						   response);
-					free(fill_buf);
-					return -1;
-				}
-				blk += blks;
-				i += j;
-			}
 			bytes_written += blkcnt * info->blksz;
 			total_blocks += chunk_data_sz / sparse_header->blk_sz;
-			free(fill_buf);
 			break;
 
 		case CHUNK_TYPE_DONT_CARE:
+			sparse_discard(info, blk, blkcnt, chunk);
 			blk += info->reserve(info, blk, blkcnt);
 			total_blocks += chunk_header->chunk_sz;
 			break;
@@ -259,3 +301,338 @@ int write_sparse_image(struct sparse_storage *info,
 
 	return 0;
 }
+
+/*
+ * Streaming: the image is written as it is received, in pieces of any size,
+ * so a header or a block may be split between two pieces.
+ */
+
+static void sparse_stream_fail(struct sparse_stream *ss, const char *str,
+			       char *response)
+{
+	ss->info->mssg(str, response);
+	ss->state = SPARSE_STREAM_ERROR;
+}
+
+/* Write @blkcnt whole blocks from @buf at the current position */
+static int sparse_stream_put(struct sparse_stream *ss, lbaint_t blkcnt,
+			     const void *buf, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	lbaint_t blks;
+
+	if (ss->blk + blkcnt > info->start + info->size) {
+		printf("%s: Request would exceed partition size!\n", __func__);
+		sparse_stream_fail(ss, "Request would exceed partition size!",
+				   response);
+		return -1;
+	}
+
+	blks = info->write(info, ss->blk, blkcnt, buf);
+	/* blks might be > blkcnt (eg. NAND bad-blocks) */
+	if (blks < blkcnt) {
+		printf("%s: %s" LBAFU " [" LBAFU "]\n", __func__,
+		       "Write failed, block #", ss->blk, blks);
+		sparse_stream_fail(ss, "flash write failure", response);
+		return -1;
+	}
+	ss->blk += blks;
+	ss->bytes_written += blkcnt * info->blksz;
+
+	return 0;
+}
+
+/*
+ * Write whole blocks of @len bytes of data straight from @data. A block
+ * that does not end within @data is collected in ss->part and written once
+ * the rest of it arrives. @used is set to the number of bytes taken.
+ */
+static int sparse_stream_blocks(struct sparse_stream *ss, const u8 *data,
+				u32 len, u32 *used, char *response)
+{
+	u32 blksz = ss->info->blksz;
+	lbaint_t blkcnt;
+
+	if (ss->part_len || len < blksz) {
+		*used = min(len, blksz - ss->part_len);
+		memcpy(ss->part + ss->part_len, data, *used);
+		ss->part_len += *used;
+		if (ss->part_len < blksz)
+			return 0;
+		ss->part_len = 0;
+		return sparse_stream_put(ss, 1, ss->part, response);
+	}
+
+	blkcnt = len / blksz;
+	*used = blkcnt * blksz;
+	return sparse_stream_put(ss, blkcnt, data, response);
+}
+
+static void sparse_stream_next_chunk(struct sparse_stream *ss)
+{
+	if (++ss->chunk_idx == ss->header.total_chunks)
+		ss->state = SPARSE_STREAM_END;
+	else
+		ss->state = SPARSE_STREAM_CHUNK;
+}
+
+/* Size of the header being received in ss->hdr */
+static u32 sparse_stream_hdr_size(struct sparse_stream *ss)
+{
+	switch (ss->state) {
+	case SPARSE_STREAM_HEADER:
+		return sizeof(sparse_header_t);
+	case SPARSE_STREAM_CHUNK:
+		return sizeof(chunk_header_t);
+	default:
+		return sizeof(uint32_t);
+	}
+}
+
+static void sparse_stream_file_header(struct sparse_stream *ss,
+				      char *response)
+{
+	sparse_header_t *sparse_header = &ss->header;
+
+	if (!is_sparse_image(ss->hdr)) {
+		puts("Flashing Raw Image\n");
+		/* the block size is at least sizeof(ss->hdr) */
+		memcpy(ss->part, ss->hdr, sizeof(ss->hdr));
+		ss->part_len = sizeof(ss->hdr);
+		ss->state = SPARSE_STREAM_IMAGE;
+		return;
+	}
+
+	memcpy(sparse_header, ss->hdr, sizeof(*sparse_header));
+	debug("=== Sparse Image Header ===\n");
+	debug("file_hdr_sz: %d\n", sparse_header->file_hdr_sz);
+	debug("chunk_hdr_sz: %d\n", sparse_header->chunk_hdr_sz);
+	debug("blk_sz: %d\n", sparse_header->blk_sz);
+	debug("total_blks: %d\n", sparse_header->total_blks);
+	debug("total_chunks: %d\n", sparse_header->total_chunks);
+
+	if (!sparse_header->blk_sz ||
+	    sparse_header->blk_sz % ss->info->blksz) {
+		printf("%s: Sparse image block size issue [%u]\n",
+		       __func__, sparse_header->blk_sz);
+		sparse_stream_fail(ss, "sparse image block size issue",
+				   response);
+		return;
+	}
+	if (sparse_header->file_hdr_sz < sizeof(sparse_header_t) ||
+	    sparse_header->chunk_hdr_sz < sizeof(chunk_header_t)) {
+		sparse_stream_fail(ss, "sparse image header size issue",
+				   response);
+		return;
+	}
+
+	puts("Flashing Sparse Image\n");
+	/* skip the remaining bytes of a header longer than we expected */
+	ss->skip = sparse_header->file_hdr_sz - sizeof(sparse_header_t);
+	if (sparse_header->total_chunks)
+		ss->state = SPARSE_STREAM_CHUNK;
+	else
+		ss->state = SPARSE_STREAM_END;
+}
+
+static void sparse_stream_chunk_header(struct sparse_stream *ss,
+				       char *response)
+{
+	struct sparse_storage *info = ss->info;
+	chunk_header_t *chunk_header = &ss->chunk;
+	u32 chunk_hdr_sz = ss->header.chunk_hdr_sz;
+	u64 chunk_data_sz;
+	lbaint_t blkcnt;
+
+	memcpy(chunk_header, ss->hdr, sizeof(*chunk_header));
+	if (chunk_header->chunk_type != CHUNK_TYPE_RAW) {
+		debug("=== Chunk Header ===\n");
+		debug("chunk_type: 0x%x\n", chunk_header->chunk_type);
+		debug("chunk_data_sz: 0x%x\n", chunk_header->chunk_sz);
+		debug("total_size: 0x%x\n", chunk_header->total_sz);
+	}
+
+	ss->skip = chunk_hdr_sz - sizeof(chunk_header_t);
+	chunk_data_sz = (u64)ss->header.blk_sz * chunk_header->chunk_sz;
+	blkcnt = chunk_data_sz / info->blksz;
+	ss->total_blocks += chunk_header->chunk_sz;
+
+	switch (chunk_header->chunk_type) {
+	case CHUNK_TYPE_RAW:
+		if (chunk_header->total_sz != chunk_hdr_sz + chunk_data_sz) {
+			sparse_stream_fail(ss, "Bogus chunk size for chunk type Raw",
+					   response);
+			return;
+		}
+		if (ss->blk + blkcnt > info->start + info->size) {
+			printf("%s: Request would exceed partition size!\n",
+			       __func__);
+			sparse_stream_fail(ss,
+					   "Request would exceed partition size!",
+					   response);
+			return;
+		}
+		ss->left = chunk_data_sz;
+		ss->state = SPARSE_STREAM_DATA;
+		if (!ss->left)
+			sparse_stream_next_chunk(ss);
+		break;
+
+	case CHUNK_TYPE_FILL:
+		if (chunk_header->total_sz != chunk_hdr_sz + sizeof(uint32_t)) {
+			sparse_stream_fail(ss, "Bogus chunk size for chunk type FILL",
+					   response);
+			return;
+		}
+		ss->state = SPARSE_STREAM_FILL;
+		break;
+
+	case CHUNK_TYPE_DONT_CARE:
+		sparse_discard(info, ss->blk, blkcnt, ss->chunk_idx);
+		ss->blk += info->reserve(info, ss->blk, blkcnt);
+		sparse_stream_next_chunk(ss);
+		break;
+
+	case CHUNK_TYPE_CRC32:
+		if (chunk_header->total_sz < chunk_hdr_sz) {
+			sparse_stream_fail(ss, "Bogus chunk size for chunk type CRC32",
+					   response);
+			return;
+		}
+		ss->skip += chunk_header->total_sz - chunk_hdr_sz;
+		sparse_stream_next_chunk(ss);
+		break;
+
+	default:
+		printf("%s: Unknown chunk type: %x\n", __func__,
+		       chunk_header->chunk_type);
+		sparse_stream_fail(ss, "Unknown chunk type", response);
+	}
+}
+
+static void sparse_stream_fill(struct sparse_stream *ss, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	lbaint_t blkcnt;
+	uint32_t fill_val;
+
+	memcpy(&fill_val, ss->hdr, sizeof(fill_val));
+	blkcnt = (u64)ss->header.blk_sz * ss->chunk.chunk_sz / info->blksz;
+	if (sparse_write_fill(info, &ss->blk, blkcnt, fill_val, response)) {
+		ss->state = SPARSE_STREAM_ERROR;
+		return;
+	}
+	ss->bytes_written += blkcnt * info->blksz;
+	sparse_stream_next_chunk(ss);
+}
+
+int sparse_stream_init(struct sparse_stream *ss, struct sparse_storage *info,
+		       char *response)
+{
+	memset(ss, 0, sizeof(*ss));
+	ss->info = info;
+	ss->blk = info->start;
+	ss->state = SPARSE_STREAM_HEADER;
+
+	if (!info->mssg)
+		info->mssg = default_log;
+
+	if (info->blksz < sizeof(ss->hdr) ||
+	    info->blksz > SPARSE_STREAM_MAX_BLKSZ) {
+		printf("%s: Unsupported block size " LBAFU "\n", __func__,
+		       info->blksz);
+		sparse_stream_fail(ss, "unsupported block size", response);
+		return -1;
+	}
+
+	return 0;
+}
+
+int sparse_stream_write(struct sparse_stream *ss, const void *data,
+			u32 len, char *response)
+{
+	const u8 *buf = data;
+	u32 n;
+
+	while (len && ss->state != SPARSE_STREAM_ERROR) {
+		n = len;
+		if (ss->skip) {
+			n = min(n, ss->skip);
+			ss->skip -= n;
+		} else if (ss->state == SPARSE_STREAM_IMAGE) {
+			sparse_stream_blocks(ss, buf, n, &n, response);
+		} else if (ss->state == SPARSE_STREAM_DATA) {
+			n = min_t(u64, n, ss->left);
+			sparse_stream_blocks(ss, buf, n, &n, response);
+			ss->left -= n;
+			if (!ss->left && ss->state != SPARSE_STREAM_ERROR)
+				sparse_stream_next_chunk(ss);
+		} else if (ss->state != SPARSE_STREAM_END) {
+			n = min(n, sparse_stream_hdr_size(ss) - ss->hdr_len);
+			memcpy(ss->hdr + ss->hdr_len, buf, n);
+			ss->hdr_len += n;
+			if (ss->hdr_len == sparse_stream_hdr_size(ss)) {
+				ss->hdr_len = 0;
+				if (ss->state == SPARSE_STREAM_HEADER)
+					sparse_stream_file_header(ss, response);
+				else if (ss->state == SPARSE_STREAM_CHUNK)
+					sparse_stream_chunk_header(ss,
+								   response);
+				else
+					sparse_stream_fill(ss, response);
+			}
+		}
+		/* anything after the last chunk is ignored */
+		buf += n;
+		len -= n;
+	}
+
+	return ss->state == SPARSE_STREAM_ERROR ? -1 : 0;
+}
+
+int sparse_stream_finish(struct sparse_stream *ss, const char *part_name,
+			 char *response)
+{
+	struct sparse_storage *info = ss->info;
+
+	/* a raw image shorter than a sparse header */
+	if (ss->state == SPARSE_STREAM_HEADER) {
+		memcpy(ss->part, ss->hdr, ss->hdr_len);
+		ss->part_len = ss->hdr_len;
+		ss->state = SPARSE_STREAM_IMAGE;
+	}
+
+	switch (ss->state) {
+	case SPARSE_STREAM_ERROR:
+		return -1;
+
+	case SPARSE_STREAM_IMAGE:
+		if (ss->part_len) {
+			memset(ss->part + ss->part_len, 0,
+			       info->blksz - ss->part_len);
+			ss->part_len = 0;
+			if (sparse_stream_put(ss, 1, ss->part, response))
+				return -1;
+		}
+		break;
+
+	case SPARSE_STREAM_END:
+		debug("Wrote %d blocks, expected to write %d blocks\n",
+		      ss->total_blocks, ss->header.total_blks);
+		if (ss->total_blocks != ss->header.total_blks) {
+			sparse_stream_fail(ss, "sparse image write failure",
+					   response);
+			return -1;
+		}
+		break;
+
+	default:
+		sparse_stream_fail(ss, "incomplete sparse image", response);
+		return -1;
+	}
+
+	printf("........ wrote %llu bytes to '%s'\n",
+	       (unsigned long long)ss->bytes_written, part_name);
+
+	return 0;
+}
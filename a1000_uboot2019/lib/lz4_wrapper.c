@@ -5,6 +5,10 @@
 
 #include <common.h>
 #include <compiler.h>
+#include <decomp_stream.h>
+#include <malloc.h>
+#include <smp_work.h>
+#include <asm/unaligned.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
 
@@ -62,11 +66,115 @@ struct lz4_block_header {
 	/* + u32 block_checksum iff has_block_checksum is set */
 } __packed;
 
+struct lz4_smp_block {
+	const void *in;
+	struct lz4_block_header b;
+	int ret;		/* bytes of output, or -ve on error */
+};
+
+struct lz4_smp {
+	struct lz4_smp_block *blocks;
+	void *dst;
+	size_t dstn;
+	size_t block_max;
+};
+
+static void ulz4fn_smp_block(void *priv, uint item)
+{
+	struct lz4_smp *s = priv;
+	struct lz4_smp_block *blk = &s->blocks[item];
+	size_t pos = item * s->block_max;
+	size_t size = min(s->dstn - pos, s->block_max);
+	void *out = s->dst + pos;
+
+	if (blk->b.not_compressed) {
+		if (blk->b.size > size) {
+			blk->ret = -ENOBUFS;
+			return;
+		}
+		memcpy(out, blk->in, blk->b.size);
+		blk->ret = blk->b.size;
+	} else {
+		/* constant folding essential, do not touch params! */
+		blk->ret = LZ4_decompress_generic(blk->in, out, blk->b.size,
+				size, endOnInputSize,
+				full, 0, noDict, out, NULL, 0);
+	}
+}
+
+/*
+ * Decompress the blocks of a frame on all CPUs. Each block but the last
+ * one decompresses to the maximum block size, so where its output goes is
+ * known up front. Frames which turn out not to be like that, and in-place
+ * decompression, return -EAGAIN and are left to the serial loop.
+ */
+static int ulz4fn_smp(const void *src, size_t srcn, const void *in,
+		      int has_block_checksum, size_t block_max,
+		      void *dst, const void *end, size_t *dstn)
+{
+	struct lz4_smp s = {
+		.dst = dst,
+		.dstn = end - dst,
+		.block_max = block_max,
+	};
+	struct lz4_block_header b;
+	uint count, i;
+	size_t size;
+	int ret;
+
+	if (!block_max || (src < end && dst < src + srcn))
+		return -EAGAIN;
+
+	for (count = 0, size = in - src; ; count++) {
+		if (size + sizeof(b) > srcn)
+			return -EAGAIN;
+		b.raw = le32_to_cpu(*(u32 *)(src + size));
+		size += sizeof(b);
+		if (!b.size)
+			break;
+		size += b.size;
+		if (has_block_checksum)
+			size += sizeof(u32);
+		if (size > srcn)
+			return -EAGAIN;
+	}
+	if (count < 2 || (count - 1) * block_max >= s.dstn)
+		return -EAGAIN;
+
+	s.blocks = malloc(count * sizeof(*s.blocks));
+	if (!s.blocks)
+		return -EAGAIN;
+	for (i = 0; i < count; i++) {
+		s.blocks[i].b.raw = le32_to_cpu(*(u32 *)in);
+		in += sizeof(b);
+		s.blocks[i].in = in;
+		in += s.blocks[i].b.size;
+		if (has_block_checksum)
+			in += sizeof(u32);
+	}
+
+	smp_work_run(ulz4fn_smp_block, &s, count);
+
+	ret = 0;
+	for (i = 0; i < count - 1; i++) {
+		if (s.blocks[i].ret != block_max)
+			ret = -EAGAIN;
+	}
+	if (s.blocks[i].ret < 0)
+		ret = -EAGAIN;
+	if (!ret)
+		*dstn = i * block_max + s.blocks[i].ret;
+	free(s.blocks);
+
+	return ret;
+}
+
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 {
 	const void *end = dst + *dstn;
 	const void *in = src;
 	void *out = dst;
+	size_t block_max = 0;
 	int has_block_checksum;
 	int ret;
 	*dstn = 0;
@@ -85,6 +193,9 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 		if (!h->independent_blocks)
 			return -EPROTONOSUPPORT; /* we can't support this yet */
 		has_block_checksum = h->has_block_checksum;
+		/* 64 KiB to 4 MiB, smaller values are reserved */
+		if (h->max_block_size >= 4)
+			block_max = 1 << (8 + 2 * h->max_block_size);
 
 		in += sizeof(*h);
 		if (h->has_content_size)
@@ -92,6 +203,13 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 		in += sizeof(u8);
 	}
 
+	if (CONFIG_IS_ENABLED(SMP_WORK)) {
+		ret = ulz4fn_smp(src, srcn, in, has_block_checksum, block_max,
+				 dst, end, dstn);
+		if (ret != -EAGAIN)
+			return ret;
+	}
+
 	while (1) {
 		struct lz4_block_header b;
 
@@ -136,3 +254,194 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 	*dstn = out - dst;
 	return ret;
 }
+
+#if CONFIG_IS_ENABLED(DECOMP_STREAM)
+enum ulz4_stream_state {
+	ULZ4S_FRAME_HEADER,
+	ULZ4S_BLOCK_HEADER,
+	ULZ4S_BLOCK,
+	ULZ4S_BLOCK_CHECKSUM,
+};
+
+struct ulz4_stream {
+	enum ulz4_stream_state state;
+	/* frame header, block header or checksum being collected */
+	u8 hdr[sizeof(struct lz4_frame_header) + sizeof(u64) + sizeof(u8)];
+	size_t hdr_len;
+	size_t have;		/* bytes collected in hdr or buf */
+	int has_block_checksum;
+	size_t block_max;
+	struct lz4_block_header b;
+	void *buf;		/* blocks split between two writes */
+	size_t buf_size;
+};
+
+static int ulz4_stream_frame(struct ulz4_stream *us)
+{
+	const struct lz4_frame_header *h = (void *)us->hdr;
+
+	if (le32_to_cpu(h->magic) != LZ4F_MAGIC || h->version != 1)
+		return -EPROTONOSUPPORT;
+	if (h->reserved0 || h->reserved1 || h->reserved2)
+		return -EINVAL;
+	if (!h->independent_blocks)
+		return -EPROTONOSUPPORT;
+	us->has_block_checksum = h->has_block_checksum;
+	if (h->max_block_size >= 4)
+		us->block_max = 1 << (8 + 2 * h->max_block_size);
+
+	return 0;
+}
+
+static int ulz4_stream_block(struct decomp_stream *ds, struct ulz4_stream *us,
+			     const void *in)
+{
+	void *out = ds->dst + ds->out;
+	size_t avail = ds->dst_max - ds->out;
+	int ret;
+
+	if (us->b.not_compressed) {
+		if (us->b.size > avail)
+			return -ENOSPC;
+		memcpy(out, in, us->b.size);
+		ds->out += us->b.size;
+		return 0;
+	}
+
+	/* constant folding essential, do not touch params! */
+	ret = LZ4_decompress_generic(in, out, us->b.size,
+			avail, endOnInputSize,
+			full, 0, noDict, out, NULL, 0);
+	if (ret < 0) {
+		/* a block which might not fit is most likely cut short */
+		if (!avail || (us->block_max && avail < us->block_max))
+			return -ENOSPC;
+		return -EPROTO;
+	}
+	ds->out += ret;
+
+	return 0;
+}
+
+/* Collect a header or checksum in us->hdr, true once it is complete */
+static bool ulz4_stream_collect(struct ulz4_stream *us, const void **srcp,
+				const void *end)
+{
+	size_t size = min((size_t)(end - *srcp), us->hdr_len - us->have);
+
+	memcpy(us->hdr + us->have, *srcp, size);
+	*srcp += size;
+	us->have += size;
+
+	return us->have == us->hdr_len;
+}
+
+int ulz4_stream_init(struct decomp_stream *ds)
+{
+	struct ulz4_stream *us;
+
+	us = calloc(1, sizeof(*us));
+	if (!us)
+		return -ENOMEM;
+	us->hdr_len = sizeof(struct lz4_frame_header) + sizeof(u8);
+	ds->priv = us;
+
+	return 0;
+}
+
+/*
+ * Blocks which arrive in one piece are decompressed from the input. Only
+ * those split between two writes are collected in a buffer first.
+ */
+int ulz4_stream_write(struct decomp_stream *ds, const void *src, size_t len)
+{
+	struct ulz4_stream *us = ds->priv;
+	const struct lz4_frame_header *h;
+	const void *end = src + len;
+	size_t size;
+	int ret;
+
+	while (src < end && !ds->done) {
+		switch (us->state) {
+		case ULZ4S_FRAME_HEADER:
+			if (!ulz4_stream_collect(us, &src, end))
+				break;
+			/* the frame header is longer with a content size */
+			h = (void *)us->hdr;
+			if (h->has_content_size &&
+			    us->hdr_len < sizeof(us->hdr)) {
+				us->hdr_len = sizeof(us->hdr);
+				break;
+			}
+			ret = ulz4_stream_frame(us);
+			if (ret)
+				return ret;
+			us->state = ULZ4S_BLOCK_HEADER;
+			us->hdr_len = sizeof(struct lz4_block_header);
+			us->have = 0;
+			break;
+		case ULZ4S_BLOCK_HEADER:
+			if (!ulz4_stream_collect(us, &src, end))
+				break;
+			us->b.raw = get_unaligned_le32(us->hdr);
+			us->have = 0;
+			if (!us->b.size)
+				ds->done = true;
+			else if (us->block_max && us->b.size > us->block_max)
+				return -EPROTO;
+			else
+				us->state = ULZ4S_BLOCK;
+			break;
+		case ULZ4S_BLOCK:
+			if (!us->have && end - src >= us->b.size) {
+				ret = ulz4_stream_block(ds, us, src);
+				src += us->b.size;
+			} else {
+				if (us->buf_size < us->b.size) {
+					free(us->buf);
+					us->buf_size = us->block_max ?:
+						       us->b.size;
+					us->buf = malloc(us->buf_size);
+					if (!us->buf) {
+						us->buf_size = 0;
+						return -ENOMEM;
+					}
+				}
+				size = min((size_t)(end - src),
+					   us->b.size - us->have);
+				memcpy(us->buf + us->have, src, size);
+				src += size;
+				us->have += size;
+				if (us->have < us->b.size)
+					break;
+				ret = ulz4_stream_block(ds, us, us->buf);
+			}
+			if (ret)
+				return ret;
+			us->have = 0;
+			us->state = us->has_block_checksum ?
+				    ULZ4S_BLOCK_CHECKSUM : ULZ4S_BLOCK_HEADER;
+			break;
+		case ULZ4S_BLOCK_CHECKSUM:
+			/* not checked, like in ulz4fn() */
+			if (!ulz4_stream_collect(us, &src, end))
+				break;
+			us->have = 0;
+			us->state = ULZ4S_BLOCK_HEADER;
+			break;
+		}
+	}
+	ds->in += len - (end - src);
+
+	return 0;
+}
+
+void ulz4_stream_finish(struct decomp_stream *ds)
+{
+	struct ulz4_stream *us = ds->priv;
+
+	free(us->buf);
+	free(us);
+	ds->priv = NULL;
+}
+#endif
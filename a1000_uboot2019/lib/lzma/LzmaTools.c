@@ -30,6 +30,7 @@
 #include "LzmaTools.h"
 #include "LzmaDec.h"
 
+#include <decomp_stream.h>
 #include <linux/string.h>
 #include <malloc.h>
 
@@ -120,4 +121,105 @@ int lzmaBuffToBuffDecompress (unsigned char *outStream, SizeT *uncompressedSize,
     return res;
 }
 
+#if CONFIG_IS_ENABLED(DECOMP_STREAM)
+struct lzma_stream {
+    CLzmaDec dec;
+    ISzAlloc alloc;
+    unsigned char hdr[LZMA_DATA_OFFSET];
+    size_t have;        /* header bytes collected */
+    SizeT limit;        /* uncompressed size, or the buffer size if unknown */
+    bool known_size;
+};
+
+int lzma_stream_init(struct decomp_stream *ds)
+{
+    struct lzma_stream *ls;
+
+    ls = calloc(1, sizeof(*ls));
+    if (!ls)
+        return -ENOMEM;
+    ls->alloc.Alloc = SzAlloc;
+    ls->alloc.Free = SzFree;
+    LzmaDec_Construct(&ls->dec);
+    ds->priv = ls;
+
+    return 0;
+}
+
+static int lzma_stream_header(struct decomp_stream *ds, struct lzma_stream *ls)
+{
+    UInt64 size = 0;
+    int i;
+
+    for (i = 7; i >= 0; i--)
+        size = size << 8 | ls->hdr[LZMA_SIZE_OFFSET + i];
+
+    /* all ones is "unknown size", the stream then has an end marker */
+    ls->known_size = size != (UInt64)-1;
+    if (ls->known_size && size > ds->dst_max)
+        return -ENOSPC;
+    ls->limit = ls->known_size ? (SizeT)size : ds->dst_max;
+
+    if (LzmaDec_AllocateProbs(&ls->dec, ls->hdr, LZMA_PROPS_SIZE,
+                              &ls->alloc) != SZ_OK)
+        return -EPROTO;
+    /* the output buffer is the dictionary, so nothing is copied */
+    ls->dec.dic = ds->dst;
+    ls->dec.dicBufSize = ds->dst_max;
+    LzmaDec_Init(&ls->dec);
+
+    return 0;
+}
+
+int lzma_stream_write(struct decomp_stream *ds, const void *src, size_t len)
+{
+    struct lzma_stream *ls = ds->priv;
+    ELzmaStatus status;
+    SizeT in_len;
+    size_t size;
+    int ret;
+
+    if (ls->have < LZMA_DATA_OFFSET) {
+        size = min(len, LZMA_DATA_OFFSET - ls->have);
+        memcpy(ls->hdr + ls->have, src, size);
+        ls->have += size;
+        ds->in += size;
+        src += size;
+        len -= size;
+        if (ls->have < LZMA_DATA_OFFSET)
+            return 0;
+        ret = lzma_stream_header(ds, ls);
+        if (ret)
+            return ret;
+    }
+
+    in_len = len;
+    ret = LzmaDec_DecodeToDic(&ls->dec, ls->limit, src, &in_len,
+                              LZMA_FINISH_ANY, &status);
+    ds->in += in_len;
+    ds->out = ls->dec.dicPos;
+    if (ret != SZ_OK) {
+        debug("%s: LzmaDec_DecodeToDic() returned %d\n", __func__, ret);
+        return ret == SZ_ERROR_MEM ? -ENOMEM : -EPROTO;
+    }
+
+    if (status == LZMA_STATUS_FINISHED_WITH_MARK ||
+        (ls->known_size && ls->dec.dicPos == ls->limit))
+        ds->done = true;
+    else if (ls->dec.dicPos == ls->limit)
+        return -ENOSPC;
+
+    return 0;
+}
+
+void lzma_stream_finish(struct decomp_stream *ds)
+{
+    struct lzma_stream *ls = ds->priv;
+
+    LzmaDec_FreeProbs(&ls->dec, &ls->alloc);
+    free(ls);
+    ds->priv = NULL;
+}
+#endif
+
 #endif
@@ -0,0 +1,365 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * High-bandwidth memory test engine
+ *
+ * A region is cut into chunks, which are the items of smp_work_run() jobs.
+ * Each pass over the region is a separate job, so all CPUs have finished
+ * writing before any of them reads back. The inner loops handle a whole
+ * 64-byte line of 64-bit words at a time, which the compiler turns into
+ * LDP/STP pairs on ARMv8.
+ *
+ * The MATS+ march reads and then writes a line at a time rather than a word
+ * at a time, and a descending element only descends within each chunk.
+ * This still finds stuck-at faults and address decoder faults, which are
+ * what the test is for.
+ */
+
+#include <common.h>
+#include <console.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <memtest.h>
+#include <smp_work.h>
+#include <watchdog.h>
+#include <linux/sizes.h>
+
+/* Items of a job, small enough to balance the load over the CPUs */
+#define MEMTEST_CHUNK_SIZE	SZ_16M
+
+#define LINE_WORDS		(MEMTEST_LINE_SIZE / sizeof(u64))
+
+struct memtest_chunk {
+	ulong addr;
+	u64 *buf;
+	ulong size;
+	ulong errors;
+	uint nfails;
+	struct memtest_fail fail[MEMTEST_MAX_FAILS];
+};
+
+/**
+ * struct memtest_pass - A pass over all chunks of a region
+ *
+ * @chunks:	Chunks of the region
+ * @expect:	Value expected when reading, or XOR applied to the address
+ * @write:	Value written, or XOR applied to the address
+ * @zva:	Use arch_memtest_zero() to write zero
+ */
+struct memtest_pass {
+	struct memtest_chunk *chunks;
+	u64 expect;
+	u64 write;
+	bool zva;
+};
+
+/**
+ * struct memtest_step - A pass of one of the algorithms
+ *
+ * @alg:	MEMTEST_... algorithm the pass belongs to
+ * @fn:		Function run for each chunk
+ * @expect:	Value for struct memtest_pass
+ * @write:	Value for struct memtest_pass
+ * @reads:	Number of times each word is read
+ * @writes:	Number of times each word is written
+ */
+struct memtest_step {
+	uint alg;
+	smp_work_fn fn;
+	u64 expect;
+	u64 write;
+	u8 reads;
+	u8 writes;
+};
+
+__weak void arch_memtest_zero(void *buf, ulong size)
+{
+	memset(buf, '\0', size);
+}
+
+__weak void arch_memtest_inject(ulong start, ulong size)
+{
+}
+
+static noinline void memtest_record(struct memtest_chunk *c, const u64 *p,
+				    u64 expect, u64 actual)
+{
+	struct memtest_fail *fail;
+
+	c->errors++;
+	if (c->nfails == MEMTEST_MAX_FAILS)
+		return;
+	fail = &c->fail[c->nfails++];
+	fail->addr = c->addr + ((ulong)p - (ulong)c->buf);
+	fail->expect = expect;
+	fail->actual = actual;
+}
+
+/* Find the failing words in a copy of a line, which is not read again */
+static noinline void memtest_check_line(struct memtest_chunk *c, const u64 *p,
+					const u64 *line, u64 expect, bool addr)
+{
+	u64 want;
+	uint i;
+
+	for (i = 0; i < LINE_WORDS; i++) {
+		want = expect;
+		if (addr)
+			want ^= c->addr + ((ulong)&p[i] - (ulong)c->buf);
+		if (line[i] != want)
+			memtest_record(c, &p[i], want, line[i]);
+	}
+}
+
+static void memtest_fill(void *priv, uint item)
+{
+	struct memtest_pass *pass = priv;
+	struct memtest_chunk *c = &pass->chunks[item];
+	u64 *p, *end = c->buf + c->size / sizeof(u64);
+	u64 val = pass->write;
+	uint i;
+
+	if (pass->zva && !val) {
+		arch_memtest_zero(c->buf, c->size);
+		return;
+	}
+	for (p = c->buf; p < end; p += LINE_WORDS) {
+		for (i = 0; i < LINE_WORDS; i++)
+			p[i] = val;
+	}
+}
+
+static void memtest_march(struct memtest_pass *pass, uint item, bool down)
+{
+	struct memtest_chunk *c = &pass->chunks[item];
+	ulong n, lines = c->size / MEMTEST_LINE_SIZE;
+	u64 expect = pass->expect, val = pass->write;
+	u64 line[LINE_WORDS], diff, *p;
+	uint i;
+
+	for (n = 0; n < lines; n++) {
+		p = c->buf + (down ? lines - 1 - n : n) * LINE_WORDS;
+		diff = 0;
+		for (i = 0; i < LINE_WORDS; i++) {
+			line[i] = p[i];
+			diff |= line[i] ^ expect;
+		}
+		if (unlikely(diff))
+			memtest_check_line(c, p, line, expect, false);
+		for (i = 0; i < LINE_WORDS; i++)
+			p[i] = val;
+	}
+}
+
+static void memtest_march_up(void *priv, uint item)
+{
+	memtest_march(priv, item, false);
+}
+
+static void memtest_march_down(void *priv, uint item)
+{
+	memtest_march(priv, item, true);
+}
+
+static void memtest_addr_fill(void *priv, uint item)
+{
+	struct memtest_pass *pass = priv;
+	struct memtest_chunk *c = &pass->chunks[item];
+	u64 *p, *end = c->buf + c->size / sizeof(u64);
+	u64 addr = c->addr, val = pass->write;
+	uint i;
+
+	for (p = c->buf; p < end; p += LINE_WORDS, addr += MEMTEST_LINE_SIZE) {
+		for (i = 0; i < LINE_WORDS; i++)
+			p[i] = (addr + i * sizeof(u64)) ^ val;
+	}
+}
+
+static void memtest_addr_check(void *priv, uint item)
+{
+	struct memtest_pass *pass = priv;
+	struct memtest_chunk *c = &pass->chunks[item];
+	u64 *p, *end = c->buf + c->size / sizeof(u64);
+	u64 addr = c->addr, expect = pass->expect;
+	u64 line[LINE_WORDS], diff;
+	uint i;
+
+	for (p = c->buf; p < end; p += LINE_WORDS, addr += MEMTEST_LINE_SIZE) {
+		diff = 0;
+		for (i = 0; i < LINE_WORDS; i++) {
+			line[i] = p[i];
+			diff |= line[i] ^ (addr + i * sizeof(u64)) ^ expect;
+		}
+		if (unlikely(diff))
+			memtest_check_line(c, p, line, expect, true);
+	}
+}
+
+static const struct memtest_step memtest_steps[] = {
+	/* MATS+: either way (w0); up (r0, w1); down (r1, w0) */
+	{ MEMTEST_MATS, memtest_fill, 0, 0, 0, 1 },
+	{ MEMTEST_MATS, memtest_march_up, 0, ~0ULL, 1, 1 },
+	{ MEMTEST_MATS, memtest_march_down, ~0ULL, 0, 1, 1 },
+	/* each word holds its own address, then the inverse of it */
+	{ MEMTEST_ADDR, memtest_addr_fill, 0, 0, 0, 1 },
+	{ MEMTEST_ADDR, memtest_addr_check, 0, 0, 1, 0 },
+	{ MEMTEST_ADDR, memtest_addr_fill, 0, ~0ULL, 0, 1 },
+	{ MEMTEST_ADDR, memtest_addr_check, ~0ULL, 0, 1, 0 },
+};
+
+/*
+ * Write the line holding a word back to DRAM and drop it from the D-cache,
+ * so that the next read of it goes out on the bus
+ */
+static void memtest_sync(volatile u64 *p)
+{
+	ulong line = ALIGN_DOWN((ulong)p, MEMTEST_LINE_SIZE);
+
+	flush_dcache_range(line, line + MEMTEST_LINE_SIZE);
+}
+
+/* Sync word 0 and the words at power-of-two offsets */
+static void memtest_sync_walk(volatile u64 *p, ulong words)
+{
+	ulong off;
+
+	for (off = 0; off < words; off = off ? off << 1 : 1)
+		memtest_sync(&p[off]);
+}
+
+/*
+ * Walking 1s and 0s on the data bus, using the first word of the region,
+ * and a walking 1 on the address bus, using the words at power-of-two
+ * offsets. This runs on the boot CPU and takes very little time. The few
+ * lines used are written back and dropped from the D-cache before each
+ * read, or the reads would be served by the cache and never reach the
+ * DRAM data and address lines.
+ */
+static void memtest_walk(struct memtest_chunk *c)
+{
+	const u64 pattern = 0xaaaaaaaaaaaaaaaaULL, anti = ~pattern;
+	volatile u64 *p = c->buf;
+	ulong words = c->size / sizeof(u64);
+	ulong off, test;
+	u64 val, want;
+	uint bit;
+
+	for (bit = 0; bit < 128; bit++) {
+		want = 1ULL << (bit % 64);
+		if (bit >= 64)
+			want = ~want;
+		p[0] = want;
+		/* drive the opposite value onto the bus before reading back */
+		p[1] = ~want;
+		memtest_sync(p);
+		arch_memtest_inject(c->addr, MEMTEST_LINE_SIZE);
+		val = p[0];
+		if (val != want)
+			memtest_record(c, (u64 *)&p[0], want, val);
+	}
+
+	/* Address lines stuck high or shorted show up as aliases of word 0 */
+	for (off = 1; off < words; off <<= 1)
+		p[off] = pattern;
+	p[0] = anti;
+	memtest_sync_walk(p, words);
+	arch_memtest_inject(c->addr, c->size);
+	for (off = 1; off < words; off <<= 1) {
+		val = p[off];
+		if (val != pattern)
+			memtest_record(c, (u64 *)&p[off], pattern, val);
+	}
+	p[0] = pattern;
+
+	/* Address lines stuck low make other words alias the one written */
+	for (test = 1; test < words; test <<= 1) {
+		p[test] = anti;
+		memtest_sync_walk(p, words);
+		arch_memtest_inject(c->addr, c->size);
+		for (off = 0; off < words; off = off ? off << 1 : 1) {
+			want = off == test ? anti : pattern;
+			val = p[off];
+			if (val != want)
+				memtest_record(c, (u64 *)&p[off], want, val);
+		}
+		p[test] = pattern;
+	}
+}
+
+static void memtest_add(struct memtest_result *res,
+			const struct memtest_chunk *c)
+{
+	uint i;
+
+	res->errors += c->errors;
+	for (i = 0; i < c->nfails && res->nfails < MEMTEST_MAX_FAILS; i++)
+		res->fail[res->nfails++] = c->fail[i];
+}
+
+int memtest_run(ulong start, ulong size, uint flags,
+		struct memtest_result *res)
+{
+	struct memtest_pass pass = { .zva = flags & MEMTEST_ZVA };
+	const struct memtest_step *step;
+	struct memtest_chunk *chunks, *c;
+	uint i, nchunks;
+	ulong begin;
+	int ret = 0;
+
+	memset(res, '\0', sizeof(*res));
+	res->cpus = 1;
+	if (!size || ((start | size) & (MEMTEST_LINE_SIZE - 1)))
+		return -EINVAL;
+
+	nchunks = DIV_ROUND_UP(size, MEMTEST_CHUNK_SIZE);
+	chunks = calloc(nchunks, sizeof(*chunks));
+	if (!chunks)
+		return -ENOMEM;
+	for (i = 0; i < nchunks; i++) {
+		c = &chunks[i];
+		c->addr = start + (ulong)i * MEMTEST_CHUNK_SIZE;
+		c->size = min_t(ulong, start + size - c->addr,
+				MEMTEST_CHUNK_SIZE);
+		c->buf = map_sysmem(c->addr, c->size);
+	}
+	pass.chunks = chunks;
+
+	if (flags & MEMTEST_WALK) {
+		struct memtest_chunk bus = {
+			.addr = start,
+			.size = size,
+			.buf = map_sysmem(start, size),
+		};
+
+		memtest_walk(&bus);
+		unmap_sysmem(bus.buf);
+		memtest_add(res, &bus);
+	}
+
+	begin = timer_get_us();
+	for (step = memtest_steps; step < memtest_steps +
+	     ARRAY_SIZE(memtest_steps); step++) {
+		if (!(flags & step->alg))
+			continue;
+		if (ctrlc()) {
+			ret = -EINTR;
+			break;
+		}
+		WATCHDOG_RESET();
+
+		pass.expect = step->expect;
+		pass.write = step->write;
+		res->cpus = smp_work_run(step->fn, &pass, nchunks);
+		res->bytes += (u64)size * (step->reads + step->writes);
+		if (step->writes)
+			arch_memtest_inject(start, size);
+	}
+	res->us = timer_get_us() - begin;
+
+	for (i = 0; i < nchunks; i++) {
+		memtest_add(res, &chunks[i]);
+		unmap_sysmem(chunks[i].buf);
+	}
+	free(chunks);
+
+	return ret;
+}
@@ -162,7 +162,37 @@ static int num_public_exponent_bits(const struct rsa_public_key *key,
 static int is_public_exponent_bit_set(const struct rsa_public_key *key,
 		int pos)
 {
-	return key->exponent & (1ULL << pos);
+	return !!(key->exponent & (1ULL << pos));
+}
+
+/**
+ * check_public_exponent() - Check that the public exponent can be used
+ *
+ * @key:	RSA key
+ * @num_bits:	Storage for the number of public exponent bits
+ * @return 0 if OK, -EINVAL if the exponent is too short or even
+ */
+static int check_public_exponent(const struct rsa_public_key *key,
+		int *num_bits)
+{
+	int k;
+
+	if (0 != num_public_exponent_bits(key, &k))
+		return -EINVAL;
+
+	if (k < 2) {
+		debug("Public exponent is too short (%d bits, minimum 2)\n",
+		      k);
+		return -EINVAL;
+	}
+
+	if (!is_public_exponent_bit_set(key, 0)) {
+		debug("LSB of RSA public exponent must be set.\n");
+		return -EINVAL;
+	}
+	*num_bits = k;
+
+	return 0;
 }
 
 /**
@@ -192,19 +222,8 @@ static int pow_mod(const struct rsa_public_key *key, uint32_t *inout)
 	for (i = 0, ptr = inout + key->len - 1; i < key->len; i++, ptr--)
 		val[i] = get_unaligned_be32(ptr);
 
-	if (0 != num_public_exponent_bits(key, &k))
-		return -EINVAL;
-
-	if (k < 2) {
-		debug("Public exponent is too short (%d bits, minimum 2)\n",
-		      k);
+	if (check_public_exponent(key, &k))
 		return -EINVAL;
-	}
-
-	if (!is_public_exponent_bit_set(key, 0)) {
-		debug("LSB of RSA public exponent must be set.\n");
-		return -EINVAL;
-	}
 
 	/* the bit at e[k-1] is 1 by definition, so start with: C := M */
 	montgomery_mul(key, acc, val, key->rr); /* acc = a * RR / R mod n */
@@ -238,6 +257,285 @@ static int pow_mod(const struct rsa_public_key *key, uint32_t *inout)
 	return 0;
 }
 
+#ifdef __SIZEOF_INT128__
+/*
+ * On 64-bit CPUs the same Montgomery arithmetic is done with 64-bit words,
+ * which needs a quarter of the multiplications. The key in the device tree
+ * is prepared for 32-bit words: R^2 is the same for both as long as the
+ * modulus is an even number of 32-bit words, and n0inv is extended to 64
+ * bits below.
+ */
+#define RSA_MOD_EXP_64
+
+typedef unsigned __int128 uint128_t;
+
+/* Width of the sliding window used for exponents with many bits set */
+#define RSA_WINDOW_BITS		4
+
+/**
+ * struct rsa_key64 - RSA public key with 64-bit words
+ *
+ * @len:	Length of modulus[] and rr[] in number of uint64_t
+ * @n0inv:	-1 / modulus[0] mod 2^64
+ * @modulus:	Modulus as little endian array
+ * @rr:		R^2 as little endian array
+ * @exponent:	Public exponent
+ */
+struct rsa_key64 {
+	uint len;
+	uint64_t n0inv;
+	uint64_t *modulus;
+	uint64_t *rr;
+	uint64_t exponent;
+};
+
+static void subtract_modulus64(const struct rsa_key64 *key, uint64_t num[])
+{
+	uint64_t borrow = 0, d;
+	uint i;
+
+	for (i = 0; i < key->len; i++) {
+		d = num[i] - key->modulus[i] - borrow;
+		borrow = num[i] < key->modulus[i] ||
+			 (num[i] == key->modulus[i] && borrow);
+		num[i] = d;
+	}
+}
+
+static int greater_equal_modulus64(const struct rsa_key64 *key,
+				   const uint64_t num[])
+{
+	int i;
+
+	for (i = (int)key->len - 1; i >= 0; i--) {
+		if (num[i] < key->modulus[i])
+			return 0;
+		if (num[i] > key->modulus[i])
+			return 1;
+	}
+
+	return 1;  /* equal */
+}
+
+/* As montgomery_mul_add_step(), with 64-bit words */
+static void montgomery_mul_add_step64(const struct rsa_key64 *key,
+		uint64_t result[], const uint64_t a, const uint64_t b[])
+{
+	uint128_t acc_a, acc_b;
+	uint64_t d0;
+	uint i;
+
+	acc_a = (uint128_t)a * b[0] + result[0];
+	d0 = (uint64_t)acc_a * key->n0inv;
+	acc_b = (uint128_t)d0 * key->modulus[0] + (uint64_t)acc_a;
+	for (i = 1; i < key->len; i++) {
+		acc_a = (acc_a >> 64) + (uint128_t)a * b[i] + result[i];
+		acc_b = (acc_b >> 64) + (uint128_t)d0 * key->modulus[i] +
+				(uint64_t)acc_a;
+		result[i - 1] = (uint64_t)acc_b;
+	}
+
+	acc_a = (acc_a >> 64) + (acc_b >> 64);
+
+	result[i - 1] = (uint64_t)acc_a;
+
+	if (acc_a >> 64)
+		subtract_modulus64(key, result);
+}
+
+/* As montgomery_mul(), with 64-bit words; @result must not be @a or @b */
+static void montgomery_mul64(const struct rsa_key64 *key,
+		uint64_t result[], const uint64_t a[], const uint64_t b[])
+{
+	uint i;
+
+	for (i = 0; i < key->len; ++i)
+		result[i] = 0;
+	for (i = 0; i < key->len; ++i)
+		montgomery_mul_add_step64(key, result, a[i], b);
+}
+
+/**
+ * pow_mod64() - in-place public exponentiation by square-and-multiply
+ *
+ * This is the same as pow_mod(), which is best for exponents with few bits
+ * set, such as 65537.
+ *
+ * @key:	RSA key
+ * @val:	Little endian array containing value and result
+ * @k:		Number of bits in the public exponent
+ */
+static void pow_mod64(const struct rsa_key64 *key, uint64_t val[], int k)
+{
+	uint64_t acc[key->len], tmp[key->len], a_scaled[key->len];
+	int j;
+
+	montgomery_mul64(key, acc, val, key->rr); /* acc = a * RR / R mod n */
+	memcpy(a_scaled, acc, key->len * sizeof(a_scaled[0]));
+
+	for (j = k - 2; j > 0; --j) {
+		montgomery_mul64(key, tmp, acc, acc); /* tmp = acc^2 / R mod n */
+
+		if (key->exponent & (1ULL << j))
+			montgomery_mul64(key, acc, tmp, a_scaled);
+		else
+			memcpy(acc, tmp, key->len * sizeof(acc[0]));
+	}
+
+	/* the bit at e[0] is always 1, and multiplying by a leaves R out */
+	montgomery_mul64(key, tmp, acc, acc);
+	montgomery_mul64(key, acc, tmp, val);
+	memcpy(val, acc, key->len * sizeof(val[0]));
+}
+
+/**
+ * pow_mod64_window() - in-place public exponentiation with a sliding window
+ *
+ * The odd powers a^1 .. a^(2^RSA_WINDOW_BITS - 1) are computed first, so
+ * that there is one multiplication for each window of up to RSA_WINDOW_BITS
+ * bits of the exponent rather than one for each bit set.
+ *
+ * @key:	RSA key
+ * @val:	Little endian array containing value and result
+ * @k:		Number of bits in the public exponent
+ */
+static void pow_mod64_window(const struct rsa_key64 *key, uint64_t val[],
+			     int k)
+{
+	const uint odd_powers = 1 << (RSA_WINDOW_BITS - 1);
+	uint64_t table[odd_powers][key->len];
+	uint64_t acc[key->len], tmp[key->len], one[key->len];
+	uint64_t *x = acc, *y = tmp, *swap;
+	int i, low, n;
+	uint idx;
+
+	/* table[i] = a^(2i + 1) * R mod n */
+	montgomery_mul64(key, table[0], val, key->rr);
+	montgomery_mul64(key, tmp, table[0], table[0]);
+	for (i = 1; i < odd_powers; i++)
+		montgomery_mul64(key, table[i], table[i - 1], tmp);
+
+	for (i = k - 1; i >= 0; i = low - 1) {
+		low = i;
+		if (!(key->exponent & (1ULL << i))) {
+			montgomery_mul64(key, y, x, x);
+			swap = x, x = y, y = swap;
+			continue;
+		}
+
+		/* the window ends at a set bit, so that its value is odd */
+		low = i - RSA_WINDOW_BITS + 1;
+		if (low < 0)
+			low = 0;
+		while (!(key->exponent & (1ULL << low)))
+			low++;
+		idx = (key->exponent >> low) & ((1U << (i - low + 1)) - 1);
+
+		/* the top bit of the exponent starts the first window */
+		if (i == k - 1) {
+			memcpy(x, table[idx >> 1], key->len * sizeof(x[0]));
+			continue;
+		}
+		for (n = low; n <= i; n++) {
+			montgomery_mul64(key, y, x, x);
+			swap = x, x = y, y = swap;
+		}
+		montgomery_mul64(key, y, x, table[idx >> 1]);
+		swap = x, x = y, y = swap;
+	}
+
+	/* multiply by 1 to leave R out */
+	memset(one, '\0', sizeof(one));
+	one[0] = 1;
+	montgomery_mul64(key, val, x, one);
+}
+
+/*
+ * Each bit set in the exponent costs a multiplication with pow_mod64(). The
+ * window costs the table and a multiplication for each window instead.
+ */
+static int use_window(int k, uint64_t exponent)
+{
+	int weight = 0;
+
+	for (; exponent; exponent &= exponent - 1)
+		weight++;
+
+	return weight - 1 >
+		(1 << (RSA_WINDOW_BITS - 1)) + k / (RSA_WINDOW_BITS + 1) + 1;
+}
+
+static void rsa_convert_big_endian64(uint64_t *dst, const void *src, uint len)
+{
+	const uint8_t *p = src;
+	uint64_t v;
+	uint i;
+
+	for (i = 0; i < len; i++) {
+		memcpy(&v, p + (len - 1 - i) * sizeof(v), sizeof(v));
+		dst[i] = fdt64_to_cpu(v);
+	}
+}
+
+/**
+ * rsa_mod_exp64() - Perform RSA Modular Exponentiation with 64-bit words
+ *
+ * @key32:	Key as prepared by rsa_mod_exp_sw(), which is only used for its
+ *		length, n0inv and exponent
+ * @prop:	Key properties
+ * @sig:	Signature, key32->len * 4 bytes long
+ * @out:	Result, key32->len * 4 bytes long
+ * @return 0 if OK, -EINVAL if the exponent cannot be used
+ */
+static int rsa_mod_exp64(const struct rsa_public_key *key32,
+			 const struct key_prop *prop, const uint8_t *sig,
+			 uint8_t *out)
+{
+	struct rsa_key64 key;
+	uint64_t inv, v;
+	uint i;
+	int k;
+
+	if (check_public_exponent(key32, &k))
+		return -EINVAL;
+
+	key.len = key32->len / 2;
+	key.exponent = key32->exponent;
+	uint64_t modulus[key.len], rr[key.len], val[key.len];
+
+	key.modulus = modulus;
+	key.rr = rr;
+	rsa_convert_big_endian64(key.modulus, prop->modulus, key.len);
+	rsa_convert_big_endian64(key.rr, prop->rr, key.len);
+	rsa_convert_big_endian64(val, sig, key.len);
+
+	/*
+	 * 1 / modulus[0] is right in the low 32 bits, and one Newton step
+	 * doubles the number of bits which are right
+	 */
+	inv = (uint32_t)-key32->n0inv;
+	inv *= 2 - key.modulus[0] * inv;
+	key.n0inv = -inv;
+
+	if (use_window(k, key.exponent))
+		pow_mod64_window(&key, val, k);
+	else
+		pow_mod64(&key, val, k);
+
+	/* Make sure result < mod; result is at most 1x mod too large. */
+	if (greater_equal_modulus64(&key, val))
+		subtract_modulus64(&key, val);
+
+	/* Convert to big endian byte array */
+	for (i = 0; i < key.len; i++) {
+		v = cpu_to_fdt64(val[key.len - 1 - i]);
+		memcpy(out + i * sizeof(v), &v, sizeof(v));
+	}
+
+	return 0;
+}
+#endif
+
 static void rsa_convert_big_endian(uint32_t *dst, const uint32_t *src, int len)
 {
 	int i;
@@ -277,6 +575,10 @@ int rsa_mod_exp_sw(const uint8_t *sig, uint32_t sig_len,
 		return -EFAULT;
 	}
 	key.len /= sizeof(uint32_t) * 8;
+#ifdef RSA_MOD_EXP_64
+	if (!(key.len & 1) && sig_len == key.len * sizeof(uint32_t))
+		return rsa_mod_exp64(&key, prop, sig, out);
+#endif
 	uint32_t key1[key.len], key2[key.len];
 
 	key.modulus = key1;
@@ -13,6 +13,9 @@
 #endif /* USE_HOSTCC */
 #include <watchdog.h>
 #include <u-boot/sha256.h>
+#if defined(CONFIG_SHA256_ARMV8_CE) && !defined(USE_HOSTCC)
+#include <asm/system.h>
+#endif
 
 const uint8_t sha256_der_prefix[SHA256_DER_LEN] = {
 	0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86,
@@ -186,6 +189,25 @@ static void sha256_process(sha256_context *ctx, const uint8_t data[64])
 	ctx->state[7] += H;
 }
 
+/*
+ * Process @blocks consecutive 64-byte blocks, using the CPU's SHA-256
+ * instructions when it has them.
+ */
+static void sha256_process_blocks(sha256_context *ctx, const uint8_t *data,
+				  unsigned int blocks)
+{
+#if defined(CONFIG_SHA256_ARMV8_CE) && !defined(USE_HOSTCC)
+	if (id_aa64isar0_field(ID_AA64ISAR0_SHA2_SHIFT)) {
+		sha256_ce_transform(ctx->state, data, blocks);
+		return;
+	}
+#endif
+	while (blocks--) {
+		sha256_process(ctx, data);
+		data += 64;
+	}
+}
+
 void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 {
 	uint32_t left, fill;
@@ -204,16 +226,16 @@ void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 
 	if (left && length >= fill) {
 		memcpy((void *) (ctx->buffer + left), (void *) input, fill);
-		sha256_process(ctx, ctx->buffer);
+		sha256_process_blocks(ctx, ctx->buffer, 1);
 		length -= fill;
 		input += fill;
 		left = 0;
 	}
 
-	while (length >= 64) {
-		sha256_process(ctx, input);
-		length -= 64;
-		input += 64;
+	if (length >= 64) {
+		sha256_process_blocks(ctx, input, length / 64);
+		input += length & ~0x3F;
+		length &= 0x3F;
 	}
 
 	if (length)
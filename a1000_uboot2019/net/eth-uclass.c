@@ -10,6 +10,7 @@
 #include <environment.h>
 #include <net.h>
 #include <dm/device-internal.h>
+#include <dm/root.h>
 #include <dm/uclass-internal.h>
 #include "eth_internal.h"
 
@@ -390,6 +391,12 @@ int eth_initialize(void)
 
 	eth_common_init();
 
+	/* eth_get_dev() probes the first device when the network is used */
+	if (dm_probe_deferred(UCLASS_ETH)) {
+		bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "eth deferred");
+		return 0;
+	}
+
 	/*
 	 * Devices need to write the hwaddr even if not started so that Linux
 	 * will have access to the hwaddr that u-boot stored for the device.
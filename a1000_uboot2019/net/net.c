@@ -408,6 +408,7 @@ int net_loop(enum proto_t protocol)
 	debug_cond(DEBUG_INT_STATE, "--- net_loop Entry\n");
 
 	bootstage_mark_name(BOOTSTAGE_ID_ETH_START, "eth_start");
+	bootstage_start(BOOTSTAGE_ID_ACCUM_NET, "net");
 	net_init();
 	if (eth_is_on_demand_init() || protocol != NETCONS) {
 		eth_halt();
@@ -415,6 +416,7 @@ int net_loop(enum proto_t protocol)
 		ret = eth_init();
 		if (ret < 0) {
 			eth_halt();
+			bootstage_accum(BOOTSTAGE_ID_ACCUM_NET);
 			return ret;
 		}
 	} else {
@@ -439,6 +441,7 @@ restart:
 		/* network not configured */
 		eth_halt();
 		net_set_state(prev_net_state);
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_NET);
 		return -ENODEV;
 
 	case 2:
@@ -677,6 +680,7 @@ done:
 	net_set_state(prev_net_state);
 	dcache_enable();
 	mdelay(1);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_NET);
 	return ret;
 }
 
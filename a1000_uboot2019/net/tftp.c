@@ -140,6 +140,24 @@ static char tftp_filename[MAX_LEN];
 static unsigned short tftp_block_size = TFTP_BLOCK_SIZE;
 static unsigned short tftp_block_size_option = TFTP_MTU_BLOCKSIZE;
 
+/*
+ * RFC 7440 windowsize: the server sends this many blocks back to back and
+ * we only acknowledge the last one of each window. A size of 1 is the
+ * classic RFC 1350 lock-step transfer and is not negotiated at all.
+ */
+#ifdef CONFIG_TFTP_WINDOWSIZE
+#define TFTP_WINDOWSIZE CONFIG_TFTP_WINDOWSIZE
+#else
+#define TFTP_WINDOWSIZE 1
+#endif
+
+static unsigned short tftp_window_size = 1;
+static unsigned short tftp_window_size_option = TFTP_WINDOWSIZE;
+/* block number whose arrival completes the current window */
+static unsigned short tftp_next_ack;
+/* last in-order block we re-acknowledged after a gap in the window */
+static int tftp_last_nack;
+
 static inline int store_block(int block, uchar *src, unsigned int len)
 {
 	ulong offset = block * tftp_block_size + tftp_block_wrap_offset;
@@ -194,6 +212,8 @@ static void new_transfer(void)
 	tftp_prev_block = 0;
 	tftp_block_wrap = 0;
 	tftp_block_wrap_offset = 0;
+	tftp_next_ack = tftp_window_size;
+	tftp_last_nack = -1;
 #ifdef CONFIG_CMD_TFTPPUT
 	tftp_put_final_block_sent = 0;
 #endif
@@ -346,6 +366,10 @@ static void tftp_send(void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, tftp_block_size_option, 0);
+		/* windows are only used for downloads */
+		if (tftp_state == STATE_SEND_RRQ && tftp_window_size_option > 1)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, tftp_window_size_option, 0);
 		len = pkt - xp;
 		break;
 
@@ -416,6 +440,7 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 {
 	__be16 proto;
 	__be16 *s;
+	unsigned short block, gap;
 	int i;
 
 	if (dest != tftp_our_port) {
@@ -490,6 +515,17 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				debug("Blocksize ack: %s, %d\n",
 				      (char *)pkt + i + 8, tftp_block_size);
 			}
+			if (strcmp((char *)pkt + i, "windowsize") == 0) {
+				tftp_window_size = (unsigned short)
+					simple_strtoul((char *)pkt + i + 11,
+						       NULL, 10);
+				/* The server may only lower what we asked */
+				if (!tftp_window_size ||
+				    tftp_window_size > tftp_window_size_option)
+					tftp_window_size = 1;
+				debug("Windowsize ack: %s, %d\n",
+				      (char *)pkt + i + 11, tftp_window_size);
+			}
 #ifdef CONFIG_TFTP_TSIZE
 			if (strcmp((char *)pkt+i, "tsize") == 0) {
 				tftp_tsize = simple_strtoul((char *)pkt + i + 6,
@@ -512,35 +548,74 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		if (len < 2)
 			return;
 		len -= 2;
-		tftp_cur_block = ntohs(*(__be16 *)pkt);
-
-		update_block_number();
+		block = ntohs(*(__be16 *)pkt);
 
 		if (tftp_state == STATE_SEND_RRQ)
 			debug("Server did not acknowledge timeout option!\n");
 
 		if (tftp_state == STATE_SEND_RRQ || tftp_state == STATE_OACK ||
 		    tftp_state == STATE_RECV_WRQ) {
+			if (tftp_state == STATE_SEND_RRQ)
+				tftp_window_size = 1;
+
+			if (block != 1 && tftp_window_size > 1 &&
+			    tftp_state == STATE_OACK) {
+				/*
+				 * Block 1 of the first window went missing:
+				 * acknowledge the OACK again so the server
+				 * restarts the window.
+				 */
+				if (tftp_last_nack != 0) {
+					debug("First block is %d, re-sending ACK 0\n",
+					      block);
+					tftp_last_nack = 0;
+					tftp_send();
+				}
+				break;
+			}
+
 			/* first block received */
 			tftp_state = STATE_DATA;
 			tftp_remote_port = src;
 			new_transfer();
 
-			if (tftp_cur_block != 1) {	/* Assertion */
+			if (block != 1) {	/* Assertion */
 				puts("\nTFTP error: ");
-				printf("First block is not block 1 (%ld)\n",
-				       tftp_cur_block);
+				printf("First block is not block 1 (%d)\n",
+				       block);
 				puts("Starting again\n\n");
 				net_start_again();
 				break;
 			}
 		}
 
-		if (tftp_cur_block == tftp_prev_block) {
-			/* Same block again; ignore it. */
+		/*
+		 * Only the next block in sequence is stored. A block from
+		 * further ahead in the window means at least one was lost or
+		 * reordered: acknowledge the last in-order block once, which
+		 * makes the server restart the window from there (RFC 7440,
+		 * section 4). Anything else is a duplicate of a block we
+		 * already have.
+		 */
+		gap = (unsigned short)(block - (tftp_prev_block + 1));
+		if (gap) {
+			if (gap < tftp_window_size &&
+			    tftp_last_nack != (int)tftp_prev_block) {
+				debug("Block %d out of order, expected %d\n",
+				      block,
+				      (unsigned short)(tftp_prev_block + 1));
+				tftp_last_nack = tftp_prev_block;
+				tftp_cur_block = tftp_prev_block;
+				tftp_next_ack = tftp_prev_block +
+						tftp_window_size;
+				tftp_send();
+			}
 			break;
 		}
 
+		tftp_cur_block = block;
+		update_block_number();
+
 		tftp_prev_block = tftp_cur_block;
 		timeout_count_max = tftp_timeout_count_max;
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
@@ -551,14 +626,20 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			break;
 		}
 
+		if (len < tftp_block_size) {
+			tftp_send();
+			tftp_complete();
+			break;
+		}
+
 		/*
-		 *	Acknowledge the block just received, which will prompt
-		 *	the remote for the next one.
+		 *	Acknowledge the last block of the window, which will
+		 *	prompt the remote for the next window.
 		 */
-		tftp_send();
-
-		if (len < tftp_block_size)
-			tftp_complete();
+		if (block == tftp_next_ack) {
+			tftp_send();
+			tftp_next_ack += tftp_window_size;
+		}
 		break;
 
 	case TFTP_ERROR:
@@ -594,8 +675,13 @@ static void tftp_timeout_handler(void)
 	} else {
 		puts("T ");
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
-		if (tftp_state != STATE_RECV_WRQ)
+		if (tftp_state != STATE_RECV_WRQ) {
+			/* The server restarts the window after our ACK */
+			if (tftp_state == STATE_DATA && !tftp_put_active)
+				tftp_next_ack = tftp_cur_block +
+						tftp_window_size;
 			tftp_send();
+		}
 	}
 }
 
@@ -632,6 +718,15 @@ void tftp_start(enum proto_t protocol)
 	if (ep != NULL)
 		tftp_block_size_option = simple_strtol(ep, NULL, 10);
 
+	ep = env_get("tftpwindowsize");
+	if (ep != NULL)
+		tftp_window_size_option = simple_strtol(ep, NULL, 10);
+
+	if (!tftp_window_size_option) {
+		puts("TFTP window size (0) too low, set min = 1\n");
+		tftp_window_size_option = 1;
+	}
+
 	ep = env_get("tftptimeout");
 	if (ep != NULL)
 		timeout_ms = simple_strtol(ep, NULL, 10);
@@ -653,8 +748,8 @@ void tftp_start(enum proto_t protocol)
 	}
 #endif
 
-	debug("TFTP blocksize = %i, timeout = %ld ms\n",
-	      tftp_block_size_option, timeout_ms);
+	debug("TFTP blocksize = %i, windowsize = %i, timeout = %ld ms\n",
+	      tftp_block_size_option, tftp_window_size_option, timeout_ms);
 
 	tftp_remote_ip = net_server_ip;
 	if (!net_parse_bootfile(&tftp_remote_ip, tftp_filename, MAX_LEN)) {
@@ -755,6 +850,9 @@ void tftp_start(enum proto_t protocol)
 	memset(net_server_ethaddr, 0, 6);
 	/* Revert tftp_block_size to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	/* Lock-step until the server accepts our windowsize */
+	tftp_window_size = 1;
+	tftp_last_nack = -1;
 #ifdef CONFIG_TFTP_TSIZE
 	tftp_tsize = 0;
 	tftp_tsize_num_hash = 0;
@@ -787,6 +885,7 @@ void tftp_start_server(void)
 
 	/* Revert tftp_block_size to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_window_size = 1;
 	tftp_cur_block = 0;
 	tftp_our_port = WELL_KNOWN_PORT;
 
@@ -6,9 +6,13 @@
 #include <common.h>
 #include <bootm.h>
 #include <command.h>
+#include <decomp_stream.h>
+#include <hexdump.h>
 #include <malloc.h>
 #include <mapmem.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
+#include <linux/sizes.h>
 
 #include <u-boot/zlib.h>
 #include <bzlib.h>
@@ -436,6 +440,229 @@ static int compression_test_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_lz4, 0);
 
+#define LZ4_TEST_BLOCK	SZ_64K
+
+/* Add an LZ4 block which decompresses to @size bytes of @val */
+static u8 *lz4_add_block(u8 *p, u8 val, u32 size)
+{
+	u8 *data = p + sizeof(u32);
+	/* after the first literal, less the match length in the token */
+	u32 len = size - 1 - 5 - 4 - 15;
+
+	p = data;
+	*p++ = 0x1f;		/* one literal, a long match */
+	*p++ = val;
+	put_unaligned_le16(1, p);
+	p += sizeof(u16);
+	for (; len >= 255; len -= 255)
+		*p++ = 255;
+	*p++ = len;
+	*p++ = 0x50;		/* five last literals */
+	memset(p, val, 5);
+	p += 5;
+	put_unaligned_le32(p - data, data - sizeof(u32));
+
+	return p;
+}
+
+/* Add an uncompressed LZ4 block */
+static u8 *lz4_add_raw_block(u8 *p, const u8 *data, u32 size)
+{
+	put_unaligned_le32(size | 0x80000000, p);
+	memcpy(p + sizeof(u32), data, size);
+
+	return p + sizeof(u32) + size;
+}
+
+/*
+ * Build an LZ4 frame of 64 KiB blocks of the sizes in @sizes, alternately
+ * compressed and not, and the data it decompresses to
+ */
+static u32 lz4_make_frame(u8 *frame, u8 *expect, const u32 *sizes,
+			  int count)
+{
+	u8 *p = frame;
+	int i, j;
+
+	put_unaligned_le32(0x184d2204, p);
+	p[4] = 0x60;		/* version 1, independent blocks */
+	p[5] = 0x40;		/* 64 KiB blocks */
+	p[6] = 0;		/* header checksum, not checked */
+	p += 7;
+
+	for (i = 0; i < count; i++) {
+		if (i & 1) {
+			for (j = 0; j < sizes[i]; j++)
+				expect[j] = j * 7 + i;
+			p = lz4_add_raw_block(p, expect, sizes[i]);
+		} else {
+			memset(expect, 0x11 * (i + 1), sizes[i]);
+			p = lz4_add_block(p, 0x11 * (i + 1), sizes[i]);
+		}
+		expect += sizes[i];
+	}
+	put_unaligned_le32(0, p);
+
+	return p + sizeof(u32) - frame;
+}
+
+/* Frames of several blocks, which are decompressed on all CPUs */
+static int compression_test_lz4_blocks(struct unit_test_state *uts)
+{
+	static const u32 full[] = {
+		LZ4_TEST_BLOCK, LZ4_TEST_BLOCK, LZ4_TEST_BLOCK,
+		LZ4_TEST_BLOCK, 1000,
+	};
+	/* a short block which is not the last one */
+	static const u32 short_block[] = {
+		LZ4_TEST_BLOCK, 1000, LZ4_TEST_BLOCK, 1000,
+	};
+	const size_t out_max = 5 * LZ4_TEST_BLOCK;
+	u8 *frame, *expect, *out;
+	size_t size;
+	u32 len;
+
+	frame = malloc(out_max);
+	expect = malloc(out_max);
+	out = malloc(out_max);
+	ut_assertnonnull(frame);
+	ut_assertnonnull(expect);
+	ut_assertnonnull(out);
+
+	len = lz4_make_frame(frame, expect, full, ARRAY_SIZE(full));
+	size = out_max;
+	ut_assertok(ulz4fn(frame, len, out, &size));
+	ut_asserteq(4 * LZ4_TEST_BLOCK + 1000, size);
+	ut_asserteq_mem(expect, out, size);
+
+	/* the output buffer must hold all of it */
+	size = 4 * LZ4_TEST_BLOCK + 999;
+	ut_assert(ulz4fn(frame, len, out, &size) < 0);
+
+	len = lz4_make_frame(frame, expect, short_block,
+			     ARRAY_SIZE(short_block));
+	size = out_max;
+	ut_assertok(ulz4fn(frame, len, out, &size));
+	ut_asserteq(2 * LZ4_TEST_BLOCK + 2000, size);
+	ut_asserteq_mem(expect, out, size);
+
+	free(out);
+	free(expect);
+	free(frame);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_lz4_blocks, 0);
+
+/* Decompress @in through a stream, passing it in pieces of @step bytes */
+static int stream_in_pieces(struct unit_test_state *uts, int comp,
+			    const void *in, size_t in_size, size_t step,
+			    void *out, size_t out_max, size_t *out_size)
+{
+	struct decomp_stream ds;
+	size_t pos, len;
+	int ret = 0, err;
+
+	ut_asserteq(comp, decomp_stream_detect(in, in_size));
+	ut_assertok(decomp_stream_init(&ds, comp, out, out_max));
+	for (pos = 0; pos < in_size && !ret; pos += len) {
+		len = min(step, in_size - pos);
+		ret = decomp_stream_write(&ds, in + pos, len);
+	}
+	err = decomp_stream_finish(&ds);
+	*out_size = ds.out;
+
+	return ret ? ret : err;
+}
+
+static int compression_test_stream(struct unit_test_state *uts)
+{
+	static const size_t steps[] = { 1, 7, 100, 4096, SZ_1M };
+	static const u32 sizes[] = {
+		LZ4_TEST_BLOCK, LZ4_TEST_BLOCK, 1000,
+	};
+	const size_t plain_size = strlen(plain);
+	const size_t out_max = 3 * LZ4_TEST_BLOCK;
+	unsigned long gz_size = out_max;
+	u8 *gz, *frame, *expect, *out;
+	size_t size;
+	u32 len;
+	int i;
+
+	gz = malloc(out_max);
+	frame = malloc(out_max);
+	expect = malloc(out_max);
+	out = malloc(out_max);
+	ut_assertnonnull(gz);
+	ut_assertnonnull(frame);
+	ut_assertnonnull(expect);
+	ut_assertnonnull(out);
+	ut_assertok(gzip(gz, &gz_size, (uchar *)plain, plain_size));
+	len = lz4_make_frame(frame, expect, sizes, ARRAY_SIZE(sizes));
+
+	for (i = 0; i < ARRAY_SIZE(steps); i++) {
+		memset(out, '\0', out_max);
+		ut_assertok(stream_in_pieces(uts, IH_COMP_GZIP, gz, gz_size,
+					     steps[i], out, out_max, &size));
+		ut_asserteq(plain_size, size);
+		ut_asserteq_mem(plain, out, size);
+
+		memset(out, '\0', out_max);
+		ut_assertok(stream_in_pieces(uts, IH_COMP_LZMA,
+					     lzma_compressed,
+					     lzma_compressed_size, steps[i],
+					     out, out_max, &size));
+		ut_asserteq(plain_size, size);
+		ut_asserteq_mem(plain, out, size);
+
+		memset(out, '\0', out_max);
+		ut_assertok(stream_in_pieces(uts, IH_COMP_LZ4, lz4_compressed,
+					     lz4_compressed_size, steps[i],
+					     out, out_max, &size));
+		ut_asserteq(plain_size, size);
+		ut_asserteq_mem(plain, out, size);
+
+		/* blocks split between pieces */
+		memset(out, '\0', out_max);
+		ut_assertok(stream_in_pieces(uts, IH_COMP_LZ4, frame, len,
+					     steps[i], out, out_max, &size));
+		ut_asserteq(2 * LZ4_TEST_BLOCK + 1000, size);
+		ut_asserteq_mem(expect, out, size);
+	}
+
+	/* the output does not fit */
+	ut_asserteq(-ENOSPC, stream_in_pieces(uts, IH_COMP_GZIP, gz, gz_size,
+					      100, out, plain_size - 1,
+					      &size));
+	ut_asserteq(-ENOSPC, stream_in_pieces(uts, IH_COMP_LZMA,
+					      lzma_compressed,
+					      lzma_compressed_size, 100, out,
+					      plain_size - 1, &size));
+	ut_asserteq(-ENOSPC, stream_in_pieces(uts, IH_COMP_LZ4, frame, len,
+					      100, out, 2 * LZ4_TEST_BLOCK,
+					      &size));
+
+	/* the input is cut short */
+	ut_asserteq(-EPROTO, stream_in_pieces(uts, IH_COMP_GZIP, gz,
+					      gz_size - 4, 100, out, out_max,
+					      &size));
+	ut_asserteq(-EPROTO, stream_in_pieces(uts, IH_COMP_LZMA,
+					      lzma_compressed,
+					      lzma_compressed_size - 10, 100,
+					      out, out_max, &size));
+	ut_asserteq(-EPROTO, stream_in_pieces(uts, IH_COMP_LZ4, frame,
+					      len - 4, 100, out, out_max,
+					      &size));
+
+	free(out);
+	free(expect);
+	free(frame);
+	free(gz);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_stream, 0);
+
 static int compress_using_none(struct unit_test_state *uts,
 			       void *in, unsigned long in_size,
 			       void *out, unsigned long out_max,
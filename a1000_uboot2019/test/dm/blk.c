@@ -4,6 +4,7 @@
  */
 
 #include <common.h>
+#include <blk.h>
 #include <dm.h>
 #include <usb.h>
 #include <asm/state.h>
@@ -162,3 +163,122 @@ static int dm_test_blk_get_from_parent(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_get_from_parent, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(BLOCK_CACHE)
+/* Test the block cache page lookup, write-through and LRU eviction */
+static int dm_test_blk_cache(struct unit_test_state *uts)
+{
+	struct block_cache_stats stats, saved;
+	const int iftype = IF_TYPE_HOST, devnum = 99, hwpart = 0;
+	char data[16 * 512], buf[16 * 512];
+	int i;
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = i / 512;
+
+	blkcache_stats(&saved);
+
+	/* Room for four pages of eight 512-byte blocks */
+	blkcache_configure(16, 4 * 8 * 512);
+
+	blkcache_fill(iftype, devnum, hwpart, 0, 8, 512, data);
+	ut_asserteq(1, blkcache_read(iftype, devnum, hwpart, 2, 4, 512, buf));
+	ut_assertok(memcmp(buf, data + 2 * 512, 4 * 512));
+	ut_asserteq(0, blkcache_read(iftype, devnum, hwpart, 6, 4, 512, buf));
+
+	/* Blocks from another device or block size are not returned */
+	ut_asserteq(0, blkcache_read(iftype, devnum + 1, hwpart, 2, 4, 512,
+				     buf));
+	ut_asserteq(0, blkcache_read(iftype, devnum, hwpart, 2, 1, 1024, buf));
+
+	/* Partially filled page */
+	blkcache_fill(iftype, devnum, hwpart, 8, 2, 512, data + 8 * 512);
+	ut_asserteq(1, blkcache_read(iftype, devnum, hwpart, 6, 4, 512, buf));
+	ut_assertok(memcmp(buf, data + 6 * 512, 4 * 512));
+	ut_asserteq(0, blkcache_read(iftype, devnum, hwpart, 9, 2, 512, buf));
+
+	/* Writes update the cached blocks only */
+	memset(data + 4 * 512, 0xa5, 8 * 512);
+	blkcache_write(iftype, devnum, hwpart, 4, 8, 512, data + 4 * 512);
+	ut_asserteq(1, blkcache_read(iftype, devnum, hwpart, 0, 12, 512, buf));
+	ut_assertok(memcmp(buf, data, 12 * 512));
+	ut_asserteq(0, blkcache_read(iftype, devnum, hwpart, 12, 1, 512, buf));
+
+	blkcache_invalidate_range(iftype, devnum, hwpart, 0, 2, 512);
+	ut_asserteq(0, blkcache_read(iftype, devnum, hwpart, 1, 1, 512, buf));
+	ut_asserteq(1, blkcache_read(iftype, devnum, hwpart, 2, 1, 512, buf));
+
+	blkcache_stats(&stats);
+	ut_asserteq(4, stats.hits);
+	ut_asserteq(6, stats.misses);
+	ut_asserteq(2, stats.entries);
+	ut_asserteq(2 * 8 * 512, stats.bytes);
+	ut_asserteq((4 + 4 + 12 + 1) * 512, stats.bytes_saved);
+
+	/* Page 0 is the most recently used, so page 1 goes first */
+	blkcache_fill(iftype, devnum, hwpart, 16, 16, 512, data);
+	ut_asserteq(1, blkcache_read(iftype, devnum, hwpart, 2, 1, 512, buf));
+	blkcache_fill(iftype, devnum, hwpart, 32, 8, 512, data);
+	ut_asserteq(0, blkcache_read(iftype, devnum, hwpart, 8, 1, 512, buf));
+	ut_asserteq(1, blkcache_read(iftype, devnum, hwpart, 2, 1, 512, buf));
+	ut_asserteq(1, blkcache_read(iftype, devnum, hwpart, 16, 16, 512, buf));
+
+	/* Reads larger than the limit are not cached */
+	blkcache_fill(iftype, devnum, hwpart, 64, 17, 512, data);
+	ut_asserteq(0, blkcache_read(iftype, devnum, hwpart, 64, 1, 512, buf));
+
+	blkcache_stats(&stats);
+	ut_asserteq(4, stats.entries);
+
+	blkcache_invalidate(iftype, devnum);
+	blkcache_stats(&stats);
+	ut_asserteq(0, stats.entries);
+	ut_asserteq(0, stats.bytes);
+
+	blkcache_configure(saved.max_blocks, saved.max_bytes);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache, 0);
+
+/* Test that a write to one hardware partition leaves the others cached */
+static int dm_test_blk_cache_hwpart(struct unit_test_state *uts)
+{
+	struct block_cache_stats stats, saved;
+	const int iftype = IF_TYPE_MMC, devnum = 99;
+	char user[8 * 512], boot[8 * 512], buf[8 * 512];
+
+	memset(user, 0x5a, sizeof(user));
+	memset(boot, 0xa5, sizeof(boot));
+
+	blkcache_stats(&saved);
+	blkcache_configure(16, 4 * 8 * 512);
+
+	/* The same blocks of the user area and the first boot partition */
+	blkcache_fill(iftype, devnum, 0, 0, 8, 512, user);
+	ut_asserteq(0, blkcache_read(iftype, devnum, 1, 0, 8, 512, buf));
+	blkcache_fill(iftype, devnum, 1, 0, 8, 512, user);
+
+	/* Write to hwpart 1, then read back hwpart 0 */
+	blkcache_write(iftype, devnum, 1, 0, 8, 512, boot);
+	ut_asserteq(1, blkcache_read(iftype, devnum, 0, 0, 8, 512, buf));
+	ut_assertok(memcmp(buf, user, sizeof(buf)));
+	ut_asserteq(1, blkcache_read(iftype, devnum, 1, 0, 8, 512, buf));
+	ut_assertok(memcmp(buf, boot, sizeof(buf)));
+
+	blkcache_invalidate_range(iftype, devnum, 1, 0, 8, 512);
+	ut_asserteq(0, blkcache_read(iftype, devnum, 1, 0, 8, 512, buf));
+	ut_asserteq(1, blkcache_read(iftype, devnum, 0, 0, 8, 512, buf));
+
+	/* Reinitialising the device drops every hardware partition */
+	blkcache_fill(iftype, devnum, 2, 0, 8, 512, boot);
+	blkcache_invalidate(iftype, devnum);
+	blkcache_stats(&stats);
+	ut_asserteq(0, stats.entries);
+
+	blkcache_configure(saved.max_blocks, saved.max_bytes);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache_hwpart, 0);
+#endif
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Benchmark for driver model binding and device lookups
+ *
+ * This builds a flat device tree with many nodes, binds and probes them, then
+ * looks each device up by sequence number and by device tree offset. The
+ * time taken is printed, so that a build with CONFIG_DM_LOOKUP_INDEX can be
+ * compared against one without. Run it with 'ut dm lookup_bench' on sandbox
+ * started with -v to see the output.
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <errno.h>
+#include <malloc.h>
+#include <dm/root.h>
+#include <dm/test.h>
+#include <dm/uclass-internal.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+enum {
+	BENCH_NODES	= 1000,
+	BENCH_FDT_SIZE	= 128 << 10,
+	BENCH_PASSES	= 4,
+};
+
+/* Create a tree with BENCH_NODES nodes, which each match testfdt_drv */
+static int build_bench_fdt(struct unit_test_state *uts, void *blob)
+{
+	char compat[64];
+	char name[20];
+	int len;
+	int i;
+
+	ut_assertok(fdt_create(blob, BENCH_FDT_SIZE));
+	ut_assertok(fdt_finish_reservemap(blob));
+	ut_assertok(fdt_begin_node(blob, ""));
+	for (i = 0; i < BENCH_NODES; i++) {
+		/* The first string matches no driver, like most SoC strings */
+		len = snprintf(compat, sizeof(compat), "bench,dev%d", i) + 1;
+		strcpy(compat + len, "denx,u-boot-fdt-test");
+		len += strlen(compat + len) + 1;
+
+		snprintf(name, sizeof(name), "bench@%d", i);
+		ut_assertok(fdt_begin_node(blob, name));
+		ut_assertok(fdt_property(blob, "compatible", compat, len));
+		ut_assertok(fdt_property_u32(blob, "ping-add", i));
+		ut_assertok(fdt_end_node(blob));
+	}
+	ut_assertok(fdt_end_node(blob));
+	ut_assertok(fdt_finish(blob));
+
+	return 0;
+}
+
+static int run_lookup_bench(struct unit_test_state *uts, const void *blob)
+{
+	ulong bind_us, probe_us, seq_us, node_us, start;
+	struct udevice *dev, *found;
+	int lookups = 0;
+	int count = 0;
+	int pass;
+
+	start = timer_get_us();
+	ut_assertok(dm_scan_fdt(blob, false));
+	bind_us = timer_get_us() - start;
+
+	/* Probing gives each device the next free sequence number */
+	start = timer_get_us();
+	for (uclass_first_device(UCLASS_TEST_FDT, &dev); dev;
+	     uclass_next_device(&dev))
+		count++;
+	probe_us = timer_get_us() - start;
+	ut_asserteq(BENCH_NODES, count);
+
+	start = timer_get_us();
+	for (pass = 0; pass < BENCH_PASSES; pass++) {
+		uclass_foreach_dev_probe(UCLASS_TEST_FDT, dev) {
+			ut_assertok(uclass_get_device_by_seq(UCLASS_TEST_FDT,
+							     dev->seq, &found));
+			ut_asserteq_ptr(dev, found);
+			lookups++;
+		}
+	}
+	seq_us = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (pass = 0; pass < BENCH_PASSES; pass++) {
+		uclass_foreach_dev_probe(UCLASS_TEST_FDT, dev) {
+			ut_assertok(uclass_get_device_by_of_offset(
+					UCLASS_TEST_FDT, dev_of_offset(dev),
+					&found));
+			ut_asserteq_ptr(dev, found);
+			lookups++;
+		}
+	}
+	node_us = timer_get_us() - start;
+
+	/* A node which has no device must not be found */
+	ut_asserteq(-ENODEV, uclass_find_device_by_of_offset(UCLASS_TEST_FDT,
+							      0, &found));
+
+	printf("%d nodes: bind %lu us, probe %lu us\n", BENCH_NODES, bind_us,
+	       probe_us);
+	printf("%d lookups: by seq %lu us, by node %lu us\n", lookups, seq_us,
+	       node_us);
+
+	return 0;
+}
+
+static int dm_test_lookup_bench(struct unit_test_state *uts)
+{
+	const void *old_blob = gd->fdt_blob;
+#ifdef CONFIG_OF_LIVE
+	struct device_node *old_root = gd->of_root;
+#endif
+	struct uclass *uc;
+	void *blob;
+	int ret;
+
+	blob = malloc(BENCH_FDT_SIZE);
+	ut_assertnonnull(blob);
+	ret = build_bench_fdt(uts, blob);
+	if (!ret) {
+		/* The synthetic tree is flat, so hide any live tree */
+		gd->fdt_blob = blob;
+#ifdef CONFIG_OF_LIVE
+		gd->of_root = NULL;
+#endif
+		ret = run_lookup_bench(uts, blob);
+
+		/* Device names point into the tree, so drop them before it */
+		if (!uclass_get(UCLASS_TEST_FDT, &uc))
+			uclass_destroy(uc);
+		gd->fdt_blob = old_blob;
+#ifdef CONFIG_OF_LIVE
+		gd->of_root = old_root;
+#endif
+	}
+	free(blob);
+
+	return ret;
+}
+DM_TEST(dm_test_lookup_bench, 0);
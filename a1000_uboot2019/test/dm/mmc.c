@@ -6,7 +6,10 @@
 #include <common.h>
 #include <dm.h>
 #include <mmc.h>
+#include <asm/test.h>
+#include <dm/device-internal.h>
 #include <dm/test.h>
+#include <dm/uclass-internal.h>
 #include <test/ut.h>
 
 /*
@@ -34,6 +37,11 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 
 	/* Read a few blocks and look for the string we expect */
 	ut_asserteq(512, dev_desc->blksz);
+	/*
+	 * The emulator returns zeroes for single-block reads, so drop what
+	 * the partition scan left in the block cache
+	 */
+	blkcache_invalidate(dev_desc->if_type, dev_desc->devnum);
 	memset(cmp, '\0', sizeof(cmp));
 	ut_asserteq(2, blk_dread(dev_desc, 0, 2, cmp));
 	ut_assertok(strcmp(cmp, "this is a test"));
@@ -41,3 +49,88 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/*
+ * Test that the mmc commands probe a device which is bound but not yet
+ * probed, as DM_LAZY_PROBE leaves it after init
+ */
+static int dm_test_mmc_lazy_probe(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+
+	ut_assertok(uclass_find_device(UCLASS_MMC, 0, &dev));
+	ut_assertnonnull(dev);
+	ut_assert(!device_active(dev));
+
+	ut_assertnonnull(find_mmc_device(0));
+	ut_assert(device_active(dev));
+
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assertok(run_command("mmc dev 0", 0));
+	ut_assert(device_active(dev));
+
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assertok(run_command("mmc info", 0));
+	ut_assert(device_active(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_lazy_probe, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#ifdef MMC_SUPPORTS_TUNING
+/* Test picking a sampling phase from the results of a tuning sweep */
+static int dm_test_mmc_tuning_window(struct unit_test_state *uts)
+{
+	static const bool all[] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+	static const bool none[] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	static const bool middle[] = { 0, 1, 1, 1, 0, 0, 1, 0 };
+	static const bool wrap[] = { 1, 1, 0, 0, 0, 1, 1, 1 };
+	static const bool first[] = { 1, 1, 1, 0, 1, 0, 1, 0 };
+
+	ut_asserteq(4, mmc_tuning_find_phase(all, ARRAY_SIZE(all)));
+	ut_asserteq(-EIO, mmc_tuning_find_phase(none, ARRAY_SIZE(none)));
+	ut_asserteq(2, mmc_tuning_find_phase(middle, ARRAY_SIZE(middle)));
+	ut_asserteq(7, mmc_tuning_find_phase(wrap, ARRAY_SIZE(wrap)));
+	ut_asserteq(1, mmc_tuning_find_phase(first, ARRAY_SIZE(first)));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_tuning_window, 0);
+
+/* Test tuning against the emulator, with CRC errors at some phases */
+static int dm_test_mmc_tuning(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	struct mmc *mmc;
+	uint bus_width;
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	mmc = mmc_get_mmc_dev(dev);
+	ut_assertnonnull(mmc);
+
+	/* Tuning is only done on a wide bus, as in HS200 or SDR104 mode */
+	bus_width = mmc->bus_width;
+	mmc->bus_width = 4;
+
+	/* Phases 8 to 15 pass and 0 to 3 form a shorter window */
+	sandbox_mmc_set_tuning_errors(dev, 0xffff00f0);
+	ut_assertok(mmc_execute_tuning(mmc, MMC_CMD_SEND_TUNING_BLOCK_HS200));
+	ut_asserteq(11, sandbox_mmc_get_tuning_phase(dev));
+
+	/* A window which wraps from the last phase to the first */
+	sandbox_mmc_set_tuning_errors(dev, 0x0000fff0);
+	ut_assertok(mmc_execute_tuning(mmc, MMC_CMD_SEND_TUNING_BLOCK));
+	ut_asserteq(25, sandbox_mmc_get_tuning_phase(dev));
+
+	sandbox_mmc_set_tuning_errors(dev, GENMASK(SANDBOX_MMC_TUNING_PHASES - 1,
+						   0));
+	ut_asserteq(-EIO, mmc_execute_tuning(mmc,
+					     MMC_CMD_SEND_TUNING_BLOCK_HS200));
+
+	sandbox_mmc_set_tuning_errors(dev, 0);
+	mmc->bus_width = bus_width;
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_tuning, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
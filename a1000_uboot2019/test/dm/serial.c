@@ -6,9 +6,13 @@
 #include <common.h>
 #include <serial.h>
 #include <dm.h>
+#include <asm/test.h>
 #include <dm/test.h>
+#include <linux/sizes.h>
 #include <test/ut.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 static int dm_test_serial(struct unit_test_state *uts)
 {
 	struct serial_device_info info_serial = {0};
@@ -67,3 +71,62 @@ static int dm_test_serial(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_serial, DM_TESTF_SCAN_FDT);
+
+/* Lines of 64 characters, making up 1KiB of console output */
+#define BENCH_LINE_LEN	64
+#define BENCH_LINES	(SZ_1K / BENCH_LINE_LEN)
+
+/*
+ * Measure the cost of writing 1KiB a character at a time and a string at a
+ * time. Run 'ut dm serial_puts' on sandbox started with -v to see it.
+ */
+static int dm_test_serial_puts(struct unit_test_state *uts)
+{
+	struct udevice *old_dev = gd->cur_serial_dev;
+	char line[BENCH_LINE_LEN + 1];
+	uint putc_writes, puts_writes;
+	ulong putc_us, puts_us, start;
+	struct udevice *dev;
+	const char *s;
+	int i;
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_SERIAL, "serial", &dev));
+	memset(line, '.', BENCH_LINE_LEN - 1);
+	line[BENCH_LINE_LEN - 1] = '\n';
+	line[BENCH_LINE_LEN] = '\0';
+
+	/* Send the output to the device under test, not the console's */
+	gd->cur_serial_dev = dev;
+
+	putc_writes = sandbox_serial_get_writes(dev);
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LINES; i++) {
+		for (s = line; *s; s++)
+			serial_putc(*s);
+	}
+	putc_us = timer_get_us() - start;
+	putc_writes = sandbox_serial_get_writes(dev) - putc_writes;
+
+	puts_writes = sandbox_serial_get_writes(dev);
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LINES; i++)
+		serial_puts(line);
+	puts_us = timer_get_us() - start;
+	puts_writes = sandbox_serial_get_writes(dev) - puts_writes;
+
+	gd->cur_serial_dev = old_dev;
+
+	printf("1KiB output: putc %lu us, %u writes; puts %lu us, %u writes\n",
+	       putc_us, putc_writes, puts_us, puts_writes);
+
+	/* Each newline also sends a carriage return */
+	ut_asserteq(BENCH_LINES * (BENCH_LINE_LEN + 1), putc_writes);
+	if (CONFIG_IS_ENABLED(SERIAL_PUTS)) {
+		ut_asserteq(BENCH_LINES * 2, puts_writes);
+	} else {
+		ut_asserteq(putc_writes, puts_writes);
+	}
+
+	return 0;
+}
+DM_TEST(dm_test_serial_puts, DM_TESTF_SCAN_FDT);
@@ -0,0 +1,116 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0+
+
+# This script times U-Boot's ext4 reads of large files and checks that
+# the data read back is correct.
+#
+# ext4fs_read_file() maps a whole extent at a time and coalesces each
+# physically contiguous run into a single device read. This benchmark
+# loads a 40 MB file stored in one extent, the same data fragmented
+# over a few hundred extents (which needs an extent tree of depth 1)
+# and a sparse file, so that regressions in either correctness or
+# throughput show up.
+#
+# To execute the test, simply run it from the U-Boot source root directory:
+#
+#    cd u-boot
+#    ./test/fs/ext4-read-bench.sh
+#
+# The image is built with mkfs.ext4 -d and debugfs, so no root access is
+# needed. The throughput of each load is printed by U-Boot itself, e.g.:
+#
+#    => load host 0:0 1000000 contig.bin
+#    41943040 bytes read in 10 ms (3.9 GiB/s)
+#    => crc32 1000000 $filesize 0
+#    crc32 for 01000000 ... 037fffff ==> 9372d3e6
+#    => if itest.l *0 != e6d37293; then echo FAILURE; else echo PASS; fi
+#    PASS
+#
+# All temporary files used by this script are created in ./sandbox, like
+# test/fs/fat-noncontig-test.sh does.
+
+odir=sandbox
+img=${odir}/ext4-read-bench.img
+src=${odir}/ext4-read-bench
+fill=/dev/urandom
+bigfn=${odir}/ext4-read-bench.big
+sparsefn=${odir}/ext4-read-bench.sparse
+crcaddr=0
+loadaddr=1000000
+
+for prereq in mkfs.ext4 debugfs dd truncate crc32; do
+    if [ ! -x "`which $prereq`" ]; then
+        echo "Missing $prereq binary. Exiting!"
+        exit 1
+    fi
+done
+
+make O=${odir} -s sandbox_defconfig && make O=${odir} -s -j8
+
+if [ ! -f ${img} ]; then
+    rm -rf ${src}
+    mkdir -p ${src}
+
+    # Interleave files to keep and files to delete, so that the holes
+    # left behind force the fragmented copy into many small extents.
+    for ((i = 1000; i < 1400; i++)); do
+        dd if=${fill} of=${src}/f${i}-a bs=4096 count=1 >/dev/null 2>&1
+        dd if=${fill} of=${src}/f${i}-b bs=4096 count=4 >/dev/null 2>&1
+    done
+
+    dd if=${fill} of=${bigfn} bs=1M count=40 >/dev/null 2>&1
+    cp ${bigfn} ${src}/contig.bin
+
+    rm -f ${sparsefn}
+    truncate -s 8M ${sparsefn}
+    echo -n hello | dd of=${sparsefn} bs=1 seek=5000000 conv=notrunc \
+        >/dev/null 2>&1
+    cp --sparse=always ${sparsefn} ${src}/sparse.bin
+
+    mkfs.ext4 -q -b 4096 -d ${src} ${img} 128M
+    if [ $? -ne 0 ]; then
+        echo Could not create ext4 filesystem
+        exit 1
+    fi
+
+    (for ((i = 1000; i < 1400; i++)); do
+        echo "rm f${i}-b"
+    done
+    echo "write ${bigfn} frag.bin") | debugfs -w ${img} >/dev/null 2>&1
+    if [ $? -ne 0 ]; then
+        echo Could not create fragmented file
+        exit 1
+    fi
+fi
+
+# crc32 prints the CRC big-endian, U-Boot stores it in memory order
+le_crc() {
+    local crc=0x`crc32 $1`
+
+    printf %02x%02x%02x%02x \
+        $((${crc} & 0xff)) \
+        $(((${crc} >> 8) & 0xff)) \
+        $(((${crc} >> 16) & 0xff)) \
+        $((${crc} >> 24))
+}
+
+bigcrc=`le_crc ${bigfn}`
+sparsecrc=`le_crc ${sparsefn}`
+
+./sandbox/u-boot << EOF
+host bind 0 ${img}
+load host 0:0 ${loadaddr} contig.bin
+crc32 ${loadaddr} \$filesize ${crcaddr}
+if itest.l *${crcaddr} != ${bigcrc}; then echo FAILURE; else echo PASS; fi
+load host 0:0 ${loadaddr} frag.bin
+crc32 ${loadaddr} \$filesize ${crcaddr}
+if itest.l *${crcaddr} != ${bigcrc}; then echo FAILURE; else echo PASS; fi
+load host 0:0 ${loadaddr} sparse.bin
+crc32 ${loadaddr} \$filesize ${crcaddr}
+if itest.l *${crcaddr} != ${sparsecrc}; then echo FAILURE; else echo PASS; fi
+reset
+EOF
+if [ $? -ne 0 ]; then
+    echo U-Boot exit status indicates an error
+    exit $?
+fi
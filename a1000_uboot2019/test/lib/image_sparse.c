@@ -0,0 +1,278 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for writing Android sparse images as they are received
+ */
+
+#include <common.h>
+#include <hexdump.h>
+#include <image-sparse.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define TEST_BLKSZ	512
+#define TEST_BLOCKS	32
+/* Block size of the sparse image, a multiple of TEST_BLKSZ */
+#define TEST_SPARSE_BLKSZ	1024
+#define TEST_FILL	0x12345a5a
+
+static u8 test_disk[TEST_BLOCKS * TEST_BLKSZ];
+
+/* Whether test_erase() can erase to zeroes, and the blocks it erased */
+static bool test_erase_zeroes;
+static lbaint_t test_erased;
+
+static lbaint_t test_write(struct sparse_storage *info, lbaint_t blk,
+			   lbaint_t blkcnt, const void *buffer)
+{
+	memcpy(test_disk + blk * TEST_BLKSZ, buffer, blkcnt * TEST_BLKSZ);
+
+	return blkcnt;
+}
+
+static lbaint_t test_reserve(struct sparse_storage *info, lbaint_t blk,
+			     lbaint_t blkcnt)
+{
+	return blkcnt;
+}
+
+static lbaint_t test_erase(struct sparse_storage *info, lbaint_t blk,
+			   lbaint_t blkcnt, bool zero)
+{
+	if (zero && !test_erase_zeroes)
+		return 0;
+
+	memset(test_disk + blk * TEST_BLKSZ, zero ? 0 : 0xdd,
+	       blkcnt * TEST_BLKSZ);
+	test_erased += blkcnt;
+
+	return blkcnt;
+}
+
+static u8 *add_chunk(u8 *p, u16 type, u32 blocks, u32 data_sz)
+{
+	chunk_header_t chunk = {
+		.chunk_type = type,
+		.chunk_sz = blocks,
+		.total_sz = sizeof(chunk) + data_sz,
+	};
+
+	memcpy(p, &chunk, sizeof(chunk));
+
+	return p + sizeof(chunk);
+}
+
+/*
+ * Build a sparse image of a raw chunk of two blocks, a fill chunk, a don't
+ * care chunk, a CRC32 chunk and a raw chunk of one block, and the disk
+ * contents it should result in.
+ */
+static u32 make_sparse_image(u8 *image, u8 *expect)
+{
+	sparse_header_t header = {
+		.magic = SPARSE_HEADER_MAGIC,
+		.major_version = 1,
+		.file_hdr_sz = sizeof(header),
+		.chunk_hdr_sz = sizeof(chunk_header_t),
+		.blk_sz = TEST_SPARSE_BLKSZ,
+		.total_blks = 5,
+		.total_chunks = 5,
+	};
+	u32 fill = TEST_FILL;
+	u8 *p = image;
+	int i;
+
+	memcpy(p, &header, sizeof(header));
+	p += sizeof(header);
+
+	p = add_chunk(p, CHUNK_TYPE_RAW, 2, 2 * TEST_SPARSE_BLKSZ);
+	for (i = 0; i < 2 * TEST_SPARSE_BLKSZ; i++)
+		*p++ = i * 7 + 3;
+	memcpy(expect, p - 2 * TEST_SPARSE_BLKSZ, 2 * TEST_SPARSE_BLKSZ);
+	expect += 2 * TEST_SPARSE_BLKSZ;
+
+	p = add_chunk(p, CHUNK_TYPE_FILL, 1, sizeof(fill));
+	memcpy(p, &fill, sizeof(fill));
+	p += sizeof(fill);
+	for (i = 0; i < TEST_SPARSE_BLKSZ; i += sizeof(fill))
+		memcpy(expect + i, &fill, sizeof(fill));
+	expect += TEST_SPARSE_BLKSZ;
+
+	p = add_chunk(p, CHUNK_TYPE_DONT_CARE, 1, 0);
+	/* the disk keeps what it had */
+	expect += TEST_SPARSE_BLKSZ;
+
+	p = add_chunk(p, CHUNK_TYPE_CRC32, 0, sizeof(u32));
+	memset(p, 0xcc, sizeof(u32));
+	p += sizeof(u32);
+
+	p = add_chunk(p, CHUNK_TYPE_RAW, 1, TEST_SPARSE_BLKSZ);
+	for (i = 0; i < TEST_SPARSE_BLKSZ; i++)
+		*p++ = i ^ 0x55;
+	memcpy(expect, p - TEST_SPARSE_BLKSZ, TEST_SPARSE_BLKSZ);
+
+	return p - image;
+}
+
+/* Write @image to test_disk in pieces of @piece bytes */
+static int stream_image(struct unit_test_state *uts, const u8 *image,
+			u32 size, u32 piece, lbaint_t blocks, bool erase)
+{
+	struct sparse_storage info = {
+		.blksz = TEST_BLKSZ,
+		.start = 0,
+		.size = blocks,
+		.write = test_write,
+		.reserve = test_reserve,
+		.erase = erase ? test_erase : NULL,
+	};
+	struct sparse_stream *ss;
+	char response[65];
+	u32 pos, len;
+	int ret;
+
+	ss = memalign(ARCH_DMA_MINALIGN, sizeof(*ss));
+	ut_assertnonnull(ss);
+	memset(test_disk, 0xee, sizeof(test_disk));
+	test_erased = 0;
+	ut_assertok(sparse_stream_init(ss, &info, response));
+
+	ret = 0;
+	for (pos = 0; !ret && pos < size; pos += len) {
+		len = min(piece, size - pos);
+		ret = sparse_stream_write(ss, image + pos, len, response);
+	}
+	if (!ret)
+		ret = sparse_stream_finish(ss, "test", response);
+	free(ss);
+
+	return ret;
+}
+
+static int lib_test_sparse_stream(struct unit_test_state *uts)
+{
+	static const u32 pieces[] = { 1, 3, 12, 511, 512, 1000, 0x10000 };
+	u8 *image, *expect;
+	u32 size;
+	int i;
+
+	image = malloc(8 * TEST_SPARSE_BLKSZ);
+	expect = malloc(sizeof(test_disk));
+	ut_assertnonnull(image);
+	ut_assertnonnull(expect);
+	memset(expect, 0xee, sizeof(test_disk));
+	size = make_sparse_image(image, expect);
+
+	for (i = 0; i < ARRAY_SIZE(pieces); i++) {
+		ut_assertok(stream_image(uts, image, size, pieces[i],
+					 TEST_BLOCKS, false));
+		ut_asserteq_mem(expect, test_disk, sizeof(test_disk));
+	}
+
+	/* the image needs 10 blocks */
+	ut_asserteq(-1, stream_image(uts, image, size, 100, 9, false));
+	/* and all of its chunks */
+	ut_asserteq(-1, stream_image(uts, image, size - 1, 100, TEST_BLOCKS,
+				     false));
+
+	free(expect);
+	free(image);
+
+	return 0;
+}
+LIB_TEST(lib_test_sparse_stream, 0);
+
+static int lib_test_sparse_stream_raw(struct unit_test_state *uts)
+{
+	static const u32 pieces[] = { 1, 10, 512, 0x10000 };
+	const u32 size = 3 * TEST_BLKSZ + 100;
+	u8 *image;
+	int i;
+
+	image = malloc(size);
+	ut_assertnonnull(image);
+	for (i = 0; i < size; i++)
+		image[i] = i * 13;
+
+	for (i = 0; i < ARRAY_SIZE(pieces); i++) {
+		ut_assertok(stream_image(uts, image, size, pieces[i],
+					 TEST_BLOCKS, false));
+		ut_asserteq_mem(image, test_disk, size);
+		/* the last block is padded with zeroes */
+		ut_asserteq(0, test_disk[size]);
+		ut_asserteq(0, test_disk[4 * TEST_BLKSZ - 1]);
+		ut_asserteq(0xee, test_disk[4 * TEST_BLKSZ]);
+	}
+
+	/* shorter than a sparse header */
+	ut_assertok(stream_image(uts, image, 10, 3, TEST_BLOCKS, false));
+	ut_asserteq_mem(image, test_disk, 10);
+	ut_asserteq(0, test_disk[10]);
+
+	ut_asserteq(-1, stream_image(uts, image, size, 512, 3, false));
+
+	free(image);
+
+	return 0;
+}
+LIB_TEST(lib_test_sparse_stream_raw, 0);
+
+/* Zero fills and don't care chunks are erased when the storage can */
+static int lib_test_sparse_stream_erase(struct unit_test_state *uts)
+{
+	sparse_header_t header = {
+		.magic = SPARSE_HEADER_MAGIC,
+		.major_version = 1,
+		.file_hdr_sz = sizeof(header),
+		.chunk_hdr_sz = sizeof(chunk_header_t),
+		.blk_sz = TEST_SPARSE_BLKSZ,
+		.total_blks = 5,
+		.total_chunks = 4,
+	};
+	u8 *image, *expect, *p;
+	u32 fill = 0;
+	u32 size;
+	int i;
+
+	image = malloc(4 * TEST_SPARSE_BLKSZ);
+	expect = malloc(sizeof(test_disk));
+	ut_assertnonnull(image);
+	ut_assertnonnull(expect);
+
+	p = image;
+	memcpy(p, &header, sizeof(header));
+	p += sizeof(header);
+	p = add_chunk(p, CHUNK_TYPE_DONT_CARE, 1, 0);
+	p = add_chunk(p, CHUNK_TYPE_FILL, 2, sizeof(fill));
+	memcpy(p, &fill, sizeof(fill));
+	p += sizeof(fill);
+	p = add_chunk(p, CHUNK_TYPE_DONT_CARE, 1, 0);
+	p = add_chunk(p, CHUNK_TYPE_RAW, 1, TEST_SPARSE_BLKSZ);
+	for (i = 0; i < TEST_SPARSE_BLKSZ; i++)
+		*p++ = i;
+	size = p - image;
+
+	/* the leading don't care chunk is kept, the other one discarded */
+	memset(expect, 0xee, sizeof(test_disk));
+	memset(expect + TEST_SPARSE_BLKSZ, 0, 2 * TEST_SPARSE_BLKSZ);
+	memset(expect + 3 * TEST_SPARSE_BLKSZ, 0xdd, TEST_SPARSE_BLKSZ);
+	memcpy(expect + 4 * TEST_SPARSE_BLKSZ, p - TEST_SPARSE_BLKSZ,
+	       TEST_SPARSE_BLKSZ);
+
+	test_erase_zeroes = true;
+	ut_assertok(stream_image(uts, image, size, 100, TEST_BLOCKS, true));
+	ut_asserteq_mem(expect, test_disk, sizeof(test_disk));
+	ut_asserteq(6, test_erased);
+
+	/* the fill is written if erased blocks do not read back as zero */
+	test_erase_zeroes = false;
+	ut_assertok(stream_image(uts, image, size, 100, TEST_BLOCKS, true));
+	ut_asserteq_mem(expect, test_disk, sizeof(test_disk));
+	ut_asserteq(2, test_erased);
+
+	free(expect);
+	free(image);
+
+	return 0;
+}
+LIB_TEST(lib_test_sparse_stream_erase, 0);
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the memory test engine, using simulated RAM faults
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <memtest.h>
+#include <smp_work.h>
+#include <asm/test.h>
+#include <linux/sizes.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define TEST_SIZE	(SZ_4M + SZ_4K)
+
+static int lib_test_memtest(struct unit_test_state *uts)
+{
+	struct memtest_result res;
+	ulong addr, fault;
+	void *buf;
+
+	buf = memalign(MEMTEST_LINE_SIZE, TEST_SIZE);
+	ut_assertnonnull(buf);
+	addr = map_to_sysmem(buf);
+	sandbox_memtest_clear_faults();
+
+	/* Good memory passes every test */
+	ut_assertok(memtest_run(addr, TEST_SIZE, MEMTEST_ALL | MEMTEST_ZVA,
+				&res));
+	ut_asserteq(0, res.errors);
+	ut_asserteq(0, res.nfails);
+	ut_asserteq(TEST_SIZE * 9, res.bytes);
+#ifdef CONFIG_SMP_WORK
+	ut_asserteq(CONFIG_SMP_WORK_MAX_CPUS, res.cpus);
+#endif
+
+	/* A bit stuck at 0 fails when reading back the MATS+ ones */
+	fault = addr + 0x1238;
+	ut_assertok(sandbox_memtest_add_fault(fault, BIT(5), 0));
+	ut_assertok(memtest_run(addr, TEST_SIZE, MEMTEST_MATS, &res));
+	ut_asserteq(1, res.errors);
+	ut_asserteq(1, res.nfails);
+	ut_asserteq_ptr((void *)fault, (void *)res.fail[0].addr);
+	ut_assert(res.fail[0].expect == ~0ULL);
+	ut_assert(res.fail[0].actual == ~(u64)BIT(5));
+
+	/* ...and when its address has that bit set, but not the inverse */
+	ut_assertok(memtest_run(addr, TEST_SIZE, MEMTEST_ADDR, &res));
+	ut_asserteq(1, res.errors);
+	ut_asserteq_ptr((void *)fault, (void *)res.fail[0].addr);
+	ut_assert(res.fail[0].expect == fault);
+	ut_assert(res.fail[0].actual == (fault & ~BIT(5)));
+
+	/* The bus walk only uses word 0 and power-of-two offsets */
+	ut_assertok(memtest_run(addr, TEST_SIZE, MEMTEST_WALK, &res));
+	ut_asserteq(0, res.errors);
+
+	/* A data line stuck at 1 fails all walking ones but its own */
+	sandbox_memtest_clear_faults();
+	ut_assertok(sandbox_memtest_add_fault(addr, BIT(3), BIT(3)));
+	ut_assertok(memtest_run(addr, TEST_SIZE, MEMTEST_WALK, &res));
+	ut_asserteq(64, res.errors);
+	ut_asserteq(MEMTEST_MAX_FAILS, res.nfails);
+	ut_asserteq_ptr((void *)addr, (void *)res.fail[0].addr);
+	ut_assert(res.fail[0].actual == (BIT(0) | BIT(3)));
+
+	/* Regions must be made of whole lines */
+	ut_asserteq(-EINVAL, memtest_run(addr + 8, TEST_SIZE - MEMTEST_LINE_SIZE,
+					 MEMTEST_ALL, &res));
+
+	sandbox_memtest_clear_faults();
+	free(buf);
+	smp_work_stop();
+
+	return 0;
+}
+LIB_TEST(lib_test_memtest, 0);
@@ -0,0 +1,242 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests and benchmark for RSA modular exponentiation in software
+ *
+ * The moduli are random odd numbers, which is all that Montgomery
+ * multiplication needs, and the results are checked against a slow
+ * shift-and-add implementation. Run 'ut lib lib_test_rsa_mod_exp_bench' on
+ * sandbox started with -v to see the time taken by each signature check.
+ */
+
+#include <common.h>
+#include <hexdump.h>
+#include <malloc.h>
+#include <asm/unaligned.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/rsa.h>
+#include <u-boot/rsa-mod-exp.h>
+
+#define MAX_WORDS	(RSA_MAX_KEY_BITS / 32)
+#define BENCH_RUNS	20
+
+/* All numbers are little endian arrays of 32-bit words */
+struct test_key {
+	uint words;
+	u32 n[MAX_WORDS];
+	u8 modulus[RSA_MAX_KEY_BITS / 8];
+	u8 rr[RSA_MAX_KEY_BITS / 8];
+	u64 exponent;
+	struct key_prop prop;
+};
+
+static u32 test_rand(u32 *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+
+	return *state;
+}
+
+static void to_be(u8 *dst, const u32 *src, uint words)
+{
+	uint i;
+
+	for (i = 0; i < words; i++)
+		put_unaligned_be32(src[i], dst + (words - 1 - i) * 4);
+}
+
+static int ref_cmp(const u32 *a, const u32 *b, uint words)
+{
+	int i;
+
+	for (i = words - 1; i >= 0; i--) {
+		if (a[i] != b[i])
+			return a[i] < b[i] ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/* a = a + b mod n, where a, b < n */
+static void ref_add_mod(u32 *a, const u32 *b, const u32 *n, uint words)
+{
+	u64 acc = 0;
+	s64 sub = 0;
+	uint i;
+
+	for (i = 0; i < words; i++) {
+		acc += (u64)a[i] + b[i];
+		a[i] = acc;
+		acc >>= 32;
+	}
+	if (!acc && ref_cmp(a, n, words) < 0)
+		return;
+	for (i = 0; i < words; i++) {
+		sub += (u64)a[i] - n[i];
+		a[i] = sub;
+		sub >>= 32;
+	}
+}
+
+/* res = a * b mod n, one bit of a at a time */
+static void ref_mul_mod(u32 *res, const u32 *a, const u32 *b, const u32 *n,
+			uint words)
+{
+	int bit;
+
+	memset(res, '\0', words * sizeof(u32));
+	for (bit = words * 32 - 1; bit >= 0; bit--) {
+		ref_add_mod(res, res, n, words);
+		if (a[bit / 32] & (1U << (bit % 32)))
+			ref_add_mod(res, b, n, words);
+	}
+}
+
+static void ref_pow_mod(u32 *res, const u32 *s, u64 exponent, const u32 *n,
+			uint words)
+{
+	u32 tmp[MAX_WORDS];
+	int bit = 63;
+
+	while (!(exponent & (1ULL << bit)))
+		bit--;
+	memcpy(res, s, words * sizeof(u32));
+	for (bit--; bit >= 0; bit--) {
+		ref_mul_mod(tmp, res, res, n, words);
+		if (exponent & (1ULL << bit))
+			ref_mul_mod(res, tmp, s, n, words);
+		else
+			memcpy(res, tmp, words * sizeof(u32));
+	}
+}
+
+/* Set up a key as mkimage would put it in the device tree */
+static void make_key(struct test_key *key, uint bits, u64 exponent, u32 *seed)
+{
+	u32 rr[MAX_WORDS], inv;
+	uint i;
+
+	key->words = bits / 32;
+	for (i = 0; i < key->words; i++)
+		key->n[i] = test_rand(seed);
+	key->n[0] |= 1;
+	key->n[key->words - 1] |= 1U << 31;
+
+	/* R^2 mod n, with R = 2^bits */
+	memset(rr, '\0', sizeof(rr));
+	rr[0] = 1;
+	for (i = 0; i < bits * 2; i++)
+		ref_add_mod(rr, rr, key->n, key->words);
+
+	/* Each Newton step doubles the number of bits right, from 3 */
+	inv = key->n[0];
+	for (i = 0; i < 4; i++)
+		inv *= 2 - key->n[0] * inv;
+
+	to_be(key->modulus, key->n, key->words);
+	to_be(key->rr, rr, key->words);
+	key->exponent = cpu_to_be64(exponent);
+	key->prop.modulus = key->modulus;
+	key->prop.rr = key->rr;
+	key->prop.public_exponent = &key->exponent;
+	key->prop.n0inv = -inv;
+	key->prop.num_bits = bits;
+	key->prop.exp_len = sizeof(key->exponent);
+}
+
+/* A random signature, below the modulus */
+static void make_sig(struct test_key *key, u32 *s, u8 *sig, u32 *seed)
+{
+	uint i;
+
+	for (i = 0; i < key->words; i++)
+		s[i] = test_rand(seed);
+	s[key->words - 1] = key->n[key->words - 1] >> 1;
+	to_be(sig, s, key->words);
+}
+
+static int check_mod_exp(struct unit_test_state *uts, uint bits, u64 exponent)
+{
+	u32 s[MAX_WORDS], expect[MAX_WORDS];
+	u8 sig[RSA_MAX_KEY_BITS / 8], out[RSA_MAX_KEY_BITS / 8];
+	u8 want[RSA_MAX_KEY_BITS / 8];
+	struct test_key *key;
+	u32 seed = bits ^ (u32)exponent;
+
+	key = calloc(1, sizeof(*key));
+	ut_assertnonnull(key);
+	make_key(key, bits, exponent, &seed);
+	make_sig(key, s, sig, &seed);
+
+	ut_assertok(rsa_mod_exp_sw(sig, bits / 8, &key->prop, out));
+	ref_pow_mod(expect, s, exponent, key->n, key->words);
+	to_be(want, expect, key->words);
+	ut_asserteq_mem(want, out, bits / 8);
+	free(key);
+
+	return 0;
+}
+
+static int lib_test_rsa_mod_exp(struct unit_test_state *uts)
+{
+	u8 sig[RSA2048_BYTES], out[RSA2048_BYTES];
+	u32 s[MAX_WORDS];
+	struct test_key *key;
+	u32 seed = 1;
+
+	/* Sparse and dense exponents, and a modulus of an odd word count */
+	ut_assertok(check_mod_exp(uts, 2048, 3));
+	ut_assertok(check_mod_exp(uts, 2048, 65537));
+	ut_assertok(check_mod_exp(uts, 2048, 0xfedcba9876543211ULL));
+	ut_assertok(check_mod_exp(uts, 2080, 65537));
+	ut_assertok(check_mod_exp(uts, 4096, 65537));
+	ut_assertok(check_mod_exp(uts, 4096, 0xfffffffffffffffdULL));
+
+	/* An even exponent cannot be used */
+	key = calloc(1, sizeof(*key));
+	ut_assertnonnull(key);
+	make_key(key, 2048, 65536, &seed);
+	make_sig(key, s, sig, &seed);
+	ut_asserteq(-EINVAL, rsa_mod_exp_sw(sig, sizeof(sig), &key->prop, out));
+	free(key);
+
+	return 0;
+}
+LIB_TEST(lib_test_rsa_mod_exp, 0);
+
+static int bench_mod_exp(struct unit_test_state *uts, uint bits)
+{
+	u8 sig[RSA_MAX_KEY_BITS / 8], out[RSA_MAX_KEY_BITS / 8];
+	u32 s[MAX_WORDS];
+	struct test_key *key;
+	u32 seed = bits;
+	ulong start, us;
+	int i;
+
+	key = calloc(1, sizeof(*key));
+	ut_assertnonnull(key);
+	make_key(key, bits, 65537, &seed);
+	make_sig(key, s, sig, &seed);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_RUNS; i++)
+		ut_assertok(rsa_mod_exp_sw(sig, bits / 8, &key->prop, out));
+	us = timer_get_us() - start;
+	free(key);
+
+	printf("RSA-%u: %lu us per signature\n", bits, us / BENCH_RUNS);
+
+	return 0;
+}
+
+static int lib_test_rsa_mod_exp_bench(struct unit_test_state *uts)
+{
+	ut_assertok(bench_mod_exp(uts, 2048));
+	ut_assertok(bench_mod_exp(uts, 4096));
+
+	return 0;
+}
+LIB_TEST(lib_test_rsa_mod_exp_bench, 0);
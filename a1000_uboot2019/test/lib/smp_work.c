@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for running work on the secondary CPUs
+ */
+
+#include <common.h>
+#include <smp_work.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define TEST_ITEMS	1000
+
+static u8 test_runs[TEST_ITEMS];
+
+static void test_item(void *priv, uint item)
+{
+	u8 *runs = priv;
+
+	runs[item]++;
+}
+
+/* Each item is run exactly once, by one of all the CPUs */
+static int lib_test_smp_work(struct unit_test_state *uts)
+{
+	static const uint counts[] = { 0, 1, 2, 7, TEST_ITEMS };
+	int i, item;
+
+	for (i = 0; i < ARRAY_SIZE(counts); i++) {
+		memset(test_runs, '\0', sizeof(test_runs));
+		ut_assert(smp_work_run(test_item, test_runs, counts[i]) >= 1);
+		for (item = 0; item < TEST_ITEMS; item++)
+			ut_asserteq(item < counts[i], test_runs[item]);
+	}
+
+	/* sandbox has a thread for each CPU */
+	ut_asserteq(CONFIG_SMP_WORK_MAX_CPUS,
+		    smp_work_run(test_item, test_runs, TEST_ITEMS));
+
+	/* the CPUs are started again after being parked */
+	smp_work_stop();
+	memset(test_runs, '\0', sizeof(test_runs));
+	ut_asserteq(CONFIG_SMP_WORK_MAX_CPUS,
+		    smp_work_run(test_item, test_runs, TEST_ITEMS));
+	for (item = 0; item < TEST_ITEMS; item++)
+		ut_asserteq(1, test_runs[item]);
+	smp_work_stop();
+
+	return 0;
+}
+LIB_TEST(lib_test_smp_work, 0);
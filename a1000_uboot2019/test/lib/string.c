@@ -11,6 +11,10 @@
 
 #include <common.h>
 #include <command.h>
+#include <malloc.h>
+#include <div64.h>
+#include <linux/kernel.h>
+#include <linux/sizes.h>
 #include <test/lib.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -192,3 +196,182 @@ static int lib_memmove(struct unit_test_state *uts)
 }
 
 LIB_TEST(lib_memmove, 0);
+
+/* Lengths which take the bulk copy paths of the optimised versions */
+#define BIG_BUFLEN (SWEEP + 257)
+
+/**
+ * lib_memcpy_big() - unit test for memcpy() and memmove() of larger regions
+ *
+ * Test memcpy() and overlapping memmove() with varied alignment and lengths
+ * of up to 256 bytes.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_memcpy_big(struct unit_test_state *uts)
+{
+	u8 buf1[2 * BIG_BUFLEN];
+	u8 buf2[2 * BIG_BUFLEN];
+	int offset1, offset2, len, i;
+
+	for (i = 0; i < sizeof(buf1); ++i)
+		buf1[i] = i ^ (i >> 8) ^ MASK;
+
+	for (offset1 = 0; offset1 <= SWEEP; ++offset1) {
+		for (offset2 = 0; offset2 <= SWEEP; ++offset2) {
+			for (len = 33; len < BIG_BUFLEN - SWEEP; ++len) {
+				/* Separate regions */
+				memset(buf2, 0, sizeof(buf2));
+				ut_asserteq_ptr(buf2 + offset2,
+						memcpy(buf2 + offset2,
+						       buf1 + offset1, len));
+				ut_assertok(memcmp(buf2 + offset2,
+						   buf1 + offset1, len));
+				for (i = 0; i < sizeof(buf2); ++i)
+					if (i < offset2 || i >= offset2 + len)
+						ut_asserteq(0, buf2[i]);
+
+				/* Destination overlapping the source */
+				memcpy(buf2, buf1, sizeof(buf2));
+				ut_asserteq_ptr(buf2 + offset2,
+						memmove(buf2 + offset2,
+							buf2 + offset1, len));
+				ut_assertok(memcmp(buf2 + offset2,
+						   buf1 + offset1, len));
+			}
+		}
+	}
+	return 0;
+}
+
+LIB_TEST(lib_memcpy_big, 0);
+
+/**
+ * lib_memcmp() - unit test for memcmp()
+ *
+ * Test memcmp() with varied alignment and length of the compared buffers and
+ * the position of the first difference.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_memcmp(struct unit_test_state *uts)
+{
+	u8 buf1[BIG_BUFLEN];
+	u8 buf2[BIG_BUFLEN];
+	int offset1, offset2, len, pos, sign, i;
+
+	for (i = 0; i < sizeof(buf1); ++i)
+		buf1[i] = i ^ MASK;
+	for (offset1 = 0; offset1 <= SWEEP; ++offset1) {
+		for (offset2 = 0; offset2 <= SWEEP; offset2 += 3) {
+			for (len = 0; len <= 80; ++len) {
+				memcpy(buf2 + offset2, buf1 + offset1, len);
+				ut_asserteq(0, memcmp(buf1 + offset1,
+						      buf2 + offset2, len));
+				for (pos = 0; pos < len; ++pos) {
+					/* Bytes are compared as unsigned char */
+					buf2[offset2 + pos] ^= 0x80;
+					sign = buf1[offset1 + pos] & 0x80 ? 1 : -1;
+					ut_assert(sign * memcmp(buf1 + offset1,
+								buf2 + offset2,
+								len) > 0);
+					buf2[offset2 + pos] ^= 0x80;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+LIB_TEST(lib_memcmp, 0);
+
+/* Size and repeat count of the regions used by the throughput benchmark */
+#define BENCH_SIZE	SZ_1M
+#define BENCH_LOOPS	16
+
+/**
+ * bench_show() - print the throughput of a benchmark run
+ *
+ * @name:	name of the function and case measured
+ * @start:	value of timer_get_us() at the start of the run
+ * @bytes:	number of bytes processed
+ */
+static void bench_show(const char *name, ulong start, u64 bytes)
+{
+	ulong us = timer_get_us() - start;
+
+	printf("%-24s %8lu us %8llu MB/s\n", name, us,
+	       us ? lldiv(bytes, us) : 0ULL);
+}
+
+/**
+ * lib_mem_bench() - throughput benchmark of the memory functions
+ *
+ * Time memcpy(), memmove(), memset() and memcmp() on aligned and unaligned
+ * regions of 1 MiB and on short copies, and print the results. This does not
+ * fail on low throughput, it is meant to compare implementations.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_mem_bench(struct unit_test_state *uts)
+{
+	void *sbuf, *dbuf;
+	u8 *src, *dst;
+	ulong start;
+	int i, j, ret;
+
+	sbuf = malloc(BENCH_SIZE + 64);
+	ut_assertnonnull(sbuf);
+	dbuf = malloc(BENCH_SIZE + 64);
+	if (!dbuf) {
+		free(sbuf);
+		return CMD_RET_FAILURE;
+	}
+	src = PTR_ALIGN(sbuf, 16);
+	dst = PTR_ALIGN(dbuf, 16);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		memset(src, i, BENCH_SIZE);
+	bench_show("memset", start, (u64)BENCH_LOOPS * BENCH_SIZE);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		memcpy(dst, src, BENCH_SIZE);
+	bench_show("memcpy aligned", start, (u64)BENCH_LOOPS * BENCH_SIZE);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		memcpy(dst + 1, src + 3, BENCH_SIZE);
+	bench_show("memcpy unaligned", start, (u64)BENCH_LOOPS * BENCH_SIZE);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		for (j = 0; j < BENCH_SIZE; j += 64)
+			memcpy(dst + j, src + j, 64);
+	bench_show("memcpy 64 bytes", start, (u64)BENCH_LOOPS * BENCH_SIZE);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		memmove(dst + 32, dst, BENCH_SIZE - 32);
+	bench_show("memmove overlapping", start,
+		   (u64)BENCH_LOOPS * (BENCH_SIZE - 32));
+
+	memcpy(dst, src, BENCH_SIZE);
+	ret = 0;
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		ret |= memcmp(dst, src, BENCH_SIZE);
+	bench_show("memcmp", start, (u64)BENCH_LOOPS * BENCH_SIZE);
+
+	free(dbuf);
+	free(sbuf);
+	ut_asserteq(0, ret);
+
+	return 0;
+}
+
+LIB_TEST(lib_mem_bench, 0);
@@ -0,0 +1,47 @@
+# SPDX-License-Identifier: GPL-2.0
+
+# Test U-Boot's "mmc bench" command. The test times a multi-block read from
+# the emulated sandbox MMC device and checks that a throughput figure is
+# reported and that the data landed at the given address.
+
+import pytest
+import re
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_mmc_bench')
+def test_mmc_bench_read(u_boot_console):
+    """Test the "mmc bench read" command."""
+
+    cons = u_boot_console
+    addr = '0x1000000'
+
+    response = cons.run_command('mmc dev 0')
+    assert 'mmc0 is current device' in response
+
+    response = cons.run_command('mmc bench read %s 0 0x800' % addr)
+    assert re.search(r'2048 blocks read in \d+\.\d{6} s: \d+\.\d{2} MiB/s',
+                     response)
+
+    # The sandbox emulator returns a fixed string for multi-block reads
+    response = cons.run_command('md.b %s 0xe' % addr)
+    assert 'this is a test' in response
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_mmc_bench')
+@pytest.mark.buildconfigspec('mmc_write')
+def test_mmc_bench_write(u_boot_console):
+    """Test the "mmc bench write" command."""
+
+    cons = u_boot_console
+    addr = '0x1000000'
+
+    response = cons.run_command('mmc dev 0')
+    assert 'mmc0 is current device' in response
+
+    response = cons.run_command('mmc bench write %s 0 0x800' % addr)
+    assert re.search(r'2048 blocks written in \d+\.\d{6} s: \d+\.\d{2} MiB/s',
+                     response)
+
+    # The emulated device is an SD card, which has no write cache
+    response = cons.run_command('mmc cache')
+    assert 'No write cache on device' in response
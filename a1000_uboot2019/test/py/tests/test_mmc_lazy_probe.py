@@ -0,0 +1,23 @@
+# SPDX-License-Identifier: GPL-2.0
+
+# Test that the "mmc" commands work straight after boot when
+# CONFIG_DM_LAZY_PROBE leaves the MMC devices unprobed during init.
+
+import pytest
+
+@pytest.mark.buildconfigspec('dm_lazy_probe')
+@pytest.mark.buildconfigspec('cmd_mmc')
+def test_mmc_lazy_probe(u_boot_console):
+    """Test "mmc dev" and "mmc info" before anything has probed MMC."""
+
+    cons = u_boot_console
+    # Start from a fresh boot so that no earlier test has probed a device
+    cons.restart_uboot()
+
+    response = cons.run_command('mmc dev 0')
+    assert 'no mmc device' not in response
+    assert 'mmc0' in response and 'is current device' in response
+
+    response = cons.run_command('mmc info')
+    assert 'no mmc device' not in response
+    assert 'Bus Width' in response
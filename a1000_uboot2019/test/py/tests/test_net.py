@@ -47,6 +47,11 @@ env__net_tftp_readable_file = {
     'crc32': 'c2244b26',
 }
 
+# Window size to request (RFC 7440) when downloading
+# env__net_tftp_readable_file a second time. The windowed download is skipped
+# if this variable is omitted.
+env__net_tftp_windowsize = 16
+
 # Details regarding a file that may be read from a NFS server. This variable
 # may be omitted or set to None if NFS testing is not possible or desired.
 env__net_nfs_readable_file = {
@@ -167,6 +172,60 @@ def test_net_tftpboot(u_boot_console):
     output = u_boot_console.run_command('crc32 $fileaddr $filesize')
     assert expected_crc in output
 
+@pytest.mark.buildconfigspec('cmd_net')
+def test_net_tftpboot_windowsize(u_boot_console):
+    """Test the tftpboot command with a TFTP window size (RFC 7440).
+
+    The same file as test_net_tftpboot() is downloaded with the windowsize
+    option requested, and its size and optionally its CRC32 are validated.
+    The transfer rate printed by tftpboot can be compared between the two
+    tests.
+    """
+
+    if not net_set_up:
+        pytest.skip('Network not initialized')
+
+    f = u_boot_console.config.env.get('env__net_tftp_readable_file', None)
+    if not f:
+        pytest.skip('No TFTP readable file to read')
+
+    windowsize = u_boot_console.config.env.get('env__net_tftp_windowsize',
+                                               None)
+    if not windowsize:
+        pytest.skip('No TFTP window size to test')
+
+    addr = f.get('addr', None)
+
+    fn = f['fn']
+    u_boot_console.run_command('setenv tftpwindowsize %d' % windowsize)
+    try:
+        if not addr:
+            output = u_boot_console.run_command('tftpboot %s' % (fn))
+        else:
+            output = u_boot_console.run_command('tftpboot %x %s' % (addr, fn))
+    finally:
+        # tftp keeps the last window size until it is set again, so restore
+        # the default before dropping the variable
+        default = u_boot_console.config.buildconfig.get(
+            'config_tftp_windowsize', '1')
+        u_boot_console.run_command('setenv tftpwindowsize %s' % default)
+        u_boot_console.run_command('setenv tftpwindowsize')
+    expected_text = 'Bytes transferred = '
+    sz = f.get('size', None)
+    if sz:
+        expected_text += '%d' % sz
+    assert expected_text in output
+
+    expected_crc = f.get('crc32', None)
+    if not expected_crc:
+        return
+
+    if u_boot_console.config.buildconfig.get('config_cmd_crc32', 'n') != 'y':
+        return
+
+    output = u_boot_console.run_command('crc32 $fileaddr $filesize')
+    assert expected_crc in output
+
 @pytest.mark.buildconfigspec('cmd_nfs')
 def test_net_nfs(u_boot_console):
     """Test the nfs command.
@@ -210,7 +210,7 @@ class DtbPlatdata(object):
         Return:
             Number of argument cells is this is a phandle, else None
         """
-        if prop.name in ['clocks']:
+        if prop.name in ['clocks', 'resets']:
             if not isinstance(prop.value, list):
                 prop.value = [prop.value]
             val = prop.value
@@ -230,7 +230,10 @@ class DtbPlatdata(object):
                 if not target:
                     raise ValueError("Cannot parse '%s' in node '%s'" %
                                      (prop.name, node_name))
-                prop_name = '#clock-cells'
+                if prop.name == 'resets':
+                    prop_name = '#reset-cells'
+                else:
+                    prop_name = '#clock-cells'
                 cells = target.props.get(prop_name)
                 if not cells:
                     raise ValueError("Node '%s' has no '%s' property" %